@@ -8,6 +8,47 @@ namespace freetensor {
 using namespace pybind11::literals;
 
 void init_ffi_auto_schedule(py::module_ &m) {
+    py::class_<TuningRecord>(m, "TuningRecord")
+        .def(py::init<>())
+        .def_readwrite("workload", &TuningRecord::workload)
+        .def_readwrite("ast_hash", &TuningRecord::astHash)
+        .def_readwrite("target", &TuningRecord::target)
+        .def_readwrite("logs", &TuningRecord::logs)
+        .def_readwrite("features", &TuningRecord::features)
+        .def_readwrite("time", &TuningRecord::time)
+        .def_readwrite("ast", &TuningRecord::ast);
+    py::class_<TuningRecordDB, Ref<TuningRecordDB>>(m, "TuningRecordDB")
+        .def(py::init([](const std::string &path) {
+                 return Ref<TuningRecordDB>::make(path);
+             }),
+             "path"_a = "")
+        .def_property_readonly("path", &TuningRecordDB::path)
+        .def("append", &TuningRecordDB::append, "record"_a)
+        .def("reload", &TuningRecordDB::reload)
+        .def("query", &TuningRecordDB::query, "workload"_a, "limit"_a = 0)
+        .def("best", &TuningRecordDB::best, "workload"_a)
+        .def("__len__", &TuningRecordDB::size)
+        .def_static("workload_key", &TuningRecordDB::workloadKey, "ast"_a,
+                    "target"_a)
+        .def_static("target_key", &TuningRecordDB::targetKey, "target"_a);
+
+    py::class_<CostModel, Ref<CostModel>>(m, "CostModel")
+        .def(py::init([](int nTrees, int maxDepth, double learningRate,
+                         int minSamplesLeaf, double lambda, size_t maxSamples) {
+                 return Ref<CostModel>::make(nTrees, maxDepth, learningRate,
+                                             minSamplesLeaf, lambda,
+                                             maxSamples);
+             }),
+             "n_trees"_a = 50, "max_depth"_a = 6, "learning_rate"_a = 0.3,
+             "min_samples_leaf"_a = 2, "reg_lambda"_a = 1,
+             "max_samples"_a = 10000)
+        .def("predict", &CostModel::predict, "features"_a,
+             py::call_guard<py::gil_scoped_release>())
+        .def("update", &CostModel::update, "features"_a, "flops"_a,
+             py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("n_samples", &CostModel::nSamples)
+        .def_property_readonly("trained", &CostModel::trained);
+
     py::class_<Sketch>(m, "Sketch")
         .def("get_annotation", &Sketch::getAnnotation);
     py::class_<AutoSchedule>(m, "AutoSchedule")
@@ -25,8 +66,17 @@ void init_ffi_auto_schedule(py::module_ &m) {
              "verbose"_a = 0)
         .def("set_params", &AutoSchedule::setParams, "args"_a,
              "kws"_a = std::unordered_map<std::string, Ref<Array>>())
+        .def("set_measure_options", &AutoSchedule::setMeasureOptions,
+             "options"_a, "abort_ratio"_a = 2)
+        .def("set_measure_func", &AutoSchedule::setMeasureFunc,
+             "measure_func"_a)
+        .def("set_tuning_records", &AutoSchedule::setTuningRecords,
+             "records"_a, "warm_start"_a = true)
+        // Release the GIL while searching. Python callbacks, if any, acquire
+        // it by themselves
         .def("search_one_round", &AutoSchedule::searchOneRound, "n"_a,
-             "n_exploit"_a, "n_explore"_a)
+             "n_exploit"_a, "n_explore"_a,
+             py::call_guard<py::gil_scoped_release>())
         .def("gen_features", &AutoSchedule::genFeatures, "schedules"_a)
         .def("test_and_add", &AutoSchedule::testAndAdd, "sketches"_a)
         .def("get_best_schedule", &AutoSchedule::getBestSchedule)
@@ -8,9 +8,24 @@ namespace freetensor {
 using namespace pybind11::literals;
 
 void init_ffi_codegen(py::module_ &m) {
-    m.def("code_gen", &codeGen, "func"_a, "target"_a);
-    m.def("code_gen_cpu", &codeGenCPU, "func"_a);
+    m.def("code_gen",
+          static_cast<std::string (*)(const Func &, const Ref<Target> &)>(
+              &codeGen),
+          "func"_a, "target"_a);
+    m.def("code_gen",
+          static_cast<std::string (*)(const std::vector<Func> &,
+                                      const Ref<Target> &)>(&codeGen),
+          "funcs"_a, "target"_a);
+    m.def("code_gen_cpu",
+          static_cast<std::string (*)(const Func &, const Ref<CPUTarget> &)>(
+              &codeGenCPU),
+          "func"_a, "target"_a = nullptr);
+    m.def("code_gen_cpu",
+          static_cast<std::string (*)(const std::vector<Func> &,
+                                      const Ref<CPUTarget> &)>(&codeGenCPU),
+          "funcs"_a, "target"_a = nullptr);
     m.def("code_gen_cuda", &codeGenCUDA, "func"_a);
+    m.def("multi_kernel_entry", &multiKernelEntry, "i"_a, "func_name"_a);
 }
 
 } // namespace freetensor
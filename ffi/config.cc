@@ -1,7 +1,10 @@
 #include <config.h>
+#include <driver/array_allocator.h>
 #include <driver/device.h>
+#include <driver/kernel_cache.h>
 #include <driver/target.h>
 #include <ffi.h>
+#include <math/presburger.h>
 
 namespace freetensor {
 
@@ -76,6 +79,128 @@ void init_ffi_config(py::module_ &m) {
             return std::vector<std::string>(paths.begin(), paths.end());
         },
         "Backend compiler used to compile generated CUDA code");
+    m.def(
+        "set_kernel_cache_dir",
+        [](const std::string &path) { Config::setKernelCacheDir(path); },
+        "Set where to cache compiled kernels across processes. Empty to "
+        "disable the cache",
+        "path"_a);
+    m.def(
+        "kernel_cache_dir",
+        []() { return Config::kernelCacheDir().string(); },
+        "Directory to cache compiled kernels across processes");
+    m.def("set_kernel_cache_size", Config::setKernelCacheSize,
+          "Set the total size of the kernel cache in bytes, beyond which the "
+          "least recently used kernels are evicted. 0 for unlimited",
+          "bytes"_a);
+    m.def("kernel_cache_size", Config::kernelCacheSize,
+          "Total size limit of the kernel cache in bytes");
+    m.def("clear_kernel_cache", KernelCache::clear,
+          "Remove all compiled kernels in the kernel cache");
+    m.def("set_precompiled_header", Config::setPrecompiledHeader,
+          "Precompile the runtime header and keep it in the kernel cache, to "
+          "speed up compiling",
+          "flag"_a = true);
+    m.def("precompiled_header", Config::precompiledHeader,
+          "Check if using a precompiled runtime header");
+    m.def("set_compile_workers", Config::setCompileWorkers,
+          "Set the number of backend compilers to run in parallel. 0 for the "
+          "number of hardware threads. Only effective before the first "
+          "program is compiled",
+          "n"_a);
+    m.def("compile_workers", Config::compileWorkers,
+          "Number of backend compilers to run in parallel");
+    m.def("set_array_pool_size", Config::setArrayPoolSize,
+          "Set the maximum bytes of freed Array buffers on CPU cached for "
+          "reuse. 0 to disable caching",
+          "bytes"_a);
+    m.def("array_pool_size", Config::arrayPoolSize,
+          "Maximum bytes of freed Array buffers on CPU cached for reuse");
+    m.def("set_array_alignment", Config::setArrayAlignment,
+          "Set the alignment of Array buffers on CPU in bytes", "bytes"_a);
+    m.def("array_alignment", Config::arrayAlignment,
+          "Alignment of Array buffers on CPU in bytes");
+    m.def("set_array_huge_page", Config::setArrayHugePage,
+          "Back large Array buffers on CPU with transparent huge pages",
+          "flag"_a = true);
+    m.def("array_huge_page", Config::arrayHugePage,
+          "Check if backing large Array buffers with transparent huge pages");
+    m.def("set_array_numa_local", Config::setArrayNUMALocal,
+          "Place Array buffers on CPU on the NUMA node of the allocating "
+          "thread",
+          "flag"_a = true);
+    m.def("array_numa_local", Config::arrayNUMALocal,
+          "Check if placing Array buffers on the local NUMA node");
+    m.def(
+        "array_pool_stats",
+        []() {
+            auto stats = ArrayAllocator::cpu()->stats();
+            return py::dict("n_alloc"_a = stats.nAlloc_,
+                            "n_free"_a = stats.nFree_, "n_hit"_a = stats.nHit_,
+                            "n_miss"_a = stats.nMiss_,
+                            "bytes_in_use"_a = stats.bytesInUse_,
+                            "peak_bytes_in_use"_a = stats.peakBytesInUse_,
+                            "bytes_cached"_a = stats.bytesCached_);
+        },
+        "Counters of the allocator for Array buffers on CPU");
+    m.def(
+        "release_array_pool",
+        []() { ArrayAllocator::cpu()->releaseCache(); },
+        "Return all cached Array buffers on CPU to the system");
+    m.def("set_pb_memo_size", Config::setPBMemoSize,
+          "Set the maximum bytes of memoized results of Presburger operations. "
+          "0 to disable memoization",
+          "bytes"_a);
+    m.def("pb_memo_size", Config::pbMemoSize,
+          "Maximum bytes of memoized results of Presburger operations");
+    m.def(
+        "presburger_stats",
+        []() {
+            auto stats = pbStats();
+            return py::dict("n_ctx_alloc"_a = stats.nCtxAlloc_,
+                            "n_ctx_reuse"_a = stats.nCtxReuse_,
+                            "n_memo_hit"_a = stats.nMemoHit_,
+                            "n_memo_miss"_a = stats.nMemoMiss_,
+                            "n_memo_evict"_a = stats.nMemoEvict_,
+                            "memo_entries"_a = stats.memoEntries_,
+                            "memo_bytes"_a = stats.memoBytes_);
+        },
+        "Counters of the ISL context pools and the memoized Presburger "
+        "operations");
+    m.def("clear_pb_memo", PBMemo::clear,
+          "Drop all memoized results of Presburger operations");
+    m.def("set_memoized_schedules_size", Config::setMemoizedSchedulesSize,
+          "Set the maximum estimated bytes of memoized schedules of a "
+          "Schedule and its forks",
+          "bytes"_a);
+    m.def("memoized_schedules_size", Config::memoizedSchedulesSize,
+          "Maximum estimated bytes of memoized schedules of a Schedule and "
+          "its forks");
+    m.def("set_lower_cache_size", Config::setLowerCacheSize,
+          "Set the maximum bytes of lowered statements cached for incremental "
+          "lowering. 0 to lower programs as a whole",
+          "bytes"_a);
+    m.def("lower_cache_size", Config::lowerCacheSize,
+          "Maximum bytes of lowered statements cached for incremental "
+          "lowering");
+    m.def("set_z3_query_timeout", Config::setZ3QueryTimeout,
+          "Set the time limit of each query of Z3Simplify in ms. 0 for "
+          "unlimited",
+          "ms"_a);
+    m.def("z3_query_timeout", Config::z3QueryTimeout,
+          "Time limit of each query of Z3Simplify in ms");
+    m.def("set_z3_pass_budget", Config::setZ3PassBudget,
+          "Set the time limit of all queries of one Z3Simplify pass in ms. 0 "
+          "for unlimited",
+          "ms"_a);
+    m.def("z3_pass_budget", Config::z3PassBudget,
+          "Time limit of all queries of one Z3Simplify pass in ms");
+    m.def("set_z3_cache_size", Config::setZ3CacheSize,
+          "Set the maximum bytes of cached results of Z3Simplify queries. 0 "
+          "to disable caching",
+          "bytes"_a);
+    m.def("z3_cache_size", Config::z3CacheSize,
+          "Maximum bytes of cached results of Z3Simplify queries");
     m.def("set_default_target", Config::setDefaultTarget,
           "Set default target (internal implementation of `with Target`)",
           "target"_a);
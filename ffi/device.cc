@@ -28,7 +28,31 @@ void init_ffi_device(py::module_ &m) {
 
     py::class_<CPUTarget, Ref<CPUTarget>>(m, "CPUTarget", pyTarget)
         .def("set_use_native_arch", &CPUTarget::setUseNativeArch,
-             "use_native_arch"_a = true);
+             "use_native_arch"_a = true)
+        .def_property("l1_data_cache_size", &CPUTarget::l1DataCacheSize,
+                      &CPUTarget::setL1DataCacheSize)
+        .def_property("l2_cache_size", &CPUTarget::l2CacheSize,
+                      &CPUTarget::setL2CacheSize)
+        .def_property("l3_cache_size", &CPUTarget::l3CacheSize,
+                      &CPUTarget::setL3CacheSize)
+        .def_property("cache_line_size", &CPUTarget::cacheLineSize,
+                      &CPUTarget::setCacheLineSize)
+        .def_property("isa", &CPUTarget::isa, &CPUTarget::setISA)
+        .def_property_readonly("vector_bytes", &CPUTarget::vectorBytes)
+        .def_property_readonly("vector_registers",
+                               &CPUTarget::vectorRegisters)
+        .def_property("physical_cores", &CPUTarget::physicalCores,
+                      &CPUTarget::setPhysicalCores)
+        .def_property("threads_per_core", &CPUTarget::threadsPerCore,
+                      &CPUTarget::setThreadsPerCore)
+        .def_property("numa_nodes", &CPUTarget::numaNodes,
+                      &CPUTarget::setNUMANodes)
+        .def_property_readonly("hardware_threads",
+                               &CPUTarget::hardwareThreads)
+        .def_property("use_thread_pool", &CPUTarget::useThreadPool,
+                      &CPUTarget::setUseThreadPool)
+        .def_property("use_native_gemm", &CPUTarget::useNativeGEMM,
+                      &CPUTarget::setUseNativeGEMM);
 
 #ifdef FT_WITH_CUDA
     py::class_<GPUTarget, Ref<GPUTarget>>(m, "GPUTarget", pyTarget)
@@ -12,11 +12,45 @@ namespace freetensor {
 using namespace pybind11::literals;
 
 void init_ffi_driver(py::module_ &m) {
+    py::class_<BenchmarkOptions>(m, "BenchmarkOptions")
+        .def(py::init<>())
+        .def_readwrite("warmups", &BenchmarkOptions::warmups)
+        .def_readwrite("min_rounds", &BenchmarkOptions::minRounds)
+        .def_readwrite("max_rounds", &BenchmarkOptions::maxRounds)
+        .def_readwrite("target_rel_ci", &BenchmarkOptions::targetRelCI)
+        .def_readwrite("time_budget", &BenchmarkOptions::timeBudget)
+        .def_readwrite("flush_cache", &BenchmarkOptions::flushCache)
+        .def_readwrite("pin_cpu", &BenchmarkOptions::pinCPU)
+        .def_readwrite("abort_threshold", &BenchmarkOptions::abortThreshold)
+        .def_readwrite("reject_outliers", &BenchmarkOptions::rejectOutliers);
+    py::class_<BenchmarkResult>(m, "BenchmarkResult")
+        .def_readonly("samples", &BenchmarkResult::samples)
+        .def_readonly("avg", &BenchmarkResult::avg)
+        .def_readonly("stddev", &BenchmarkResult::stddev)
+        .def_readonly("n_outliers", &BenchmarkResult::nOutliers)
+        .def_readonly("aborted", &BenchmarkResult::aborted)
+        .def("percentile", &BenchmarkResult::percentile, "p"_a)
+        .def("median", &BenchmarkResult::median)
+        .def("min", &BenchmarkResult::min);
+
     py::class_<Driver, Ref<Driver>>(m, "Driver")
         .def(py::init<const Func &, const std::string &, const Ref<Device> &,
-                      bool>())
+                      bool, bool, const std::string &>())
         .def(py::init<const Func &, const std::string &, const Ref<Device> &,
-                      const Ref<Device> &, bool>())
+                      const Ref<Device> &, bool, bool, const std::string &>())
+        .def(py::init<const Func &, Driver &, const std::string &>())
+        // Load an exported program
+        .def(py::init(
+            [](const std::pair<const std::string &, const std::string &>
+                   &txt_data) { return std::apply(loadDriver, txt_data); }))
+        .def(py::init(&importDriver), "path"_a)
+        .def_property_readonly("func", &Driver::func)
+        .def_property_readonly("src", &Driver::src)
+        .def_property("num_threads", &Driver::numThreads,
+                      &Driver::setNumThreads)
+        .def("is_ready", &Driver::isReady)
+        // Compiling jobs run in C++ threads, so release the GIL while waiting
+        .def("wait", &Driver::wait, py::call_guard<py::gil_scoped_release>())
         .def("set_args",
              static_cast<void (Driver::*)(
                  const std::vector<Ref<Array>> &,
@@ -27,10 +61,14 @@ void init_ffi_driver(py::module_ &m) {
              static_cast<void (Driver::*)(
                  const std::unordered_map<std::string, Ref<Array>> &)>(
                  &Driver::setArgs))
+        .def("param_index", &Driver::paramIndex)
+        .def("set_arg", &Driver::setArg)
         .def("run", &Driver::run)
         .def("sync", &Driver::sync)
-        .def("collect_returns", &Driver::collectReturns)
-        .def("time", &Driver::time, "rounds"_a = 10, "warmpups"_a = 3);
+        .def("collect_returns", &Driver::collectReturns, "keep_args"_a = false)
+        .def("time", &Driver::time, "rounds"_a = 10, "warmpups"_a = 3)
+        .def("benchmark", &Driver::benchmark,
+             "options"_a = BenchmarkOptions());
 
     // Serialization
     m.def("load_target",
@@ -54,6 +92,11 @@ void init_ffi_driver(py::module_ &m) {
         auto &&[ret_meta, ret_data] = dumpArray(array_);
         return std::make_pair(ret_meta, py::bytes(ret_data));
     });
+    m.def("dump_driver", [](const Ref<Driver> &driver_) {
+        auto &&[ret_meta, ret_data] = dumpDriver(driver_);
+        return std::make_pair(ret_meta, py::bytes(ret_data));
+    });
+    m.def("export_driver", &exportDriver, "driver"_a, "path"_a);
 }
 
 } // namespace freetensor
@@ -3,6 +3,8 @@
 
 namespace freetensor {
 
+using namespace pybind11::literals;
+
 void init_ffi_parallel_scope(py::module_ &m) {
     py::class_<SerialScope>(m, "SerialScope")
         .def(py::init<>())
@@ -12,14 +14,46 @@ void init_ffi_parallel_scope(py::module_ &m) {
             return lhs == rhs;
         });
 
+    py::enum_<OpenMPScope::Schedule>(m, "OpenMPSchedule")
+        .value("Default", OpenMPScope::Default)
+        .value("Static", OpenMPScope::Static)
+        .value("Dynamic", OpenMPScope::Dynamic)
+        .value("Guided", OpenMPScope::Guided);
     py::class_<OpenMPScope>(m, "OpenMPScope")
         .def(py::init<>())
+        .def(py::init([](const std::string &schedule, int chunk,
+                         int numThreads) {
+                 return makeOpenMPScope(parseOpenMPSchedule(schedule), chunk,
+                                        numThreads);
+             }),
+             "schedule"_a = "default", "chunk"_a = 0, "num_threads"_a = 0)
+        .def_readwrite("schedule", &OpenMPScope::schedule_)
+        .def_property(
+            "chunk", [](const OpenMPScope &scope) { return scope.chunk_; },
+            [](OpenMPScope &scope, int chunk) {
+                scope = makeOpenMPScope(scope.schedule_, chunk,
+                                        scope.numThreads_);
+            })
+        .def_property(
+            "num_threads",
+            [](const OpenMPScope &scope) { return scope.numThreads_; },
+            [](OpenMPScope &scope, int numThreads) {
+                scope = makeOpenMPScope(scope.schedule_, scope.chunk_,
+                                        numThreads);
+            })
         .def("__str__",
              [](const OpenMPScope &scope) { return toString(scope); })
         .def("__eq__", [](const OpenMPScope &lhs, const OpenMPScope &rhs) {
             return lhs == rhs;
         });
 
+    py::class_<OpenMPTaskScope>(m, "OpenMPTaskScope")
+        .def(py::init<>())
+        .def("__str__",
+             [](const OpenMPTaskScope &scope) { return toString(scope); })
+        .def("__eq__", [](const OpenMPTaskScope &lhs,
+                          const OpenMPTaskScope &rhs) { return lhs == rhs; });
+
     py::class_<CUDAStreamScope>(m, "CUDAStreamScope")
         .def(py::init<>())
         .def("__str__",
@@ -46,6 +80,10 @@ void init_ffi_parallel_scope(py::module_ &m) {
 
     // Factory function, used as a class
     m.def("ParallelScope", &parseParallelScope);
+    m.def("ParallelScope",
+          [](const OpenMPScope &scope) { return ParallelScope{scope}; });
+    m.def("ParallelScope",
+          [](const CUDAScope &scope) { return ParallelScope{scope}; });
 }
 
 } // namespace freetensor
@@ -40,6 +40,21 @@ void init_ffi_pass(py::module_ &m) {
           "func"_a);
     m.def("z3_simplify", static_cast<Stmt (*)(const Stmt &)>(&z3Simplify),
           "stmt"_a);
+    m.def(
+        "z3_stats",
+        []() {
+            auto stats = z3Stats();
+            return py::dict("n_query"_a = stats.nQuery_,
+                            "n_cache_hit"_a = stats.nCacheHit_,
+                            "n_timeout"_a = stats.nTimeout_,
+                            "n_skipped"_a = stats.nSkipped_,
+                            "solver_time"_a = stats.solverTime_,
+                            "cache_entries"_a = stats.cacheEntries_,
+                            "cache_bytes"_a = stats.cacheBytes_);
+        },
+        "Counters of Z3Simplify queries. `solver_time` is in seconds");
+    m.def("clear_z3_cache", clearZ3Cache,
+          "Drop all cached results of Z3Simplify queries");
 
     m.def("pb_simplify", static_cast<Func (*)(const Func &)>(&pbSimplify),
           "func"_a);
@@ -156,9 +171,13 @@ void init_ffi_pass(py::module_ &m) {
 
     // CPU
     m.def("cpu_lower_parallel_reduction",
-          static_cast<Func (*)(const Func &)>(&cpu::lowerParallelReduction));
+          static_cast<Func (*)(const Func &, const Ref<CPUTarget> &)>(
+              &cpu::lowerParallelReduction),
+          "func"_a, "target"_a = nullptr);
     m.def("cpu_lower_parallel_reduction",
-          static_cast<Stmt (*)(const Stmt &)>(&cpu::lowerParallelReduction));
+          static_cast<Stmt (*)(const Stmt &, const Ref<CPUTarget> &)>(
+              &cpu::lowerParallelReduction),
+          "stmt"_a, "target"_a = nullptr);
 
     // GPU
 #ifdef FT_WITH_CUDA
@@ -226,6 +245,18 @@ void init_ffi_pass(py::module_ &m) {
               &lower),
           "stmt"_a, "target"_a = nullptr,
           "skip_passes"_a = std::unordered_set<std::string>{}, "verbose"_a = 0);
+    m.def(
+        "lower_cache_stats",
+        []() {
+            auto stats = lowerCacheStats();
+            return py::dict("n_hit"_a = stats.nHit_, "n_miss"_a = stats.nMiss_,
+                            "n_fallback"_a = stats.nFallback_,
+                            "entries"_a = stats.entries_,
+                            "bytes"_a = stats.bytes_);
+        },
+        "Counters of incremental lowering");
+    m.def("clear_lower_cache", clearLowerCache,
+          "Drop all cached results of incremental lowering");
 }
 
 } // namespace freetensor
@@ -122,6 +122,7 @@ void init_ffi_schedule(py::module_ &m) {
         .def("move_to", &Schedule::moveTo, "stmt"_a, "side"_a, "dst"_a)
         .def("inline", &Schedule::inlining, "vardef"_a)
         .def("parallelize", &Schedule::parallelize, "loop"_a, "parallel"_a)
+        .def("parallelize_as_tasks", &Schedule::parallelizeAsTasks, "stmts"_a)
         .def("unroll", &Schedule::unroll, "loop"_a, "immedate"_a = false)
         .def("vectorize", &Schedule::vectorize, "loop"_a)
         .def("separate_tail", &Schedule::separateTail,
@@ -132,11 +133,14 @@ void init_ffi_schedule(py::module_ &m) {
              "fusable_overlap_threshold"_a = 1, "do_simplify"_a = true)
         .def("pluto_permute", &Schedule::plutoPermute, "loop"_a,
              "nest_level"_a = 0, "do_simplify"_a = true)
-        .def("auto_schedule",
-             [](Schedule &s, const Ref<Target> &target) {
-                 // Pybind11 doesn't support Ref<std::vector>, need lambda
-                 return s.autoSchedule(target);
-             })
+        .def(
+            "auto_schedule",
+            [](Schedule &s, const Ref<Target> &target,
+               const Ref<TuningRecordDB> &records) {
+                // Pybind11 doesn't support Ref<std::vector>, need lambda
+                return s.autoSchedule(target, nullptr, records);
+            },
+            "target"_a, "records"_a = nullptr)
         .def("auto_use_lib", &Schedule::autoUseLib)
         .def("auto_reorder", &Schedule::autoReorder)
         .def("auto_fission_fuse",
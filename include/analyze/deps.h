@@ -9,6 +9,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include <analyze/deps_cache.h>
 #include <analyze/find_loop_variance.h>
 #include <analyze/find_stmt.h>
 #include <analyze/symbol_table.h>
@@ -493,6 +494,9 @@ class FindDeps {
     bool ignoreReductionWAW_ = true;
     bool eraseOutsideVarDef_ = true;
     bool noProjectOutPrivateAxis_ = false;
+    Ref<DepsCache> cache_ = DepsCache::current();
+    std::string cacheTag_; /// Encoding of filters that can be cached
+    bool opaque_ = false;  /// Some filters are not encoded in `cacheTag_`
 
   public:
     /**
@@ -568,6 +572,7 @@ class FindDeps {
     }
     FindDeps filterAccess(const FindDepsAccFilter &f) {
         FindDeps ret = *this;
+        ret.opaque_ = true;
         ret.accFilter_ =
             ret.accFilter_ == nullptr
                 ? f
@@ -588,6 +593,7 @@ class FindDeps {
      */
     FindDeps filterEarlier(const FindDepsAccPtFilter &f) {
         FindDeps ret = *this;
+        ret.opaque_ = true;
         ret.earlierFilter_ =
             ret.earlierFilter_ == nullptr
                 ? f
@@ -607,6 +613,7 @@ class FindDeps {
      */
     FindDeps filterLater(const FindDepsAccPtFilter &f) {
         FindDeps ret = *this;
+        ret.opaque_ = true;
         ret.laterFilter_ =
             ret.laterFilter_ == nullptr
                 ? f
@@ -626,6 +633,7 @@ class FindDeps {
      */
     FindDeps filter(const FindDepsFilter &f) {
         FindDeps ret = *this;
+        ret.opaque_ = true;
         ret.filter_ = f;
         ret.filter_ =
             ret.filter_ == nullptr
@@ -641,9 +649,12 @@ class FindDeps {
      * Help function to analyze a sub-AST only
      */
     FindDeps filterSubAST(const ID &subAST) {
-        return filterAccess([subAST](const Access &acc) {
+        auto ret = filterAccess([subAST](const Access &acc) {
             return acc.stmt_->ancestorById(subAST).isValid();
         });
+        ret.opaque_ = opaque_;
+        ret.cacheTag_ += "subAST " + toString(subAST) + ";";
+        return ret;
     }
 
     /**
@@ -688,6 +699,32 @@ class FindDeps {
             callback) {
         FindDeps ret = *this;
         ret.scope2CoordCallback_ = callback;
+        ret.opaque_ = true;
+        return ret;
+    }
+
+    /**
+     * Declare that all the filters configured so far are fully determined by
+     * `tag` and the AST, so results can be memoized in `DepsCache`
+     *
+     * Filters configured by `filterAccess`, `filterEarlier`, `filterLater` or
+     * `filter` are opaque functions, and disable memoization by default
+     */
+    FindDeps cacheTag(const std::string &tag) {
+        FindDeps ret = *this;
+        ret.cacheTag_ += tag + ";";
+        ret.opaque_ = false;
+        return ret;
+    }
+
+    /**
+     * Memoize results in a `DepsCache`, or `nullptr` to disable memoization
+     *
+     * Defaults to `DepsCache::current()`
+     */
+    FindDeps cache(const Ref<DepsCache> &cache) {
+        FindDeps ret = *this;
+        ret.cache_ = cache;
         return ret;
     }
 
@@ -719,6 +756,18 @@ class FindDeps {
      * @param op : AST root
      */
     bool exists(const Stmt &op);
+
+  private:
+    /**
+     * Key of the query in `DepsCache`, or an empty string if not cacheable
+     */
+    std::string cacheQuery() const;
+
+    /**
+     * Run FindDeps. If `stopAtAny`, return true as soon as `DepsCache` tells
+     * there is any dependence, without running the callback
+     */
+    bool run(const Stmt &op, const FindDepsCallback &found, bool stopAtAny);
 };
 
 std::ostream &operator<<(std::ostream &os, const Dependence &dep);
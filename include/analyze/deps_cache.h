@@ -0,0 +1,85 @@
+#ifndef FREE_TENSOR_DEPS_CACHE_H
+#define FREE_TENSOR_DEPS_CACHE_H
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <hash.h>
+#include <ref.h>
+#include <stmt.h>
+
+namespace freetensor {
+
+/**
+ * Memoized results of `FindDeps`, shared by all `Schedule`s `fork`ed from a
+ * common one
+ *
+ * Dependences of a variable are determined by the sub-AST of its `VarDef`, the
+ * control flows around the `VarDef` (loop ranges, conditions), and the query
+ * (direction, mode, type and filters). Most schedules modify only a small part
+ * of a program, so most `VarDef`s stay the same across schedules, and results
+ * of them can be reused. The results are keyed by the structural hash of the
+ * `VarDef` sub-AST, and then by a string encoding the statement IDs, the
+ * surrounding control flows and the query. A changed sub-AST hashes
+ * differently, so stale results are never looked up
+ *
+ * Only whether any dependence is found is recorded, because `Dependence`
+ * objects refer to Presburger objects local to one analysis. A variable found
+ * free of dependences is skipped in later analyses of the same query, and one
+ * found with dependences short-circuits `FindDeps::exists`
+ *
+ * The cache is enabled for `FindDeps` queries created in a `DepsCache::Scope`
+ * (`Schedule` opens one for each schedule), and only if all filters of the
+ * query can be encoded in the key (see `FindDeps::cacheTag`)
+ *
+ * This class is thread-safe
+ */
+class DepsCache {
+    // VarDef sub-AST -> (IDs, context and query -> whether any dependence is
+    // found)
+    ASTHashMap<Stmt, std::unordered_map<std::string, bool>> results_;
+    size_t size_ = 0, maxSize_;
+    std::mutex lock_;
+
+    static thread_local Ref<DepsCache> current_;
+
+  public:
+    DepsCache(size_t maxSize = 1 << 16) : maxSize_(maxSize) {}
+
+    std::optional<bool> lookup(const Stmt &def, const std::string &key);
+    void save(const Stmt &def, const std::string &key, bool found);
+
+    /**
+     * Drop all results of a sub-AST
+     */
+    void invalidate(const Stmt &def);
+
+    void clear();
+
+    /**
+     * Cache used by `FindDeps` queries created in the current thread
+     */
+    static const Ref<DepsCache> &current() { return current_; }
+
+    /**
+     * Set `current()` during the lifetime of this object
+     */
+    class Scope {
+        Ref<DepsCache> old_;
+
+      public:
+        Scope(const Ref<DepsCache> &cache) : old_(current_) {
+            current_ = cache;
+        }
+        ~Scope() { current_ = old_; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_DEPS_CACHE_H
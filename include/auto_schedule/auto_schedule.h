@@ -7,9 +7,12 @@
 #include <set>
 #include <unordered_map>
 
+#include <auto_schedule/cost_model.h>
 #include <auto_schedule/rule.h>
 #include <auto_schedule/sketch.h>
+#include <auto_schedule/tuning_record.h>
 #include <driver/array.h>
+#include <driver/benchmark.h>
 #include <driver/device.h>
 #include <driver/target.h>
 #include <random.h>
@@ -21,6 +24,13 @@ class AutoSchedule {
     typedef std::vector<std::vector<double>> Features;
     typedef std::vector<double> Predicts;
 
+    /// Measure lowered functions and their generated code, and return the
+    /// lists of average time and standard deviation. INFINITY for failures
+    typedef std::function<std::pair<std::vector<double>, std::vector<double>>(
+        const std::vector<Func> &, const std::vector<std::string> &,
+        const BenchmarkOptions &)>
+        MeasureFunc;
+
   private:
     Schedule original_;
     Ref<Target> target_;
@@ -31,15 +41,23 @@ class AutoSchedule {
     bool paramsSet_;
     std::vector<Ref<Sketch>> measuredSketches_; // sorted from fast to slow
     std::set<size_t> measuredHashes_;
+    std::set<uint64_t> recordedASTHashes_; /// `astHash` of loaded records
     OpenMPRandomEngine rng_;
     std::function<Predicts(const Features &)> predictFunc_;
     std::function<void(const Features &, const Predicts &)> updateFunc_;
+    Ref<CostModel> costModel_; /// Native model, if no functions above given
     std::vector<std::pair<std::string, Ref<Rule>>> rules_; // (name, rule)
     double flop_;
     std::string tag_;
     int minBlockSize_{0};
     std::optional<std::unordered_set<std::string>> ruleSet_;
     int verbose_ = 0;
+    BenchmarkOptions measureOptions_;
+    double abortRatio_ = 2;
+    MeasureFunc measureFunc_; /// Measure somewhere else if set
+    Ref<TuningRecordDB> records_;            /// Persist measured sketches
+    std::string workload_;                   /// Key of this program in records_
+    std::optional<TuningRecord> bestRecord_; /// Best record from records_
 
   private:
     /**
@@ -50,7 +68,19 @@ class AutoSchedule {
     std::pair<std::vector<double>, std::vector<double>>
     measure(const std::vector<Ref<Sketch>> &sketches);
 
+    /**
+     * Best time of sketches measured in this search, not including records
+     */
+    double getBestMeasuredTime() const;
+
   public:
+    /**
+     * @param predictFunc : Predict FLOPS of programs from their features
+     * @param updateFunc : Train the model with measured FLOPS
+     *
+     * Leave both `predictFunc` and `updateFunc` empty to use the native
+     * `CostModel`, which does not call back into Python
+     */
     AutoSchedule(const Schedule &schedule, const Ref<Target> &target,
                  const Ref<Device> &device,
                  const std::function<Predicts(const Features &)> &predictFunc,
@@ -65,6 +95,41 @@ class AutoSchedule {
     void setParams(const std::vector<Ref<Array>> &args,
                    const std::unordered_map<std::string, Ref<Array>> &kws);
 
+    /**
+     * Set how to measure each sketch
+     *
+     * @param options : Options of `Driver::benchmark`
+     * @param abortRatio : Stop measuring a sketch once it is clearly slower
+     * than this ratio times the best time so far. Set to INFINITY to measure
+     * every sketch fully
+     */
+    void setMeasureOptions(const BenchmarkOptions &options,
+                           double abortRatio = 2);
+
+    /**
+     * Measure sketches with a custom function instead of on the local device,
+     * e.g. on remote workers. The function is called with a whole batch of
+     * sketches, so it may measure them in parallel
+     *
+     * The `abortThreshold` in the options passed to the function is set by
+     * the best time before this batch
+     */
+    void setMeasureFunc(const MeasureFunc &measureFunc) {
+        measureFunc_ = measureFunc;
+    }
+
+    /**
+     * Record all measured sketches in a database from now on
+     *
+     * @param records : The database
+     * @param warmStart : If true, start from the existing records of the same
+     * program and target: train the cost model with them, skip sketches
+     * recorded, and take the best record into account in `getBestSchedule`
+     * and `getBestTime`
+     */
+    void setTuningRecords(const Ref<TuningRecordDB> &records,
+                          bool warmStart = true);
+
     void searchOneRound(size_t n, size_t nExploit, size_t nExplore);
 
     std::vector<Ref<Sketch>> evolutionarySearch(size_t outSize);
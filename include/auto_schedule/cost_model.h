@@ -0,0 +1,90 @@
+#ifndef FREE_TENSOR_COST_MODEL_H
+#define FREE_TENSOR_COST_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace freetensor {
+
+/**
+ * Native cost model of gradient-boosted regression trees
+ *
+ * The model predicts the performance (in FLOPS, the higher the better) of a
+ * program from its `fixedLengthFeature`. It is trained on the logarithm of the
+ * performance with the squared loss, and the splits are searched on quantile
+ * histograms of the features, as XGBoost's `hist` method does
+ *
+ * The model is updated online: all samples seen so far (up to `maxSamples`,
+ * dropping the oldest ones) are kept, and the trees are rebuilt on each update
+ */
+class CostModel {
+  public:
+    typedef std::vector<std::vector<double>> Features;
+    typedef std::vector<double> Predicts;
+
+  private:
+    struct TreeNode {
+        int feature_ = -1; // -1 for leaves
+        double threshold_ = 0;
+        int left_ = -1, right_ = -1;
+        double value_ = 0;
+    };
+    typedef std::vector<TreeNode> Tree; // Root at 0
+
+    int nTrees_, maxDepth_, minSamplesLeaf_;
+    double learningRate_, lambda_;
+    size_t maxSamples_;
+
+    Features xs_;
+    std::vector<double> ys_; // log(FLOPS)
+
+    double base_ = 0;
+    std::vector<Tree> trees_;
+
+  private:
+    void train();
+
+    int buildNode(Tree &tree, std::vector<size_t> &samples, size_t begin,
+                  size_t end, int depth,
+                  const std::vector<std::vector<uint8_t>> &binned,
+                  const std::vector<std::vector<double>> &thresholds,
+                  const std::vector<double> &residuals) const;
+
+    double predictOne(const std::vector<double> &x) const;
+
+  public:
+    /**
+     * @param nTrees : Number of trees
+     * @param maxDepth : Maximum depth of each tree
+     * @param learningRate : Shrinkage of each tree
+     * @param minSamplesLeaf : Minimum number of samples in each leaf
+     * @param lambda : L2 regularization on leaf values
+     * @param maxSamples : Maximum number of samples to keep for training
+     */
+    CostModel(int nTrees = 50, int maxDepth = 6, double learningRate = 0.3,
+              int minSamplesLeaf = 2, double lambda = 1,
+              size_t maxSamples = 10000);
+
+    /**
+     * Predict the performance of programs
+     *
+     * Returns 1 for every program before trained, as the Python XGBoost model
+     * does
+     */
+    Predicts predict(const Features &features) const;
+
+    /**
+     * Add samples of measured performance and rebuild the model
+     *
+     * Samples with non-positive or non-finite performance are ignored
+     */
+    void update(const Features &features, const Predicts &flops);
+
+    size_t nSamples() const { return xs_.size(); }
+    bool trained() const { return !trees_.empty(); }
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_COST_MODEL_H
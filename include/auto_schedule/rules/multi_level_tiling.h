@@ -8,11 +8,13 @@
 #include <auto_schedule/rule.h>
 #include <auto_schedule/sketch.h>
 #include <auto_schedule/structs.h>
+#include <driver/target.h>
 
 namespace freetensor {
 
 class MultiLevelTilingRule : public Rule {
     std::string pat_;
+    size_t l1Size_ = 0, l2Size_ = 0; // For CPUs only, in bytes
 
   public:
     explicit MultiLevelTilingRule(TargetType target) {
@@ -22,6 +24,15 @@ class MultiLevelTilingRule : public Rule {
             pat_ = "SSSRRSRS";
         }
     }
+    /**
+     * Tile for a CPU, with the innermost and the second innermost tiles fitting
+     * the L1 and L2 caches of the CPU
+     */
+    explicit MultiLevelTilingRule(const Ref<CPUTarget> &target)
+        : MultiLevelTilingRule(TargetType::CPU) {
+        l1Size_ = target->l1DataCacheSize();
+        l2Size_ = target->l2CacheSize();
+    }
     RuleStatus analyze(const Sketch &sketch) override;
     std::vector<Ref<Sketch>> genPart(const Sketch &sketch) override;
 };
@@ -36,12 +47,27 @@ class MultiLevelTilingPart : public SketchPartNode {
     int reductionLoopTimes_;
     std::vector<std::pair<ID, int>> tiles_;
 
+    // Capacities of the L1 and L2 caches in elements, or 0 for unlimited
+    int64_t l1Elems_ = 0, l2Elems_ = 0;
+
+    /**
+     * Whether the working sets of the innermost and the second innermost
+     * levels of tiles fit in the L1 and L2 caches, respectively
+     *
+     * The working set is estimated as if the program is a matrix
+     * multiplication: the output tile is the product of the space tiles, and
+     * each input tile is the product of the reduction tiles and the square
+     * root of the product of the space tiles
+     */
+    bool fitsCache(const MultiLevelTilingAnnotation &annotation) const;
+
   public:
     void genRandAnnotation(RNG &gen) override;
     void genFakeAnnotation(RNG &gen) override;
     std::vector<std::pair<ID, int>> &tiles() { return tiles_; }
     explicit MultiLevelTilingPart(ForsWithDataReuse fors,
-                                  std::string pat = "SSRSRS");
+                                  std::string pat = "SSRSRS",
+                                  int64_t l1Elems = 0, int64_t l2Elems = 0);
     void apply(Schedule &schedule, SubSketch &subSketch) override;
     bool mutate(RNG &gen) override;
     bool crossover(const SketchPart &part, RNG &gen) override;
@@ -17,6 +17,7 @@ class MultiLevelTilingWithFusionRule : public Rule {
     std::vector<int> fuseLevels_;
     TargetType targetType_;
     int minBlockSize_;
+    size_t l1Size_ = 0, l2Size_ = 0; // For CPUs only, in bytes
 
   public:
     MultiLevelTilingWithFusionRule(TargetType target, int minBlockSize = 0)
@@ -29,6 +30,15 @@ class MultiLevelTilingWithFusionRule : public Rule {
             fuseLevels_ = {3};
         }
     }
+    /**
+     * Tile for a CPU, with the innermost and the second innermost tiles fitting
+     * the L1 and L2 caches of the CPU
+     */
+    explicit MultiLevelTilingWithFusionRule(const Ref<CPUTarget> &target)
+        : MultiLevelTilingWithFusionRule(TargetType::CPU) {
+        l1Size_ = target->l1DataCacheSize();
+        l2Size_ = target->l2CacheSize();
+    }
     RuleStatus analyze(const Sketch &sketch) override;
     std::vector<Ref<Sketch>> genPart(const Sketch &sketch) override;
 };
@@ -46,7 +56,9 @@ class MultiLevelTilingWithFusionPart : public MultiLevelTilingPart {
                                             ElementWiseInfo toFuse, int level,
                                             std::string pat,
                                             TargetType targetType,
-                                            int minBlockSize);
+                                            int minBlockSize,
+                                            int64_t l1Elems = 0,
+                                            int64_t l2Elems = 0);
     void apply(Schedule &schedule, SubSketch &subSketch) override;
     bool mutate(RNG &gen) override;
     bool crossover(const SketchPart &part, RNG &gen) override;
@@ -1,6 +1,8 @@
 #ifndef FREE_TENSOR_AUTO_SCHEDULE_PARALLELIZE_H
 #define FREE_TENSOR_AUTO_SCHEDULE_PARALLELIZE_H
 
+#include <iterator>
+
 #include <auto_schedule/rule.h>
 
 namespace freetensor {
@@ -12,14 +14,28 @@ class ParallelizeRule : public Rule {
     std::vector<Ref<Sketch>> genPart(const Sketch &sketch) override;
 };
 
+/**
+ * Parallelize the outer space loops from multi-level tiling with OpenMP
+ *
+ * The annotation consists of the number of loops to parallelize, and the
+ * OpenMP schedule kind and chunk size (an index into `CHUNK_SIZES`), which
+ * balance triangular or guard-heavy loops
+ */
 class ParallelizePart : public SketchPartNode {
+    static constexpr int CHUNK_SIZES[] = {0, 1, 4, 16, 64}; // 0 for default
+    static constexpr int N_CHUNK_SIZES = std::size(CHUNK_SIZES);
+
     int maxSize_;
     int parallelSize_;
+    int schedule_;  // OpenMPScope::Schedule
+    int chunkIdx_;  // Index into CHUNK_SIZES
     ID lastParallelizedID_{};
 
   public:
-    ParallelizePart(size_t maxSize, size_t parallelSize = 0)
-        : maxSize_(maxSize), parallelSize_(parallelSize) {}
+    ParallelizePart(size_t maxSize, size_t parallelSize = 0, int schedule = 0,
+                    int chunkIdx = 0)
+        : maxSize_(maxSize), parallelSize_(parallelSize), schedule_(schedule),
+          chunkIdx_(chunkIdx) {}
 
     void genRandAnnotation(RNG &gen) override;
     void genFakeAnnotation(RNG &gen) override;
@@ -33,16 +49,20 @@ class ParallelizePart : public SketchPartNode {
     SketchPartType partType() override { return SketchPartType::Parallelize; }
 
     [[nodiscard]] std::vector<int> getAnnotation() const override {
-        return {parallelSize_};
+        return {parallelSize_, schedule_, CHUNK_SIZES[chunkIdx_]};
     };
 
     [[nodiscard]] size_t hash() const override {
-        return hashCombine(std::hash<std::string>{}("parallelize"),
-                           std::hash<int>{}(parallelSize_));
+        return hashCombine(
+            hashCombine(std::hash<std::string>{}("parallelize"),
+                        std::hash<int>{}(parallelSize_)),
+            hashCombine(std::hash<int>{}(schedule_),
+                        std::hash<int>{}(chunkIdx_)));
     }
 
     [[nodiscard]] SketchPart clone() const override {
-        return Ref<ParallelizePart>::make(maxSize_, parallelSize_);
+        return Ref<ParallelizePart>::make(maxSize_, parallelSize_, schedule_,
+                                          chunkIdx_);
     };
 
     const ID &lastParallelizedID() const { return lastParallelizedID_; }
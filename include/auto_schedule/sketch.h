@@ -139,6 +139,7 @@ class Sketch {
     std::optional<Schedule> genSchedule_;
     Func lowered_;
     std::optional<std::vector<double>> feature_;
+    std::optional<uint64_t> astHash_;
 
   public:
     Sketch() = default;
@@ -222,6 +223,12 @@ class Sketch {
      * Generate a feature from a lowered AST. The result is cached
      */
     const std::vector<double> &feature();
+
+    /**
+     * Stable hash of the generated AST printed without IDs, to match tuning
+     * records across processes. The result is cached
+     */
+    uint64_t astHash();
 };
 
 } // namespace freetensor
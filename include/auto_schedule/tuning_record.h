@@ -0,0 +1,103 @@
+#ifndef FREE_TENSOR_TUNING_RECORD_H
+#define FREE_TENSOR_TUNING_RECORD_H
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <driver/target.h>
+#include <stmt.h>
+
+namespace freetensor {
+
+/**
+ * A measured schedule of a program
+ */
+struct TuningRecord {
+    std::string workload; /// Key of the program and target, by `workloadKey`
+    uint64_t astHash = 0; /// `stableHash` of `ast`. Only for deduplication
+    std::string target;   /// Description of the target, by `targetKey`
+    std::vector<std::string> logs; /// Schedule log, for reference
+    std::vector<double> features;  /// Features for the cost model
+    double time = 0;               /// Measured time, in ms
+    std::string ast;               /// Serialized AST after scheduling
+};
+
+/**
+ * A database of tuning records, persisted in an append-only file
+ *
+ * Each record takes one line, so records appended by multiple processes
+ * simultaneously do not interleave, and a truncated last line (e.g. from a
+ * crashed process) is simply ignored when loading
+ */
+class TuningRecordDB {
+    std::string path_;
+    std::vector<TuningRecord> records_;
+    std::unordered_map<std::string, std::vector<size_t>>
+        byWorkload_; /// workload -> indices in records_
+    mutable std::mutex lock_;
+
+  private:
+    void add(TuningRecord &&record);
+
+  public:
+    /**
+     * Open a database, and load all its records, if the file exists
+     *
+     * @param path : Path to the file. Set to an empty string for a database
+     * only in memory
+     */
+    explicit TuningRecordDB(const std::string &path = "");
+
+    TuningRecordDB(const TuningRecordDB &) = delete;
+    TuningRecordDB &operator=(const TuningRecordDB &) = delete;
+
+    const std::string &path() const { return path_; }
+
+    /**
+     * Add a record, and append it to the file
+     */
+    void append(const TuningRecord &record);
+
+    /**
+     * Drop records in memory, and load them again from the file, including
+     * those appended by other processes
+     */
+    void reload();
+
+    /**
+     * Records of a workload, sorted from the fastest to the slowest
+     *
+     * @param workload : Key by `workloadKey`
+     * @param limit : Return at most this number of records. 0 for unlimited
+     */
+    std::vector<TuningRecord> query(const std::string &workload,
+                                    size_t limit = 0) const;
+
+    /**
+     * The fastest record of a workload, if any
+     */
+    std::optional<TuningRecord> best(const std::string &workload) const;
+
+    /**
+     * Number of all records
+     */
+    size_t size() const;
+
+    /**
+     * Key to identify a program (before scheduling) on a target, which is
+     * stable across processes
+     */
+    static std::string workloadKey(const Stmt &ast, const Ref<Target> &target);
+
+    /**
+     * Description of a target
+     */
+    static std::string targetKey(const Ref<Target> &target);
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_TUNING_RECORD_H
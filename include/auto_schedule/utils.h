@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <random>
 #include <schedule.h>
+#include <serialize/print_ast.h>
 
 namespace freetensor {
 
@@ -34,6 +35,13 @@ _randomFillArray(int total, int n,
     return result;
 }
 
+/**
+ * Print an AST without IDs, so it can be compared across processes
+ */
+inline std::string printWithoutIDs(const Stmt &ast) {
+    return toString(ast, false, false, true, true, true);
+}
+
 inline int randomInt(int mx, std::uniform_random_bit_generator auto &gen) {
     std::uniform_int_distribution<> dis(0, mx);
     return dis(gen);
@@ -109,6 +117,29 @@ inline Schedule::IDMap fissionLoops(Schedule &schedule,
     return ret;
 }
 
+/**
+ * Number of elements of a variable that fit in a cache of a given size, or 0
+ * if the size is unknown
+ */
+inline int64_t cacheCapacity(const Stmt &ast, const std::string &var,
+                             size_t cacheSize) {
+    if (cacheSize == 0) {
+        return 0;
+    }
+    size_t elemSize = 4;
+    if (auto defs = findAllStmt(ast,
+                                [&](const Stmt &s) {
+                                    return s->nodeType() ==
+                                               ASTNodeType::VarDef &&
+                                           s.as<VarDefNode>()->name_ == var;
+                                });
+        !defs.empty()) {
+        elemSize = sizeOf(
+            defs.front().as<VarDefNode>()->buffer_->tensor()->dtype());
+    }
+    return cacheSize / elemSize;
+}
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_UTILS_H
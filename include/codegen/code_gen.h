@@ -83,6 +83,25 @@ template <class Stream> class CodeGen : public SymbolTable<Visitor> {
  */
 std::string codeGen(const Func &func, const Ref<Target> &target);
 
+/**
+ * Generate native code of multiple programs in one translation unit
+ *
+ * Unlike a single program, whose entry function is always named `run`, the
+ * entry function of the i-th program is named `multiKernelEntry(i, name)`
+ *
+ * Only supported on CPU
+ *
+ * @param funcs : The ASTs to be lowered
+ * @param target : The target architecture
+ */
+std::string codeGen(const std::vector<Func> &funcs, const Ref<Target> &target);
+
+/**
+ * Name of the entry function of the i-th program in a translation unit
+ * generated from multiple programs
+ */
+std::string multiKernelEntry(size_t i, const std::string &funcName);
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_CODE_GEN_H
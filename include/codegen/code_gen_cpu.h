@@ -4,27 +4,55 @@
 #include <unordered_set>
 
 #include <codegen/code_gen_c.h>
+#include <driver/target.h>
 #include <func.h>
+#include <pass/cpu/plan_memory.h>
 
 namespace freetensor {
 
 class CodeGenCPU : public CodeGenC<CodeGenStream> {
     typedef CodeGenC<CodeGenStream> BaseClass;
 
+    int alignment_;        // Alignment of variables on stacks, in bytes
+    bool useThreadPool_;   // Run parallel loops with `ThreadPool`, not OpenMP
+    cpu::MemoryPlan plan_; // Offsets of variables on stacks
+    bool useNativeGEMM_;   // Built-in GEMM for `MatMul` even if with MKL
+    int numCores_;         // Cores to share among threads. 0 for unknown
+    int vectorBytes_;      // SIMD width of the target, for the built-in GEMM
+
+    struct ParallelState {
+        bool inParallel_;
+        Expr extent_;      // Iterations of all enclosing parallel loops
+        std::string team_; // Number of threads running the outermost one
+    };
     bool inParallel_ = false;
-    int64_t sharedStackTop_ = 0, sharedStackSize_ = 0;
-    int64_t threadStackTop_ = 0, threadStackSize_ = 0;
+    Expr parallelExtent_;
+    std::string parallelTeam_;
+    int maxNumThreads_ = 0; // Largest `num_threads` of OpenMP loops
     std::unordered_set<For> collapsed_;
     std::unordered_set<VarDef> usedAsReduction_;
+    std::unordered_set<VarDef> atomicReduction_; // For `ThreadPool` or tasks
 
   public:
     CodeGenCPU(const std::vector<FuncParam> &params,
-               const std::vector<FuncRet> &returns)
-        : CodeGenC(params, returns) {}
+               const std::vector<FuncRet> &returns, int alignment = 64,
+               bool useThreadPool = false, const cpu::MemoryPlan &plan = {},
+               bool useNativeGEMM = false, int numCores = 0,
+               int vectorBytes = 16)
+        : CodeGenC(params, returns), alignment_(alignment),
+          useThreadPool_(useThreadPool), plan_(plan),
+          useNativeGEMM_(useNativeGEMM), numCores_(numCores),
+          vectorBytes_(vectorBytes) {}
+
+    int alignment() const { return alignment_; }
+    bool useThreadPool() const { return useThreadPool_; }
 
     // Stack sizes in bytes
-    int64_t sharedStackSize() const { return sharedStackSize_; }
-    int64_t threadStackSize() const { return threadStackSize_; }
+    int64_t sharedStackSize() const { return plan_.sharedSize_; }
+    int64_t threadStackSize() const { return plan_.threadSize_; }
+
+    // Threads may exceed `omp_get_max_threads()` by the `num_threads` clause
+    int maxNumThreads() const { return maxNumThreads_; }
 
   protected:
     void genAlloc(const Ref<Tensor> &tensor, const std::string &rawPtr,
@@ -35,8 +63,21 @@ class CodeGenCPU : public CodeGenC<CodeGenStream> {
     void genScalar(const VarDef &def,
                    const std::vector<Expr> &indices) override;
 
+  private:
+    std::string threadSlot() const {
+        return useThreadPool_ ? "__slot" : "omp_get_thread_num()";
+    }
+    std::string stackPtr(const VarDef &def) const;
+    ParallelState enterParallel(const Expr &extent, const std::string &team);
+    void exitParallel(const ParallelState &old);
+    void genThreadPoolFor(const For &op);
+    void genOpenMPTaskFor(const For &op);
+
+  protected:
     using BaseClass::visit;
     void visit(const VarDef &op) override;
+    void visit(const Alloc &op) override;
+    void visit(const Free &op) override;
     void visit(const ReduceTo &op) override;
     void visit(const For &op) override;
     void visit(const MatMul &op) override;
@@ -45,9 +86,17 @@ class CodeGenCPU : public CodeGenC<CodeGenStream> {
 /**
  * Generate target function code
  *
+ * @param target : Target CPU, whose cache line size and vector width determine
+ * the alignment of stack-allocated variables, and which decides the runtime of
+ * parallel loops. Defaults to the host CPU
  * @return : source
+ * @{
  */
-std::string codeGenCPU(const Func &func);
+std::string codeGenCPU(const Func &func,
+                       const Ref<CPUTarget> &target = nullptr);
+std::string codeGenCPU(const std::vector<Func> &funcs,
+                       const Ref<CPUTarget> &target = nullptr);
+/** @} */
 
 } // namespace freetensor
 
@@ -48,6 +48,52 @@ class Config {
         runtimeDir_; /// Where to find the `runtime` directory. Macro
                      /// FT_RUNTIME_DIR. Colon-separated paths, searched from
                      /// left to right
+    static std::filesystem::path
+        kernelCacheDir_; /// Where to cache compiled kernels across processes.
+                         /// Empty to disable. Env FT_KERNEL_CACHE_DIR.
+                         /// Initialized to `~/.freetensor/cache`
+    static size_t kernelCacheSize_; /// Total size of the kernel cache in bytes,
+                                    /// beyond which the least recently used
+                                    /// kernels are evicted. 0 for unlimited.
+                                    /// Env FT_KERNEL_CACHE_SIZE
+    static bool precompiledHeader_; /// Precompile the runtime header and keep
+                                    /// it in the kernel cache, to speed up
+                                    /// compiling. Env FT_PRECOMPILED_HEADER
+    static size_t compileWorkers_; /// Number of backend compilers to run in
+                                   /// parallel. 0 for the number of hardware
+                                   /// threads. Env FT_COMPILE_WORKERS
+    static size_t arrayPoolSize_;  /// Maximum bytes of freed `Array` buffers
+                                   /// cached for reuse. 0 to disable caching.
+                                   /// Env FT_ARRAY_POOL_SIZE
+    static size_t arrayAlignment_; /// Alignment of `Array` buffers on CPU in
+                                   /// bytes. Env FT_ARRAY_ALIGNMENT
+    static bool arrayHugePage_;    /// Back large `Array` buffers on CPU with
+                                   /// transparent huge pages. Env
+                                   /// FT_ARRAY_HUGE_PAGE
+    static bool arrayNUMALocal_;   /// Place `Array` buffers on CPU on the NUMA
+                                   /// node of the allocating thread. Env
+                                   /// FT_ARRAY_NUMA_LOCAL
+    static size_t pbMemoSize_;     /// Maximum bytes of memoized results of
+                                   /// Presburger operations. 0 to disable
+                                   /// memoization. Env FT_PB_MEMO_SIZE
+    static size_t
+        memoizedSchedulesSize_; /// Maximum estimated bytes of memoized
+                                /// schedules of a `Schedule` and its forks,
+                                /// beyond which the least recently used ones
+                                /// are evicted. Env FT_MEMOIZED_SCHEDULES_SIZE
+    static size_t lowerCacheSize_; /// Maximum bytes of lowered statements
+                                   /// cached for incremental lowering. 0 to
+                                   /// lower programs as a whole. Env
+                                   /// FT_LOWER_CACHE_SIZE
+    static size_t z3QueryTimeout_; /// Time limit of each query of Z3Simplify
+                                   /// in ms. 0 for unlimited. Env
+                                   /// FT_Z3_QUERY_TIMEOUT
+    static size_t z3PassBudget_;   /// Time limit of all queries of one
+                                   /// Z3Simplify pass in ms. 0 for unlimited.
+                                   /// Env FT_Z3_PASS_BUDGET
+    static size_t z3CacheSize_;    /// Maximum bytes of cached results of
+                                   /// Z3Simplify queries. 0 to disable
+                                   /// caching. Env FT_Z3_CACHE_SIZE
 
   private:
     /**
@@ -128,6 +174,80 @@ class Config {
     static const std::vector<std::filesystem::path> &runtimeDir() {
         return runtimeDir_;
     }
+
+    /**
+     * @brief Set where to cache compiled kernels
+     *
+     * @param path : Path to the cache directory, which will be created if not
+     * existing. Empty to disable the cache
+     */
+    static void setKernelCacheDir(const std::filesystem::path &path) {
+        kernelCacheDir_ = path;
+    }
+    static const std::filesystem::path &kernelCacheDir() {
+        return kernelCacheDir_;
+    }
+
+    static void setKernelCacheSize(size_t bytes) { kernelCacheSize_ = bytes; }
+    static size_t kernelCacheSize() { return kernelCacheSize_; }
+
+    static void setPrecompiledHeader(bool flag = true) {
+        precompiledHeader_ = flag;
+    }
+    static bool precompiledHeader() { return precompiledHeader_; }
+
+    /**
+     * @brief Set the number of backend compilers to run in parallel
+     *
+     * Only effective before the first program is compiled
+     */
+    static void setCompileWorkers(size_t n) { compileWorkers_ = n; }
+    static size_t compileWorkers() { return compileWorkers_; }
+
+    static void setArrayPoolSize(size_t bytes) { arrayPoolSize_ = bytes; }
+    static size_t arrayPoolSize() { return arrayPoolSize_; }
+
+    /**
+     * @brief Set the alignment of `Array` buffers on CPU
+     *
+     * Only effective for buffers allocated later. Buffers of at least one page
+     * are always aligned to pages
+     *
+     * @param bytes : A power of 2, and a multiple of `sizeof(void *)`
+     */
+    static void setArrayAlignment(size_t bytes);
+    static size_t arrayAlignment() { return arrayAlignment_; }
+
+    static void setArrayHugePage(bool flag = true) { arrayHugePage_ = flag; }
+    static bool arrayHugePage() { return arrayHugePage_; }
+
+    static void setArrayNUMALocal(bool flag = true) { arrayNUMALocal_ = flag; }
+    static bool arrayNUMALocal() { return arrayNUMALocal_; }
+
+    static void setPBMemoSize(size_t bytes) { pbMemoSize_ = bytes; }
+    static size_t pbMemoSize() { return pbMemoSize_; }
+
+    static void setMemoizedSchedulesSize(size_t bytes) {
+        memoizedSchedulesSize_ = bytes;
+    }
+    static size_t memoizedSchedulesSize() { return memoizedSchedulesSize_; }
+
+    /**
+     * @brief Set the size of the cache of incremental lowering
+     *
+     * Incremental lowering (see `lowerIncremental`) is enabled if not 0
+     */
+    static void setLowerCacheSize(size_t bytes) { lowerCacheSize_ = bytes; }
+    static size_t lowerCacheSize() { return lowerCacheSize_; }
+
+    static void setZ3QueryTimeout(size_t ms) { z3QueryTimeout_ = ms; }
+    static size_t z3QueryTimeout() { return z3QueryTimeout_; }
+
+    static void setZ3PassBudget(size_t ms) { z3PassBudget_ = ms; }
+    static size_t z3PassBudget() { return z3PassBudget_; }
+
+    static void setZ3CacheSize(size_t bytes) { z3CacheSize_ = bytes; }
+    static size_t z3CacheSize() { return z3CacheSize_; }
 };
 
 } // namespace freetensor
@@ -1,11 +1,14 @@
 #ifndef FREE_TENSOR_DRIVER_H
 #define FREE_TENSOR_DRIVER_H
 
+#include <future>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <driver/array.h>
+#include <driver/benchmark.h>
+#include <driver/compile_service.h>
 #include <func.h>
 
 #include <../runtime/cpu_context.h>
@@ -15,8 +18,16 @@
 
 namespace freetensor {
 
+/**
+ * Version of programs exported by `dumpDriver`. Bump it on any incompatible
+ * change to the format, the AST serialization or the calling convention of the
+ * entry function
+ */
+constexpr int DRIVER_FORMAT_VERSION = 1;
+
 class Driver {
-    void *dlHandle_ = nullptr;
+    std::shared_ptr<void> dlHandle_; /// Shared by `Driver`s of one program
+    std::string entry_;              /// Symbol of the entry function
     void (*func_)(void ** /* params */, void ** /* retRaw */,
                   size_t ** /* retShapes */, size_t * /* retDims */,
                   void * /* ctx */) = nullptr;
@@ -31,14 +42,43 @@ class Driver {
     std::vector<size_t> retDims_;
     std::unordered_map<std::string, size_t> name2param_;
     std::unordered_map<std::string, Ref<Buffer>> name2buffer_;
+    std::vector<Ref<Buffer>> param2buffer_; /// nullptr for unused parameters
     Ref<Device> dev_, hostDev_;
 
     std::unique_ptr<Context> ctx_;
+    int numThreads_ = 0; /// Thread budget of CPU programs using `ThreadPool`
+
+    /// Result of the compiling job, until loaded
+    std::shared_future<Ref<CompiledObject>> compiled_;
+    Ref<CompiledObject> binary_; /// The loaded object, kept for exporting
 
     bool verbose_ = false;
 
   private:
-    void buildAndLoad();
+    /**
+     * Submit a compiling job to the global `CompileService`
+     */
+    void build();
+
+    /**
+     * Wait for the compiling job, and load its result
+     */
+    void load();
+
+    /**
+     * Set up mappings from parameter names
+     */
+    void initParams();
+
+    /**
+     * Find the entry function from the loaded object, and set up the context
+     */
+    void loadEntry();
+
+    /**
+     * Check the data type and the shape (if static) of an argument
+     */
+    void checkArg(size_t paramId, const Ref<Array> &arg) const;
 
   public:
     /**
@@ -49,19 +89,53 @@ class Driver {
      * @param src : Native code generated from codegen
      * @param device : The device to run the program
      * @param hostDevice : The hosting CPU device (Optional)
+     * @param verbose : True to print extra infomation
+     * @param asyncBuild : If true, return as soon as the compiling job is
+     * submitted. The program is then loaded in `wait`, or in the first `run`.
+     * Compiling errors are also reported there
+     * @param entry : Symbol of the entry function. Only needed for code
+     * generated from multiple functions
      * @{
      */
     Driver(const Func &func, const std::string &src, const Ref<Device> &device,
-           const Ref<Device> &hostDevice, bool verbose = false);
+           const Ref<Device> &hostDevice, bool verbose = false,
+           bool asyncBuild = false, const std::string &entry = "run");
     Driver(const Func &func, const std::string &src, const Ref<Device> &device,
-           bool verbose = false)
+           bool verbose = false, bool asyncBuild = false,
+           const std::string &entry = "run")
         : Driver(func, src, device,
                  device->type() == TargetType::CPU
                      ? device
                      : Ref<Device>::make(TargetType::CPU),
-                 verbose) {}
+                 verbose, asyncBuild, entry) {}
     /** @} */
 
+    /**
+     * Run another function in the program loaded by another `Driver`, without
+     * compiling or loading anything again
+     *
+     * @param func : AST of the function
+     * @param loaded : The `Driver` whose loaded program is shared
+     * @param entry : Symbol of the entry function of `func`
+     */
+    Driver(const Func &func, Driver &loaded, const std::string &entry);
+
+    /**
+     * Load an already compiled program, without any backend compiler
+     *
+     * @param func : AST of the function
+     * @param src : Native code the program is compiled from. Only kept for
+     * reference
+     * @param binary : The compiled program
+     * @param device : The device to run the program
+     * @param hostDevice : The hosting CPU device
+     * @param entry : Symbol of the entry function
+     */
+    Driver(const Func &func, const std::string &src,
+           const Ref<CompiledObject> &binary, const Ref<Device> &device,
+           const Ref<Device> &hostDevice, const std::string &entry = "run",
+           bool verbose = false);
+
     ~Driver() {
         for (void *retVal : rawRets) {
             if (retVal != nullptr) {
@@ -78,12 +152,52 @@ class Driver {
     Driver(Driver &&) = default;
     Driver &operator=(Driver &&) = default;
 
+    const Func &func() const { return f_; }
+    const std::string &src() const { return src_; }
+    const std::string &entry() const { return entry_; }
+    const Ref<Device> &device() const { return dev_; }
+    const Ref<Device> &hostDevice() const { return hostDev_; }
+
+    /**
+     * The compiled program. Wait for it if not ready
+     */
+    const Ref<CompiledObject> &binary();
+
+    /**
+     * Check whether the program is compiled, without blocking
+     */
+    bool isReady() const;
+
+    /**
+     * Wait until the program is compiled and loaded
+     *
+     * Only needed for a `Driver` constructed with `asyncBuild`
+     */
+    void wait();
+
     void setArgs(const std::vector<Ref<Array>> &args,
                  const std::unordered_map<std::string, Ref<Array>> &kws = {});
     void setArgs(const std::unordered_map<std::string, Ref<Array>> &kws) {
         setArgs({}, kws);
     }
 
+    /**
+     * Index of a parameter, to be used in `setArg`
+     */
+    size_t paramIndex(const std::string &name) const;
+
+    /**
+     * Set one argument by the index of its parameter
+     *
+     * This is a fast path for running a program repeatedly with mostly the
+     * same arguments: bind all of them once with `setArgs` or `setArg`, and
+     * then only swap the changed ones with `setArg` before each `run`. Setting
+     * an `Array` that is already bound to the parameter skips the checks
+     *
+     * Use `collectReturns(true)` to keep the bound arguments after each run
+     */
+    void setArg(size_t paramId, const Ref<Array> &arg);
+
     void run();
 
     /**
@@ -93,7 +207,13 @@ class Driver {
      */
     void sync();
 
-    std::vector<Ref<Array>> collectReturns();
+    /**
+     * Collect return values from the last run
+     *
+     * @param keepArgs : If true, keep the arguments bound, so the program can
+     * be run again without setting them. Otherwise, release them
+     */
+    std::vector<Ref<Array>> collectReturns(bool keepArgs = false);
 
     /**
      * Run the program and measure its time cost
@@ -105,9 +225,34 @@ class Driver {
      */
     std::pair<double, double> time(int rounds = 10, int warmups = 3);
 
+    /**
+     * Run the program and measure its time cost, with adaptive stopping,
+     * outlier rejection and other options. See `BenchmarkOptions`
+     */
+    BenchmarkResult benchmark(const BenchmarkOptions &options = {});
+
+    /**
+     * Limit the number of threads of each parallel loop, for CPU programs
+     * generated for the thread pool runtime (see `CPUTarget::useThreadPool`)
+     *
+     * All such programs share one pool of threads, so running several of them
+     * concurrently never oversubscribes the cores. Limit each of them to share
+     * the cores predictably
+     *
+     * @param numThreads : Maximum number of threads, including the calling
+     * one. Non-positive for unlimited
+     */
+    void setNumThreads(int numThreads);
+    int numThreads() const { return numThreads_; }
+
     void unload();
 };
 
+/**
+ * The thread pool shared by all CPU programs using the thread pool runtime
+ */
+ThreadPool *cpuThreadPool();
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_DRIVER_H
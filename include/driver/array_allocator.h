@@ -0,0 +1,124 @@
+#ifndef FREE_TENSOR_ARRAY_ALLOCATOR_H
+#define FREE_TENSOR_ARRAY_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <ref.h>
+
+namespace freetensor {
+
+/**
+ * Counters of an `ArrayAllocator`
+ */
+struct ArrayAllocatorStats {
+    size_t nAlloc_ = 0;         /// Number of allocations
+    size_t nFree_ = 0;          /// Number of deallocations
+    size_t nHit_ = 0;           /// Allocations served from the cache
+    size_t nMiss_ = 0;          /// Allocations served by the system
+    size_t bytesInUse_ = 0;     /// Bytes held by live buffers
+    size_t peakBytesInUse_ = 0; /// Maximum of `bytesInUse_` ever reached
+    size_t bytesCached_ = 0;    /// Bytes kept in the cache for reuse
+};
+
+/**
+ * Allocator of host memory for `Array`
+ *
+ * An allocator may be replaced at any time, so it must tell whether a buffer
+ * is allocated by itself: `Array` may also hold buffers from the generated
+ * programs (see `Array::moveFromRaw`), or from a previous allocator
+ */
+class ArrayAllocator {
+  public:
+    virtual ~ArrayAllocator() {}
+
+    virtual uint8_t *alloc(size_t size) = 0;
+
+    /**
+     * Free a buffer
+     *
+     * @return : False if the buffer is not allocated by this allocator, in
+     * which case nothing is done
+     */
+    virtual bool free(uint8_t *ptr) = 0;
+
+    /**
+     * Return all cached memory to the system
+     */
+    virtual void releaseCache() {}
+
+    virtual ArrayAllocatorStats stats() const { return {}; }
+
+    /**
+     * The allocator for `Array`s on CPU. Initialized to a `CPUMemoryPool`
+     */
+    static Ref<ArrayAllocator> cpu();
+
+    /**
+     * Replace the allocator for `Array`s on CPU
+     *
+     * Buffers allocated by the old allocator are still freed by it
+     */
+    static void setCPU(const Ref<ArrayAllocator> &allocator);
+
+    /**
+     * Allocate from the current CPU allocator
+     */
+    static uint8_t *allocCPU(size_t size);
+
+    /**
+     * Free to whichever allocator the buffer is allocated by, or `delete[]` it
+     * if it is allocated by none of them
+     */
+    static void freeCPU(uint8_t *ptr);
+};
+
+/**
+ * A caching memory pool on CPU
+ *
+ * - Sizes are rounded up to size classes, 4 classes per power of 2, so at most
+ * 25% of memory is wasted. Freed buffers are kept per class and reused by
+ * later allocations of the same class, up to `Config::arrayPoolSize()` bytes
+ * in total
+ * - Buffers are aligned to `Config::arrayAlignment()` bytes, or to pages if
+ * they are at least one page large
+ * - If `Config::arrayHugePage()`, buffers of at least one huge page are aligned
+ * to huge pages, and advised to be backed by transparent huge pages
+ * - If `Config::arrayNUMALocal()`, buffers are bound to the NUMA node of the
+ * allocating thread, and only reused by threads on the same node
+ *
+ * The pool is thread-safe
+ */
+class CPUMemoryPool : public ArrayAllocator {
+    struct Block {
+        size_t size_; // Size class
+        int node_;    // NUMA node, or 0 if not NUMA-local
+    };
+
+    mutable std::mutex lock_;
+    std::unordered_map<uint8_t *, Block> live_;
+    std::unordered_map<int, std::unordered_map<size_t, std::vector<uint8_t *>>>
+        cached_; // node -> size class -> buffers
+    ArrayAllocatorStats stats_;
+
+  public:
+    ~CPUMemoryPool();
+
+    uint8_t *alloc(size_t size) override;
+    bool free(uint8_t *ptr) override;
+    void releaseCache() override;
+    ArrayAllocatorStats stats() const override;
+
+    static size_t sizeClass(size_t size);
+
+  private:
+    static uint8_t *sysAlloc(size_t size, int node);
+    static void sysFree(uint8_t *ptr);
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_ARRAY_ALLOCATOR_H
@@ -0,0 +1,85 @@
+#ifndef FREE_TENSOR_BENCHMARK_H
+#define FREE_TENSOR_BENCHMARK_H
+
+#include <cmath>
+#include <vector>
+
+namespace freetensor {
+
+/**
+ * Options for `Driver::benchmark`
+ *
+ * Measuring stops as soon as any of the following holds, but never before
+ * `minRounds` rounds:
+ *
+ * - `maxRounds` rounds have been run
+ * - The 95% confidence interval of the average time is within `targetRelCI`
+ * of the average time
+ * - The total time of the measured rounds exceeds `timeBudget`
+ * - The program is clearly slower than `abortThreshold`
+ */
+struct BenchmarkOptions {
+    int warmups = 3;     /// Rounds to run before measuring
+    int minRounds = 5;   /// Minimum rounds to measure
+    int maxRounds = 100; /// Maximum rounds to measure
+
+    /// Stop when the half width of the 95% confidence interval of the average
+    /// time is within this ratio of the average time. 0 to disable
+    double targetRelCI = 0.01;
+
+    /// Stop when the measured rounds take longer than this time in total, in
+    /// ms. 0 for unlimited
+    double timeBudget = 0;
+
+    /// Flush the CPU caches (and the GPU L2 cache for GPU programs) before each
+    /// round, for cold-cache numbers. The flushing is not timed
+    bool flushCache = false;
+
+    /// Pin the calling thread to this CPU core while measuring. -1 to disable.
+    /// This only affects the calling thread, and therefore only single-threaded
+    /// CPU programs and the launching of GPU kernels. Threads of OpenMP are
+    /// controlled by `OMP_PROC_BIND` and `OMP_PLACES` instead
+    int pinCPU = -1;
+
+    /// Stop early and report `aborted` if the fastest of the rounds (including
+    /// warmups but the first one) so far is slower than this time, in ms. Set
+    /// it to a multiple of the current best time to skip hopeless candidates
+    /// in tuning
+    double abortThreshold = INFINITY;
+
+    /// Reject outliers outside of Tukey's fences (1.5 interquartile ranges
+    /// beyond the quartiles) before computing the average and the standard
+    /// deviation
+    bool rejectOutliers = true;
+};
+
+/**
+ * Result of `Driver::benchmark`. All times are in ms
+ */
+struct BenchmarkResult {
+    std::vector<double> samples; /// Time of each round, sorted
+    double avg = INFINITY;       /// Average time, excluding outliers
+    double stddev = 0; /// Estimated standard deviation of `avg`, i.e.
+                       /// sqrt(Var(X1 + X2 + ... + Xn)) / n
+    int nOutliers = 0; /// Number of rejected outliers
+    bool aborted = false; /// True if stopped by `abortThreshold`
+
+    /**
+     * The p-th percentile (p in [0, 100]) of the samples, interpolated
+     * linearly
+     */
+    double percentile(double p) const;
+
+    double median() const { return percentile(50); }
+    double min() const { return samples.empty() ? INFINITY : samples.front(); }
+};
+
+/**
+ * Compute the statistics of a list of sampled times
+ */
+BenchmarkResult summarizeSamples(std::vector<double> samples,
+                                 bool rejectOutliers);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_BENCHMARK_H
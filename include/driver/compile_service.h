@@ -0,0 +1,118 @@
+#ifndef FREE_TENSOR_COMPILE_SERVICE_H
+#define FREE_TENSOR_COMPILE_SERVICE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <ref.h>
+
+namespace freetensor {
+
+/**
+ * A shared object produced by a backend compiler, in its own temporary
+ * directory
+ *
+ * The directory is removed when the last reference is dropped, unless in
+ * debug-binary mode
+ */
+class CompiledObject {
+    std::string dir_, so_;
+
+  public:
+    CompiledObject(const std::string &dir, const std::string &so)
+        : dir_(dir), so_(so) {}
+    ~CompiledObject();
+
+    CompiledObject(const CompiledObject &) = delete;
+    CompiledObject &operator=(const CompiledObject &) = delete;
+
+    const std::string &dir() const { return dir_; }
+    const std::string &so() const { return so_; }
+
+    /**
+     * Read the content of the shared object
+     */
+    std::string bytes() const;
+
+    /**
+     * Write a shared object, e.g. one exported earlier, to a new temporary
+     * directory
+     */
+    static Ref<CompiledObject> fromBytes(const std::string &bytes);
+};
+
+/**
+ * Make a temporary directory under `~/.freetensor`
+ */
+std::string makeTempDir();
+
+/**
+ * A pool of worker threads running backend compilers
+ *
+ * Jobs are put into a bounded queue. `submit` blocks when the queue is full,
+ * so a producer generating code faster than it can be compiled is throttled.
+ * Jobs with the same key submitted while one of them is still in flight are
+ * deduplicated, and share one result
+ */
+class CompileService {
+  public:
+    typedef std::shared_future<Ref<CompiledObject>> Future;
+
+  private:
+    typedef std::packaged_task<Ref<CompiledObject>()> Task;
+
+    size_t maxQueueSize_;
+
+    std::mutex lock_;
+    std::condition_variable notEmpty_, notFull_;
+    std::deque<std::pair<std::string, Task>> queue_; /// (key, job)
+    std::unordered_map<std::string, Future> inFlight_;
+    bool stopped_ = false;
+
+    std::vector<std::thread> workers_;
+
+  private:
+    void work();
+
+  public:
+    /**
+     * @param nWorkers : Number of worker threads. 0 for the number of hardware
+     * threads
+     * @param maxQueueSize : Maximum number of jobs waiting for a worker. 0 for
+     * 4 times the number of workers
+     */
+    CompileService(size_t nWorkers = 0, size_t maxQueueSize = 0);
+    ~CompileService();
+
+    CompileService(const CompileService &) = delete;
+    CompileService &operator=(const CompileService &) = delete;
+
+    size_t numWorkers() const { return workers_.size(); }
+
+    /**
+     * Submit a compiling job
+     *
+     * @param key : Jobs with the same key are considered identical
+     * @param job : The job to run. Exceptions thrown by it are rethrown from
+     * the returned future
+     */
+    Future submit(const std::string &key,
+                  const std::function<Ref<CompiledObject>()> &job);
+
+    /**
+     * The service shared by all `Driver`s, with `Config::compileWorkers()`
+     * workers. The number of workers is fixed once the service is first used
+     */
+    static CompileService &global();
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_COMPILE_SERVICE_H
@@ -0,0 +1,106 @@
+#ifndef FREE_TENSOR_KERNEL_CACHE_H
+#define FREE_TENSOR_KERNEL_CACHE_H
+
+#include <string>
+#include <vector>
+
+namespace freetensor {
+
+/**
+ * Persistent on-disk cache of compiled kernels
+ *
+ * Each entry is a directory `<Config::kernelCacheDir()>/<hash>` holding the
+ * full key text (`key`) and the cached files, e.g. the compiled shared object
+ * (`run.so`). The key of a kernel consists of the generated source, the full
+ * backend compiler command line, the compiler version and the contents of the
+ * runtime headers, so a change in any of them results in a miss
+ *
+ * The cache can be shared by multiple processes:
+ *
+ * - Entries are built in a private temporary directory and published with an
+ * atomic `rename`. If two processes publish the same entry, one of them wins
+ * and the other one simply drops its copy
+ * - Looking up or publishing an entry holds a shared `flock` on the cache
+ * directory, while eviction holds an exclusive one
+ * - A hit copies the shared object out of the cache, so a loaded kernel never
+ * refers to a file that may be evicted later, and each `Driver` still has its
+ * own copy of the static data in the kernel
+ *
+ * Entries are evicted in LRU order (by modification time of the entry
+ * directory, which is refreshed on each hit) when the total size exceeds
+ * `Config::kernelCacheSize()`. The total size is kept in a file (`.size`)
+ * updated on each publish, so the whole cache is only scanned when it exceeds
+ * the limit
+ */
+class KernelCache {
+  public:
+    /**
+     * Make the cache key of a compilation
+     *
+     * If any argument resolves to the host (e.g. `-march=native`), the
+     * resolved host ISA is included as well
+     *
+     * @param src : The source code to compile
+     * @param executable : Path to the backend compiler
+     * @param args : Arguments to the backend compiler, excluding any path to
+     * temporary files
+     */
+    static std::string makeKey(const std::string &src,
+                               const std::string &executable,
+                               const std::vector<std::string> &args);
+
+    /**
+     * Look up a compiled kernel
+     *
+     * @param key : Key made by `makeKey`
+     * @param dst : Path to copy the cached shared object to on a hit
+     * @return : True on a hit
+     */
+    static bool lookup(const std::string &key, const std::string &dst);
+
+    /**
+     * Publish a newly compiled kernel, and evict old entries if needed
+     *
+     * Failures are reported as warnings and otherwise ignored, since the cache
+     * is only an optimization
+     *
+     * @param key : Key made by `makeKey`
+     * @param so : Path to the compiled shared object. It is copied, not moved
+     */
+    static void insert(const std::string &key, const std::string &so);
+
+    /**
+     * Look up an entry of arbitrary files, and use the files in place
+     *
+     * The files may be evicted by other processes at any time, so they can
+     * only be used as optional hints, e.g. precompiled headers
+     *
+     * @return : Path to the entry directory on a hit, or an empty string
+     */
+    static std::string lookupDir(const std::string &key);
+
+    /**
+     * Make a temporary directory in the cache directory, to be filled and then
+     * published by `insertDir`
+     *
+     * @return : Path to the directory, or an empty string if the cache is
+     * disabled or not writable
+     */
+    static std::string makeTempDir();
+
+    /**
+     * Publish a directory made by `makeTempDir`, and evict old entries if
+     * needed. The directory is moved into the cache, or removed if the entry
+     * has already been published by others
+     */
+    static void insertDir(const std::string &key, const std::string &tmp);
+
+    /**
+     * Remove all entries
+     */
+    static void clear();
+};
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_KERNEL_CACHE_H
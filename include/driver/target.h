@@ -31,18 +31,117 @@ class Target {
 
 class CPUTarget : public Target {
     bool useNativeArch_;
-    // TODO: infoArch
 
-  public:
-    CPUTarget(bool useNativeArch = true) : useNativeArch_(useNativeArch) {}
+    // Cache hierarchy, in bytes. 0 for absent levels
+    size_t l1DataCacheSize_, l2CacheSize_, l3CacheSize_;
+    int cacheLineSize_;
 
-    void setUseNativeArch(bool useNativeArch = true) {
-        useNativeArch_ = useNativeArch;
-    }
+    // SIMD
+    std::string isa_;
+    int vectorBytes_;
+
+    // Topology
+    int physicalCores_, threadsPerCore_, numaNodes_;
+
+    // Runtime of parallel loops
+    bool useThreadPool_ = false;
+
+    bool useNativeGEMM_ = false;
+
+  public:
+    /**
+     * Construct a target of the host CPU
+     *
+     * The cache hierarchy and the topology are detected from `/sys` on Linux.
+     * The SIMD ISA is detected with `cpuid` if using the native architecture,
+     * or set to the baseline of the architecture (SSE2 or NEON) otherwise.
+     * All of them can be overridden with the setters, e.g. to tune for
+     * another machine
+     */
+    CPUTarget(bool useNativeArch = true);
+
+    /**
+     * Set whether to use the native architecture, and re-detect the SIMD ISA
+     * accordingly
+     */
+    void setUseNativeArch(bool useNativeArch = true);
     bool useNativeArch() const override { return useNativeArch_; }
     TargetType type() const override { return TargetType::CPU; }
     std::string toString() const override { return "CPU"; }
     MemType mainMemType() const override { return MemType::CPU; }
+
+    size_t l1DataCacheSize() const { return l1DataCacheSize_; }
+    size_t l2CacheSize() const { return l2CacheSize_; }
+    size_t l3CacheSize() const { return l3CacheSize_; }
+    int cacheLineSize() const { return cacheLineSize_; }
+    void setL1DataCacheSize(size_t size) { l1DataCacheSize_ = size; }
+    void setL2CacheSize(size_t size) { l2CacheSize_ = size; }
+    void setL3CacheSize(size_t size) { l3CacheSize_ = size; }
+
+    /**
+     * Set the cache line size. It is used as an alignment, so it should be a
+     * positive power of 2
+     */
+    void setCacheLineSize(int size);
+
+    /**
+     * SIMD instruction set: "avx512", "avx2", "avx", "sse2", "neon", or
+     * "generic"
+     */
+    const std::string &isa() const { return isa_; }
+
+    /**
+     * Width of SIMD registers in bytes, for explicit vectorization
+     */
+    int vectorBytes() const { return vectorBytes_; }
+
+    /**
+     * Number of architectural SIMD registers
+     */
+    int vectorRegisters() const;
+
+    /**
+     * Set the SIMD ISA, and the vector width to its register width
+     */
+    void setISA(const std::string &isa);
+
+    int physicalCores() const { return physicalCores_; }
+    int threadsPerCore() const { return threadsPerCore_; }
+    int numaNodes() const { return numaNodes_; }
+    int hardwareThreads() const { return physicalCores_ * threadsPerCore_; }
+
+    /**
+     * Set the topology. Each of them should be positive
+     *
+     * @{
+     */
+    void setPhysicalCores(int n);
+    void setThreadsPerCore(int n);
+    void setNUMANodes(int n);
+    /** @} */
+
+    /**
+     * Run parallel loops with FreeTensor's work-stealing thread pool (see
+     * `runtime/cpu_thread_pool.h`) instead of OpenMP
+     *
+     * The pool is shared by all programs in a process, and each `Driver` can
+     * have its own thread budget, so concurrent programs do not oversubscribe
+     * the cores. Nested parallel loops are also run in parallel
+     */
+    bool useThreadPool() const { return useThreadPool_; }
+    void setUseThreadPool(bool useThreadPool = true) {
+        useThreadPool_ = useThreadPool;
+    }
+
+    /**
+     * Run `MatMul` with FreeTensor's built-in GEMM (see `runtime/cpu_gemm.h`)
+     * even if built with MKL, e.g. to compare with MKL. The built-in GEMM is
+     * always used if not built with MKL
+     */
+    bool useNativeGEMM() const { return useNativeGEMM_; }
+    void setUseNativeGEMM(bool useNativeGEMM = true) {
+        useNativeGEMM_ = useNativeGEMM;
+    }
 };
 
 #ifdef FT_WITH_CUDA
@@ -1,12 +1,21 @@
 #ifndef FREE_TENSOR_HASH_COMBINE_H
 #define FREE_TENSOR_HASH_COMBINE_H
 
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 
 namespace freetensor {
 
 size_t hashCombine(size_t seed, size_t other);
 
-}
+/**
+ * 64-bit FNV-1a. Unlike std::hash, its result is stable across builds, so it
+ * can be used in file names or persisted
+ */
+uint64_t stableHash(const std::string &str,
+                    uint64_t h = 0xcbf29ce484222325ull);
+
+} // namespace freetensor
 
 #endif // FREE_TENSOR_HASH_COMBINE_H
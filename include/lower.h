@@ -7,6 +7,7 @@
 #include <config.h>
 #include <driver/target.h>
 #include <pass/cpu/lower_parallel_reduction.h>
+#include <pass/cpu/lower_vector.h>
 #include <pass/float_simplify.h>
 #include <pass/gpu/lower_parallel_reduction.h>
 #include <pass/gpu/lower_vector.h>
@@ -35,26 +36,12 @@
 namespace freetensor {
 
 /**
- * Lower an AST using a series of passes
- *
- * @param ast : The AST to be lowered. Can be a `Func` or a `Stmt`
- * @param target : Lower the AST to a target with target-specific
- * passes, then the AST can be used for codegen. If not set, use the default
- * Target in Config
- * @param skipPasses : Skip some pass for testing or debugging. Names in
- * `skipPasses` are in underscore_style, as in Python. Please note that some
- * passes will not be skipped even specified in these parameter, because they
- * are indirectly called in some other passes
- * @param verbose : 0 = print nothing. 1 = print the lowered AST. 2 = print AST
- * after every single passes
+ * Run all the passes of `lower` on a whole AST. Parameters are the same as
+ * `lower`, except that `target` must be set
  */
 template <class T>
-T lower(const T &_ast, const Ref<Target> &_target = nullptr,
-        const std::unordered_set<std::string> &skipPasses = {},
-        int verbose = 0) {
-
-    auto target = _target.isValid() ? _target : Config::defaultTarget();
-
+T lowerWhole(const T &_ast, const Ref<Target> &target,
+             const std::unordered_set<std::string> &skipPasses, int verbose) {
     auto maybePrint = [&](const std::string &name, const T &ast) -> T {
         if (verbose >= 2) {
             logger() << "AST after " << name << " is:" << std::endl
@@ -113,8 +100,10 @@ T lower(const T &_ast, const Ref<Target> &_target = nullptr,
 
     case TargetType::CPU:
         ast = APPLY("cpu_lower_parallel_reduction", cpu::lowerParallelReduction,
-                    ast);
+                    ast, target.as<CPUTarget>());
         ast = APPLY("make_heap_alloc", makeHeapAlloc, ast);
+        ast = APPLY("cpu_lower_vector", cpu::lowerVector, ast,
+                    target.as<CPUTarget>()); // After make_heap_alloc
         ast = APPLY("use_builtin_div", useBuiltinDiv, ast);
         break;
 
@@ -132,6 +121,76 @@ T lower(const T &_ast, const Ref<Target> &_target = nullptr,
     return ast;
 }
 
+/**
+ * Counters of incremental lowering in this process
+ */
+struct LowerCacheStats {
+    size_t nHit_ = 0;      /// Number of statements found lowered in the cache
+    size_t nMiss_ = 0;     /// Number of statements lowered
+    size_t nFallback_ = 0; /// Number of programs lowered as a whole instead
+    size_t entries_ = 0;   /// Number of statements in the cache
+    size_t bytes_ = 0;     /// Estimated bytes of statements in the cache
+};
+
+LowerCacheStats lowerCacheStats();
+
+/**
+ * Drop all cached results of incremental lowering
+ */
+void clearLowerCache();
+
+/**
+ * Lower an AST incrementally, reusing lowered statements of previous `lower`s
+ *
+ * The program is split into top-level statements in the scope of its I/O
+ * variables, and each statement is lowered separately in that scope (with
+ * `output` variables treated as `inout`, since their values may be used by
+ * other statements). Lowered statements are cached by the statement together
+ * with the definitions of the scope, so when lowering many programs that
+ * share most of their statements (e.g. candidates in auto-scheduling), only
+ * the changed ones are lowered again
+ *
+ * Optimizations across the top-level statements are not performed. If the
+ * program can not be split, or the passes alter the scope, the program is
+ * lowered as a whole
+ *
+ * Enabled in `lower` by `Config::lowerCacheSize`
+ */
+Stmt lowerIncremental(const Stmt &ast, const Ref<Target> &target,
+                      const std::unordered_set<std::string> &skipPasses,
+                      int verbose);
+
+/**
+ * Lower an AST using a series of passes
+ *
+ * @param ast : The AST to be lowered. Can be a `Func` or a `Stmt`
+ * @param target : Lower the AST to a target with target-specific
+ * passes, then the AST can be used for codegen. If not set, use the default
+ * Target in Config
+ * @param skipPasses : Skip some pass for testing or debugging. Names in
+ * `skipPasses` are in underscore_style, as in Python. Please note that some
+ * passes will not be skipped even specified in these parameter, because they
+ * are indirectly called in some other passes
+ * @param verbose : 0 = print nothing. 1 = print the lowered AST. 2 = print AST
+ * after every single passes
+ */
+template <class T>
+T lower(const T &ast, const Ref<Target> &_target = nullptr,
+        const std::unordered_set<std::string> &skipPasses = {},
+        int verbose = 0) {
+    auto target = _target.isValid() ? _target : Config::defaultTarget();
+    if (Config::lowerCacheSize() > 0) {
+        if constexpr (std::is_same_v<T, Func>) {
+            return makeFunc(
+                ast->name_, ast->params_, ast->returns_,
+                lowerIncremental(ast->body_, target, skipPasses, verbose));
+        } else {
+            return lowerIncremental(ast, target, skipPasses, verbose);
+        }
+    }
+    return lowerWhole(ast, target, skipPasses, verbose);
+}
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_LOWER_H
@@ -1,7 +1,9 @@
 #ifndef FREE_TENSOR_PRESBURGER_H
 #define FREE_TENSOR_PRESBURGER_H
 
+#include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -40,14 +42,88 @@ template <class T> T *MOVE_ISL_PTR(T *&ptr) {
     return ret;
 }
 
+/**
+ * Convert a string returned by ISL, and free it
+ */
+inline std::string takeIslStr(char *str) {
+    if (str == nullptr) {
+        return "";
+    }
+    std::string ret = str;
+    free(str);
+    return ret;
+}
+
+struct PBStats {
+    size_t nCtxAlloc_ = 0;   /// Number of `isl_ctx` allocated
+    size_t nCtxReuse_ = 0;   /// Number of `isl_ctx` reused from the pools
+    size_t nMemoHit_ = 0;    /// Number of operations found in `PBMemo`
+    size_t nMemoMiss_ = 0;   /// Number of operations not found in `PBMemo`
+    size_t nMemoEvict_ = 0;  /// Number of results evicted from `PBMemo`
+    size_t memoEntries_ = 0; /// Number of results in `PBMemo`
+    size_t memoBytes_ = 0;   /// Bytes of results in `PBMemo`
+};
+
+/**
+ * Counters of the `isl_ctx` pools and `PBMemo`
+ */
+PBStats pbStats();
+
+/**
+ * Memoized results of expensive Presburger operations (emptiness checks,
+ * lexmin / lexmax, projections), shared by all threads
+ *
+ * Dependence analysis and simplification derive the same small maps again and
+ * again, each time in a new `PBCtx`. Since ISL objects cannot be shared across
+ * `isl_ctx`s, the operands and the results are memoized as strings, which ISL
+ * prints deterministically for the same object
+ *
+ * The total size is limited by `Config::pbMemoSize()`, beyond which the least
+ * recently used results are evicted. The table is sharded to avoid contention
+ *
+ * This class is thread-safe
+ */
+class PBMemo {
+  public:
+    static bool enabled();
+
+    static std::optional<std::string> lookup(const std::string &key);
+    static void save(const std::string &key, const std::string &result);
+
+    /**
+     * Look up `key`, or call `compute` and save its result if not found
+     */
+    template <class F>
+    static std::string memoize(const std::string &key, F &&compute) {
+        if (auto ret = lookup(key); ret.has_value()) {
+            return *ret;
+        }
+        std::string ret = compute();
+        save(key, ret);
+        return ret;
+    }
+
+    static void clear();
+};
+
+/**
+ * Context of Presburger objects
+ *
+ * Allocating an `isl_ctx` initializes all its options and tables, which costs
+ * more than many small operations. `PBCtx` takes an `isl_ctx` from a pool of
+ * the current thread, and puts it back when destructed. An `isl_ctx` is not
+ * used by more than one `PBCtx` at a time, so it is still safe for `PBCtx`s to
+ * run in parallel
+ */
 class PBCtx {
     isl_ctx *ctx_ = nullptr;
 
+    static isl_ctx *acquire();
+    static void release(isl_ctx *ctx);
+
   public:
-    PBCtx() : ctx_(isl_ctx_alloc()) {
-        isl_options_set_on_error(ctx_, ISL_ON_ERROR_ABORT);
-    }
-    ~PBCtx() { isl_ctx_free(ctx_); }
+    PBCtx() : ctx_(acquire()) {}
+    ~PBCtx() { release(ctx_); }
 
     PBCtx(const PBCtx &other) = delete;
     PBCtx &operator=(const PBCtx &other) = delete;
@@ -99,6 +175,12 @@ class PBMap {
 
     bool empty() const {
         DEBUG_PROFILE("empty");
+        if (PBMemo::enabled()) {
+            auto key = "empty " + takeIslStr(isl_map_to_str(get()));
+            return PBMemo::memoize(key, [this]() {
+                       return isl_map_is_empty(get()) ? "1" : "0";
+                   }) == "1";
+        }
         return isl_map_is_empty(get());
     }
     bool isSingleValued() const { return isl_map_is_single_valued(get()); }
@@ -111,7 +193,7 @@ class PBMap {
     isl_size nParamDims() const { return isl_map_dim(map_, isl_dim_param); }
 
     friend std::ostream &operator<<(std::ostream &os, const PBMap &map) {
-        return os << isl_map_to_str(map.map_);
+        return os << takeIslStr(isl_map_to_str(map.map_));
     }
 };
 
@@ -156,7 +238,7 @@ class PBVal {
     int denSi() const { return isl_val_get_den_si(get()); }
 
     friend std::ostream &operator<<(std::ostream &os, const PBVal &val) {
-        return os << isl_val_to_str(val.val_);
+        return os << takeIslStr(isl_val_to_str(val.val_));
     }
 };
 
@@ -204,6 +286,12 @@ class PBSet {
 
     bool empty() const {
         DEBUG_PROFILE("empty");
+        if (PBMemo::enabled()) {
+            auto key = "empty " + takeIslStr(isl_set_to_str(get()));
+            return PBMemo::memoize(key, [this]() {
+                       return isl_set_is_empty(get()) ? "1" : "0";
+                   }) == "1";
+        }
         return isl_set_is_empty(get());
     }
 
@@ -212,7 +300,7 @@ class PBSet {
     isl_size nDims() const { return isl_set_dim(set_, isl_dim_set); }
 
     friend std::ostream &operator<<(std::ostream &os, const PBSet &set) {
-        return os << isl_set_to_str(set.set_);
+        return os << takeIslStr(isl_set_to_str(set.set_));
     }
 };
 
@@ -261,7 +349,7 @@ class PBSpace {
     }
 
     friend std::ostream &operator<<(std::ostream &os, const PBSpace &space) {
-        return os << isl_space_to_str(space.space_);
+        return os << takeIslStr(isl_space_to_str(space.space_));
     }
 };
 
@@ -304,7 +392,7 @@ class PBFunc {
     isl_pw_multi_aff *move() { return MOVE_ISL_PTR(func_); }
 
     friend std::ostream &operator<<(std::ostream &os, const PBFunc &func) {
-        return os << isl_pw_multi_aff_to_str(func.func_);
+        return os << takeIslStr(isl_pw_multi_aff_to_str(func.func_));
     }
 };
 
@@ -378,24 +466,92 @@ template <typename T> auto PBRefTake(std::remove_reference_t<T> &&t) {
     return t.move();
 }
 
+namespace detail {
+
+/**
+ * Run an operation on a map, set or value via `PBMemo`
+ *
+ * @{
+ */
+template <PBMapRef T, class F>
+PBMap memoizedMapOp(const std::string &name, T &&map, F &&op) {
+    if (!PBMemo::enabled()) {
+        return op(PBRefTake<T>(map));
+    }
+    auto key = name + " " + takeIslStr(isl_map_to_str(map.get()));
+    if (auto str = PBMemo::lookup(key); str.has_value()) {
+        return isl_map_read_from_str(isl_map_get_ctx(map.get()), str->c_str());
+    }
+    PBMap ret = op(PBRefTake<T>(map));
+    PBMemo::save(key, takeIslStr(isl_map_to_str(ret.get())));
+    return ret;
+}
+template <PBSetRef T, class F>
+PBSet memoizedSetOp(const std::string &name, T &&set, F &&op) {
+    if (!PBMemo::enabled()) {
+        return op(PBRefTake<T>(set));
+    }
+    auto key = name + " " + takeIslStr(isl_set_to_str(set.get()));
+    if (auto str = PBMemo::lookup(key); str.has_value()) {
+        return isl_set_read_from_str(isl_set_get_ctx(set.get()), str->c_str());
+    }
+    PBSet ret = op(PBRefTake<T>(set));
+    PBMemo::save(key, takeIslStr(isl_set_to_str(ret.get())));
+    return ret;
+}
+template <PBSetRef T, class F>
+PBVal memoizedValOp(const std::string &name, T &&set, F &&op) {
+    if (!PBMemo::enabled()) {
+        return op(PBRefTake<T>(set));
+    }
+    auto key = name + " " + takeIslStr(isl_set_to_str(set.get()));
+    if (auto str = PBMemo::lookup(key); str.has_value()) {
+        return isl_val_read_from_str(isl_set_get_ctx(set.get()), str->c_str());
+    }
+    PBVal ret = op(PBRefTake<T>(set));
+    PBMemo::save(key, takeIslStr(isl_val_to_str(ret.get())));
+    return ret;
+}
+/** @} */
+
+} // namespace detail
+
 template <PBSetRef T> PBSet projectOutAllParams(T &&set) {
-    return isl_set_project_out_all_params(PBRefTake<T>(set));
+    return detail::memoizedSetOp(
+        "projectOutAllParams", std::forward<T>(set),
+        [](isl_set *x) { return isl_set_project_out_all_params(x); });
 }
 template <PBMapRef T> PBMap projectOutAllParams(T &&map) {
-    return isl_map_project_out_all_params(PBRefTake<T>(map));
+    return detail::memoizedMapOp(
+        "projectOutAllParams", std::forward<T>(map),
+        [](isl_map *x) { return isl_map_project_out_all_params(x); });
 }
 
 template <PBSetRef T>
 PBSet projectOutDims(T &&set, unsigned first, unsigned n) {
-    return isl_set_project_out(PBRefTake<T>(set), isl_dim_set, first, n);
+    return detail::memoizedSetOp(
+        "projectOutDims " + std::to_string(first) + " " + std::to_string(n),
+        std::forward<T>(set), [&](isl_set *x) {
+            return isl_set_project_out(x, isl_dim_set, first, n);
+        });
 }
 template <PBMapRef T>
 PBMap projectOutInputDims(T &&map, unsigned first, unsigned n) {
-    return isl_map_project_out(PBRefTake<T>(map), isl_dim_in, first, n);
+    return detail::memoizedMapOp(
+        "projectOutInputDims " + std::to_string(first) + " " +
+            std::to_string(n),
+        std::forward<T>(map), [&](isl_map *x) {
+            return isl_map_project_out(x, isl_dim_in, first, n);
+        });
 }
 template <PBMapRef T>
 PBMap projectOutOutputDims(T &&map, unsigned first, unsigned n) {
-    return isl_map_project_out(PBRefTake<T>(map), isl_dim_out, first, n);
+    return detail::memoizedMapOp(
+        "projectOutOutputDims " + std::to_string(first) + " " +
+            std::to_string(n),
+        std::forward<T>(map), [&](isl_map *x) {
+            return isl_map_project_out(x, isl_dim_out, first, n);
+        });
 }
 
 template <PBSetRef T> PBSet insertDims(T &&set, unsigned first, unsigned n) {
@@ -563,22 +719,30 @@ template <PBSetRef T> PBSet neg(T &&lhs) {
 
 template <PBMapRef T> PBMap lexmax(T &&map) {
     DEBUG_PROFILE_VERBOSE("lexmax", "nBasic=" + std::to_string(map.nBasic()));
-    return isl_map_lexmax(PBRefTake<T>(map));
+    return detail::memoizedMapOp(
+        "lexmax", std::forward<T>(map),
+        [](isl_map *x) { return isl_map_lexmax(x); });
 }
 
 template <PBMapRef T> PBMap lexmin(T &&map) {
     DEBUG_PROFILE_VERBOSE("lexmin", "nBasic=" + std::to_string(map.nBasic()));
-    return isl_map_lexmin(PBRefTake<T>(map));
+    return detail::memoizedMapOp(
+        "lexmin", std::forward<T>(map),
+        [](isl_map *x) { return isl_map_lexmin(x); });
 }
 
 template <PBSetRef T> PBSet lexmax(T &&set) {
     DEBUG_PROFILE_VERBOSE("lexmax", "nBasic=" + std::to_string(set.nBasic()));
-    return isl_set_lexmax(PBRefTake<T>(set));
+    return detail::memoizedSetOp(
+        "lexmax", std::forward<T>(set),
+        [](isl_set *x) { return isl_set_lexmax(x); });
 }
 
 template <PBSetRef T> PBSet lexmin(T &&set) {
     DEBUG_PROFILE_VERBOSE("lexmin", "nBasic=" + std::to_string(set.nBasic()));
-    return isl_set_lexmin(PBRefTake<T>(set));
+    return detail::memoizedSetOp(
+        "lexmin", std::forward<T>(set),
+        [](isl_set *x) { return isl_set_lexmin(x); });
 }
 
 template <PBSpaceRef T> PBMap identity(T &&space) {
@@ -650,11 +814,15 @@ template <PBMapRef T> PBMap coalesce(T &&map) {
 }
 
 template <PBSetRef T> PBVal dimMaxVal(T &&set, int pos) {
-    return isl_set_dim_max_val(PBRefTake<T>(set), pos);
+    return detail::memoizedValOp(
+        "dimMaxVal " + std::to_string(pos), std::forward<T>(set),
+        [&](isl_set *x) { return isl_set_dim_max_val(x, pos); });
 }
 
 template <PBSetRef T> PBVal dimMinVal(T &&set, int pos) {
-    return isl_set_dim_min_val(PBRefTake<T>(set), pos);
+    return detail::memoizedValOp(
+        "dimMinVal " + std::to_string(pos), std::forward<T>(set),
+        [&](isl_set *x) { return isl_set_dim_min_val(x, pos); });
 }
 
 template <PBSpaceRef T> PBSpace spaceMapFromSet(T &&space) {
@@ -17,12 +17,90 @@ inline bool operator==(const SerialScope &lhs, const SerialScope &rhs) {
     return true;
 }
 
-struct OpenMPScope {};
+/**
+ * A loop run by OpenMP (or by `ThreadPool`, see `CPUTarget::useThreadPool`)
+ *
+ * The schedule kind, chunk size and number of threads are passed to OpenMP's
+ * `schedule` and `num_threads` clauses. Defaults leave the decision to OpenMP
+ */
+struct OpenMPScope {
+    enum Schedule { Default, Static, Dynamic, Guided } schedule_ = Default;
+    int chunk_ = 0;      /// Iterations per chunk. 0 for default
+    int numThreads_ = 0; /// 0 for default
+
+    bool isDefault() const {
+        return schedule_ == Default && chunk_ == 0 && numThreads_ == 0;
+    }
+};
 inline bool operator==(const OpenMPScope &lhs, const OpenMPScope &rhs) {
-    return true;
+    return lhs.schedule_ == rhs.schedule_ && lhs.chunk_ == rhs.chunk_ &&
+           lhs.numThreads_ == rhs.numThreads_;
+}
+inline std::ostream &operator<<(std::ostream &os,
+                                const OpenMPScope::Schedule &schedule) {
+    switch (schedule) {
+    case OpenMPScope::Default:
+        return os << "default";
+    case OpenMPScope::Static:
+        return os << "static";
+    case OpenMPScope::Dynamic:
+        return os << "dynamic";
+    case OpenMPScope::Guided:
+        return os << "guided";
+    default:
+        ASSERT(false);
+    }
 }
 inline std::ostream &operator<<(std::ostream &os, const OpenMPScope &parallel) {
-    return os << "openmp";
+    os << "openmp";
+    if (!parallel.isDefault()) {
+        // No spaces, so it is still a single token when serialized
+        os << "(" << parallel.schedule_ << "," << parallel.chunk_ << ","
+           << parallel.numThreads_ << ")";
+    }
+    return os;
+}
+
+inline OpenMPScope::Schedule parseOpenMPSchedule(const std::string &_str) {
+    auto &&str = tolower(_str);
+    for (auto &&schedule : {OpenMPScope::Default, OpenMPScope::Static,
+                            OpenMPScope::Dynamic, OpenMPScope::Guided}) {
+        if (str == toString(schedule)) {
+            return schedule;
+        }
+    }
+    ERROR("Unrecognized OpenMP schedule " + _str);
+}
+
+/**
+ * Make an `OpenMPScope`, rejecting negative chunk sizes or numbers of threads
+ */
+inline OpenMPScope makeOpenMPScope(OpenMPScope::Schedule schedule, int chunk,
+                                   int numThreads) {
+    if (chunk < 0) {
+        ERROR("Chunk size of an OpenMP loop should not be negative, got " +
+              std::to_string(chunk));
+    }
+    if (numThreads < 0) {
+        ERROR("Number of threads of an OpenMP loop should not be negative, "
+              "got " +
+              std::to_string(numThreads));
+    }
+    return OpenMPScope{schedule, chunk, numThreads};
+}
+
+/**
+ * Iterations of a loop run as concurrent OpenMP tasks (or `ThreadPool` tasks,
+ * see `CPUTarget::useThreadPool`), one per iteration. See
+ * `Schedule::parallelizeAsTasks`
+ */
+struct OpenMPTaskScope {};
+inline bool operator==(const OpenMPTaskScope &lhs, const OpenMPTaskScope &rhs) {
+    return true;
+}
+inline std::ostream &operator<<(std::ostream &os,
+                                const OpenMPTaskScope &parallel) {
+    return os << "openmp_task";
 }
 
 struct CUDAStreamScope {};
@@ -69,7 +147,8 @@ inline std::ostream &operator<<(std::ostream &os, const CUDAScope &parallel) {
 }
 
 // The first type is default
-typedef std::variant<SerialScope, OpenMPScope, CUDAStreamScope, CUDAScope>
+typedef std::variant<SerialScope, OpenMPScope, CUDAStreamScope, CUDAScope,
+                     OpenMPTaskScope>
     ParallelScope;
 
 inline std::ostream &operator<<(std::ostream &os,
@@ -82,6 +161,8 @@ inline std::ostream &operator<<(std::ostream &os,
         return os << std::get<CUDAScope>(parallel);
     } else if (std::holds_alternative<CUDAStreamScope>(parallel)) {
         return os << std::get<CUDAStreamScope>(parallel);
+    } else if (std::holds_alternative<OpenMPTaskScope>(parallel)) {
+        return os << std::get<OpenMPTaskScope>(parallel);
     } else {
         ASSERT(false);
     }
@@ -95,6 +176,25 @@ inline ParallelScope parseParallelScope(const std::string &_str) {
     if (auto scope = OpenMPScope{}; str == tolower(toString(scope))) {
         return scope;
     }
+    if (str.starts_with("openmp(") && str.ends_with(")")) {
+        // openmp(<schedule>,<chunk>,<num_threads>)
+        auto args = str.substr(7, str.length() - 8);
+        auto c1 = args.find(','), c2 = args.rfind(',');
+        if (c1 != std::string::npos && c2 != c1) {
+            int chunk, numThreads;
+            try {
+                chunk = std::stoi(args.substr(c1 + 1, c2 - c1 - 1));
+                numThreads = std::stoi(args.substr(c2 + 1));
+            } catch (const std::logic_error &) {
+                ERROR("Unrecognized parallel scope " + _str);
+            }
+            return makeOpenMPScope(parseOpenMPSchedule(args.substr(0, c1)),
+                                   chunk, numThreads);
+        }
+    }
+    if (auto scope = OpenMPTaskScope{}; str == tolower(toString(scope))) {
+        return scope;
+    }
     if (auto scope = CUDAStreamScope{}; str == tolower(toString(scope))) {
         return scope;
     }
@@ -127,7 +227,16 @@ template <> struct hash<freetensor::SerialScope> {
 };
 
 template <> struct hash<freetensor::OpenMPScope> {
-    size_t operator()(const freetensor::OpenMPScope &) { return 0; }
+    size_t operator()(const freetensor::OpenMPScope &parallel) {
+        return freetensor::hashCombine(
+            freetensor::hashCombine(std::hash<int>()((int)parallel.schedule_),
+                                    std::hash<int>()(parallel.chunk_)),
+            std::hash<int>()(parallel.numThreads_));
+    }
+};
+
+template <> struct hash<freetensor::OpenMPTaskScope> {
+    size_t operator()(const freetensor::OpenMPTaskScope &) { return 0; }
 };
 
 template <> struct hash<freetensor::CUDAStreamScope> {
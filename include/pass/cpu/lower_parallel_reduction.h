@@ -4,22 +4,107 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include <analyze/comp_transient_bounds.h>
+#include <analyze/comp_unique_bounds.h>
 #include <analyze/symbol_table.h>
+#include <driver/target.h>
 #include <func.h>
 #include <mutator.h>
+#include <visitor.h>
 
 namespace freetensor {
 
 namespace cpu {
 
+/**
+ * A variable reduced in a parallel loop, to be accumulated in a private buffer
+ * of each thread, and merged after the loop
+ */
+struct PrivatizedReduction {
+    std::string var_;
+    ReduceOp op_;
+    std::vector<Expr> begins_, shape_; // Privatized region of the variable
+    int padding_; // Round the slice of each thread in the private buffer up
+                  // to a multiple of it, to avoid false sharing
+};
+
+/**
+ * Decide which reductions in outermost OpenMP parallel loops are privatized
+ *
+ * Atomic reductions are privatized if the contention is high, i.e. if each
+ * element is updated by many iterations. Reductions lowered to OpenMP's
+ * `reduction` clause are privatized only if they use different operators,
+ * which the clause does not support
+ */
+class FindPrivatizedReductions
+    : public CompTransientBounds<SymbolTable<Visitor>> {
+    typedef CompTransientBounds<SymbolTable<Visitor>> BaseClass;
+
+    struct VarInfo {
+        std::unordered_set<ReduceOp> ops_;
+        bool synced_ = false, accessed_ = false;
+        int64_t updates_ = 0; // Estimated number of executed ReduceTo nodes
+    };
+
+    CompUniqueBounds unique_;
+    Ref<CPUTarget> target_;
+
+    For loop_; // The outermost parallel loop being visited
+    bool nestedParallel_ = false;
+    std::unordered_set<std::string> defsInLoop_;
+    std::unordered_map<std::string, VarInfo> vars_;
+    int64_t weight_ = 1; // Trip count of the enclosing loops in `loop_`
+
+    std::unordered_map<ID, std::vector<PrivatizedReduction>>
+        results_; // Loop ID -> reductions
+
+  public:
+    FindPrivatizedReductions(const Ref<CPUTarget> &target)
+        : unique_(*this), target_(target) {}
+
+    const auto &results() const { return results_; }
+
+    /**
+     * Number of threads, i.e. private buffers, of a parallel loop
+     */
+    int numThreads(const For &loop) const;
+
+  private:
+    int64_t tripCount(const Expr &len);
+    int64_t numElements(const std::vector<Expr> &shape);
+    void decide();
+
+  protected:
+    using BaseClass::visit;
+    void visit(const VarDef &op) override;
+    void visit(const For &op) override;
+    void visit(const Load &op) override;
+    void visit(const Store &op) override;
+    void visit(const ReduceTo &op) override;
+};
+
 class LowerParallelReduction : public SymbolTable<Mutator> {
     typedef SymbolTable<Mutator> BaseClass;
 
+    const FindPrivatizedReductions &privatization_;
+
     std::vector<For> loopStack_;
 
+    // Privatized variable -> (private buffer, privatized region)
+    std::unordered_map<std::string, std::pair<std::string, PrivatizedReduction>>
+        private_;
+    Expr thread_; // Index of the private buffers
+
+  public:
+    LowerParallelReduction(const FindPrivatizedReductions &privatization)
+        : privatization_(privatization) {}
+
   private:
     std::vector<std::pair<For, int>> reducedBy(const ReduceTo &op);
 
+    Stmt privatize(const For &op,
+                   const std::vector<PrivatizedReduction> &reductions);
+
   protected:
     using BaseClass::visit;
     Stmt visit(const For &op) override;
@@ -30,8 +115,18 @@ class LowerParallelReduction : public SymbolTable<Mutator> {
  * Although parallel reduction enjoys a native support by OpenMP, it does not
  * support using parallel reduction and atomic reduction simulteneously.
  * Therefore, we need to make some transformations
+ *
+ * Besides, reductions with high contention, e.g. in histogram-like or
+ * scatter-add kernels, or with operators that OpenMP cannot reduce together,
+ * are privatized: The parallel loop is split into one chunk per thread, each
+ * chunk reduces to a private buffer, and the buffers are merged by another
+ * parallel loop over the elements, without any atomic operation
+ *
+ * @param target : Target CPU, to decide the number of private buffers. The
+ * host CPU if null
  */
-Stmt lowerParallelReduction(const Stmt &op);
+Stmt lowerParallelReduction(const Stmt &op,
+                            const Ref<CPUTarget> &target = nullptr);
 
 DEFINE_PASS_FOR_FUNC(lowerParallelReduction)
 
@@ -0,0 +1,69 @@
+#ifndef FREE_TENSOR_CPU_LOWER_VECTOR_H
+#define FREE_TENSOR_CPU_LOWER_VECTOR_H
+
+#include <driver/target.h>
+#include <func.h>
+#include <pass/z3_simplify.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+class LowerVector : public Z3SimplifyWithSymbolTable {
+    typedef Z3SimplifyWithSymbolTable BaseClass;
+
+    int vecBytes_;
+
+    // States of the loop being lowered
+    std::string iter_;
+    Expr base_; // Value of the iterator in the first lane
+    Expr rem_;  // Number of active lanes in the masked tail, or null
+    DataType dtype_;
+    int vecLen_ = 0;
+
+  public:
+    LowerVector(int vecBytes) : vecBytes_(vecBytes) {}
+
+  private:
+    std::string vecType() const;
+    bool isInvariant(const Expr &expr) const;
+    void checkContiguous(const std::vector<Expr> &indices) const;
+    std::vector<Expr> laneZeroIndices(const std::vector<Expr> &indices) const;
+    bool isAligned(const std::string &var, const std::vector<Expr> &indices);
+
+    Expr genLoad(const std::string &var, const std::vector<Expr> &indices);
+    Stmt genStore(const std::string &var, const std::vector<Expr> &indices,
+                  const Expr &vec);
+
+    Expr vectorize(const Expr &expr);
+    Stmt vectorize(const Stmt &stmt);
+    Stmt lowerLoop(const For &op);
+
+  protected:
+    using BaseClass::visit;
+    Stmt visit(const For &op) override;
+};
+
+/**
+ * Lower vectorized innermost loops to explicit SIMD vectors
+ *
+ * A loop marked `vectorize` is lowered to a loop over vectors of the width of
+ * the target's SIMD registers, followed by a masked tail for the remaining
+ * iterations. Contiguous memory accesses are lowered to vector loads and
+ * stores (aligned ones if provable), and loop-invariant operands are
+ * broadcast. The vectors are GCC's vector extensions, defined in
+ * `runtime/cpu_runtime.h`
+ *
+ * Loops that cannot be lowered (e.g. with branches, non-contiguous accesses,
+ * or mixed data types) are left as is, and vectorized by the backend compiler
+ * with `#pragma omp simd`
+ */
+Stmt lowerVector(const Stmt &op, const Ref<CPUTarget> &target);
+
+DEFINE_PASS_FOR_FUNC(lowerVector)
+
+} // namespace cpu
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_CPU_LOWER_VECTOR_H
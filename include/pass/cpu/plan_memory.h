@@ -0,0 +1,110 @@
+#ifndef FREE_TENSOR_CPU_PLAN_MEMORY_H
+#define FREE_TENSOR_CPU_PLAN_MEMORY_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <analyze/comp_transient_bounds.h>
+#include <analyze/comp_unique_bounds.h>
+#include <analyze/symbol_table.h>
+#include <visitor.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+/**
+ * Placement of variables in the static workspaces of a CPU program
+ */
+struct MemoryPlan {
+    std::unordered_map<ID, int64_t> offset_; // VarDef ID -> offset in bytes
+    int64_t sharedSize_ = 0; // Bytes of the workspace shared by all threads
+    int64_t threadSize_ = 0; // Bytes of the workspace of each thread
+
+    bool planned(const ID &defId) const { return offset_.count(defId); }
+};
+
+class FindLiveRanges : public CompTransientBounds<SymbolTable<Visitor>> {
+    typedef CompTransientBounds<SymbolTable<Visitor>> BaseClass;
+
+  public:
+    struct Buffer {
+        ID id_;
+        int64_t size_;        // In bytes, rounded up to the alignment
+        bool perThread_;      // Defined inside a parallel loop
+        int64_t begin_, end_; // Live range, in the order of visiting
+        size_t loopDepth_;    // Number of loops outside of the VarDef
+    };
+
+  private:
+    CompUniqueBounds unique_;
+    int alignment_;
+    int64_t maxHeapBytes_;
+
+    int64_t time_ = 0;
+    std::vector<For> loops_;
+    std::unordered_map<ID, std::pair<int64_t, int64_t>> loopRange_;
+    int inParallel_ = 0;
+
+    std::vector<Buffer> buffers_;
+    std::unordered_map<ID, size_t> bufferIdx_; // VarDef ID -> index
+    std::unordered_map<ID, std::unordered_set<ID>>
+        extendTo_; // VarDef ID -> loops to cover
+
+  public:
+    FindLiveRanges(int alignment, int64_t maxHeapBytes)
+        : unique_(*this), alignment_(alignment), maxHeapBytes_(maxHeapBytes) {
+    }
+
+    /**
+     * Buffers with their live ranges extended to cover the loops they are
+     * used across
+     */
+    std::vector<Buffer> buffers() const;
+
+  private:
+    void use(const std::string &var);
+
+  protected:
+    using BaseClass::visit;
+    void visitStmt(const Stmt &op) override;
+    void visit(const VarDef &op) override;
+    void visit(const For &op) override;
+    void visit(const Load &op) override;
+    void visit(const Store &op) override;
+    void visit(const ReduceTo &op) override;
+    void visit(const Alloc &op) override;
+    void visit(const Free &op) override;
+};
+
+/**
+ * Plan the memory of stack-allocated and heap-allocated variables of a CPU
+ * program
+ *
+ * `CodeGenCPU` used to place variables in a stack discipline, so only sibling
+ * scopes shared memory, and each heap-allocated variable was allocated by
+ * `new` on every run. Instead, this pass computes the live range of each
+ * variable, and packs the variables with disjoint live ranges into the same
+ * memory of a static workspace, which is allocated once when the program is
+ * loaded. Variables defined in parallel loops are packed in a workspace of
+ * each thread
+ *
+ * A live range spans from the first to the last access of the variable, and
+ * covers any loop inside the `VarDef` that accesses the variable, because the
+ * value may be carried across iterations
+ *
+ * Heap-allocated variables whose sizes are bounded by constants are planned
+ * with their maximum sizes, unless larger than `maxHeapBytes`
+ *
+ * @param alignment : Alignment of each variable in bytes
+ * @param maxHeapBytes : Maximum size of a heap-allocated variable to plan
+ */
+MemoryPlan planMemory(const Stmt &op, int alignment,
+                      int64_t maxHeapBytes = 16ll << 20);
+
+} // namespace cpu
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_CPU_PLAN_MEMORY_H
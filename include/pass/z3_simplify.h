@@ -15,6 +15,27 @@
 
 namespace freetensor {
 
+struct Z3Stats {
+    size_t nQuery_ = 0;       /// Number of queries to prove
+    size_t nCacheHit_ = 0;    /// Number of queries answered by the cache
+    size_t nTimeout_ = 0;     /// Number of queries ended without a result
+    size_t nSkipped_ = 0;     /// Number of queries skipped for an exhausted
+                              /// budget
+    double solverTime_ = 0;   /// Total seconds spent in the solver
+    size_t cacheEntries_ = 0; /// Number of results in the cache
+    size_t cacheBytes_ = 0;   /// Bytes of results in the cache
+};
+
+/**
+ * Counters of `Z3Simplify` in this process
+ */
+Z3Stats z3Stats();
+
+/**
+ * Drop all cached results of `Z3Simplify`
+ */
+void clearZ3Cache();
+
 /**
  * Simplify the AST using Z3
  *
@@ -25,6 +46,13 @@ namespace freetensor {
  * x - x to x)
  * - It can deal with some more complex expressions, such as Mod
  * - It may take some more time
+ *
+ * To bound the time, each query is limited by `Config::z3QueryTimeout`, and
+ * all queries of one pass by `Config::z3PassBudget`. A query ending without a
+ * result proves nothing, so the expression is simply kept. Results of queries
+ * are cached in the process, keyed by the set of conditions and the expression
+ * to prove, so the same implications derived again in later passes (e.g. in
+ * every `lower` of similar programs) are not solved again
  */
 class Z3Simplify : public Mutator {
     typedef Mutator BaseClass;
@@ -54,8 +82,16 @@ class Z3Simplify : public Mutator {
     // We use std::optional because there is no z3::expr::expr()
     std::unordered_map<Expr, ExprInfo> z3Exprs_;
 
+    /// String forms of the conditions in the solver stack, for cache keys.
+    /// Empty for a condition not pushed to the solver
+    std::vector<std::string> stackKeys_;
+
+    unsigned queryTimeout_ = 0; /// In ms. 0 for unlimited
+    unsigned curTimeout_ = 0;   /// In ms. Currently set to the solver
+    std::optional<double> budgetLeft_; /// In seconds. nullopt for unlimited
+
   public:
-    Z3Simplify() : solver_(ctx_) {}
+    Z3Simplify();
 
   protected:
     int getVarId(const Expr &op);
@@ -88,6 +88,12 @@ template <class T> class Ref {
 
     bool isValid() const { return ptr_ != nullptr; }
 
+    /**
+     * Number of `Ref`s sharing the object. Only exact if the other `Ref`s are
+     * synchronized with the caller
+     */
+    long useCount() const { return ptr_.use_count(); }
+
     T &operator*() const {
         ASSERT(isValid());
         return *ptr_;
@@ -4,8 +4,10 @@
 #include <functional>
 #include <unordered_map>
 
+#include <analyze/deps_cache.h>
 #include <analyze/find_stmt.h>
 #include <auto_schedule/structs.h>
+#include <auto_schedule/tuning_record.h>
 #include <driver/target.h>
 #include <func.h>
 #include <probability/rand_ctx.h>
@@ -44,6 +46,7 @@ class Schedule {
     int verbose_ = 0;
 
     Ref<MemoizedSchedules> memoized_;
+    Ref<DepsCache> depsCache_;
 
     Ref<OpenMPRandomEngine> rng_;
     Ref<RandCtx<OpenMPRandomEngine>> randCtx_;
@@ -84,15 +87,22 @@ class Schedule {
      * schedule from `MemoizedSchedules`
      *
      * If a memoized log is found, the memoized schedule result (including
-     * exceptions, if any) can be reused. If not found, save the new log to
-     * `MemoziedSchedules`
+     * exceptions, if any) can be reused. If not found, or if the memoized
+     * result has been evicted, run and save the new log to `MemoziedSchedules`
      */
     template <class T> T appendLog(const T &_log) {
         auto log = _log;
         setLogs(memoized_->lookupOrCreate(logs().push(log)));
         ASSERT(logs().top()->type() == log->type());
         log = logs().top().as<typename decltype(log)::Object>();
-        log->run();
+        DepsCache::Scope depsCacheScope(depsCache_);
+        if (!log->run()) {
+            log = _log;
+            setLogs(logs().pop().push(log));
+            memoized_->replace(logs());
+            log->run();
+        }
+        memoized_->account(logs());
         return log;
     }
 
@@ -132,7 +142,9 @@ class Schedule {
      * the future
      *
      * The `fork`ed object shares the same `MemoizedSchedule` with the original
-     * one, so common decisions can be saved and reused
+     * one, so common decisions can be saved and reused. It also shares the
+     * same `DepsCache`, so dependences of unchanged parts of the program are
+     * not analyzed again
      *
      * The `fork`ed object shares the same `RandCtx` objects, so it can learn
      * from multiple scheduling trials
@@ -627,6 +639,23 @@ class Schedule {
      */
     void parallelize(const ID &loop, const ParallelScope &parallel);
 
+    /**
+     * Run consecutive independent statements as concurrent tasks on CPU
+     *
+     * The statements are wrapped in a new loop, each iteration of which runs
+     * one of them, and the loop is parallelized with `OpenMPTaskScope`. E.g.
+     * two independent matrix multiplications can then run at the same time,
+     * each using a part of the cores. OpenMP loops inside the statements run
+     * serially in the thread of their task
+     *
+     * @param stmts : IDs of the statements. They should be consecutive in the
+     * same block
+     * @throw InvalidSchedule if the statements are not found or not
+     * consecutive, or if there are dependences among them
+     * @return : ID of the new loop
+     */
+    ID parallelizeAsTasks(const std::vector<ID> &stmts);
+
     /**
      * Unroll a loop
      *
@@ -751,9 +780,20 @@ class Schedule {
      *
      * @param target : Target architecture
      * @param trace : Random decision tarce
+     * @param records : If set, and a record of the same program on the same
+     * target is found, apply the best record instead of any heuristics
      */
     void autoSchedule(const Ref<Target> &target,
-                      const Ref<RandTrace> &trace = nullptr);
+                      const Ref<RandTrace> &trace = nullptr,
+                      const Ref<TuningRecordDB> &records = nullptr);
+
+    /**
+     * Replace the program with a scheduled one from a tuning record
+     *
+     * The record should be of the same program, which is not checked. The
+     * schedule log is not restored
+     */
+    void applyTuningRecord(const TuningRecord &record);
 
     /**
      * (Experimental) Automatically use external libs using some heuristics
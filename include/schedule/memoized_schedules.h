@@ -1,8 +1,10 @@
 #ifndef FREE_TENSOR_MEMORIZED_SCHEDULES_H
 #define FREE_TENSOR_MEMORIZED_SCHEDULES_H
 
+#include <array>
+#include <list>
 #include <mutex>
-#include <unordered_set>
+#include <unordered_map>
 
 #include <schedule/schedule_log.h>
 
@@ -17,14 +19,44 @@ namespace freetensor {
  * Schedule A -> Schedule C`. Looking up from this class saves time for applying
  * identical decisions
  *
- * This class is thread-safe
+ * The memory is bounded by `Config::memoizedSchedulesSize`, estimated from the
+ * sizes of the resulting ASTs. Beyond it, the least recently used schedules are
+ * evicted, and their results are released. An evicted schedule is simply
+ * recomputed when tried again. A schedule whose result is still in use is kept
+ * and accounted until a later eviction finds it no longer in use
+ *
+ * This class is thread-safe. Schedules are partitioned into shards by their
+ * hashes, each with its own lock, so parallel lookups seldom contend
  *
  * This class is not named cache or storage, to avoid confusion with hardware
  * features
  */
 class MemoizedSchedules {
-    std::unordered_set<ScheduleLog> memoized_;
-    std::mutex lock_;
+    static constexpr size_t N_SHARDS = 16;
+
+    struct Entry {
+        ScheduleLog log_;
+        size_t bytes_;
+    };
+
+    struct Shard {
+        std::list<Entry> lru_; // Most recently used first
+        std::unordered_map<ScheduleLog, std::list<Entry>::iterator> index_;
+        size_t bytes_ = 0;
+        std::mutex lock_;
+    };
+
+    std::array<Shard, N_SHARDS> shards_;
+
+    Shard &shard(const ScheduleLog &log) {
+        return shards_[log.hash() % N_SHARDS];
+    }
+
+    /**
+     * Evict the least recently used schedules until the shard fits, skipping
+     * those still in use. The caller should hold the lock of the shard
+     */
+    void evict(Shard &shard, size_t maxBytes);
 
   public:
     /**
@@ -34,15 +66,25 @@ class MemoizedSchedules {
      * (so the shared linked lists form a tree). If not found, save and return
      * the new log
      */
-    ScheduleLog lookupOrCreate(const ScheduleLog &log) {
-        std::lock_guard<std::mutex> guard(lock_);
-        if (auto it = memoized_.find(log); it != memoized_.end()) {
-            return *it;
-        } else {
-            memoized_.insert(log);
-            return log;
-        }
-    }
+    ScheduleLog lookupOrCreate(const ScheduleLog &log);
+
+    /**
+     * Save a log, overwriting any identical one
+     *
+     * Used when the result of an identical log has been released
+     */
+    void replace(const ScheduleLog &log);
+
+    /**
+     * Account the memory of the result of a log, after it is run, and evict
+     * other logs if needed
+     */
+    void account(const ScheduleLog &log);
+
+    /**
+     * Estimated bytes of all memoized results
+     */
+    size_t bytes();
 };
 
 } // namespace freetensor
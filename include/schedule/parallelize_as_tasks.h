@@ -0,0 +1,28 @@
+#ifndef FREE_TENSOR_PARALLELIZE_AS_TASKS_H
+#define FREE_TENSOR_PARALLELIZE_AS_TASKS_H
+
+#include <vector>
+
+#include <mutator.h>
+
+namespace freetensor {
+
+class ParallelizeAsTasks : public Mutator {
+    std::vector<ID> stmts_;
+    ID loop_; // ID of the task loop, or invalid if the statements are not found
+
+  public:
+    ParallelizeAsTasks(const std::vector<ID> &stmts) : stmts_(stmts) {}
+
+    const ID &loop() const { return loop_; }
+
+  protected:
+    Stmt visit(const StmtSeq &op) override;
+};
+
+std::pair<Stmt, ID> parallelizeAsTasks(const Stmt &ast,
+                                       const std::vector<ID> &stmts);
+
+} // namespace freetensor
+
+#endif // FREE_TENSOR_PARALLELIZE_AS_TASKS_H
@@ -36,19 +36,20 @@ enum class ScheduleType : int {
     Permute,
     PlutoFuse,
     PlutoPermute,
+    ParallelizeAsTasks,
     // ------
     NumTypes,
 };
 
 constexpr std::array scheduleTypeNames = {
-    "split",         "reorder",   "merge",
-    "fission",       "fuse",      "swap",
-    "blend",         "cache",     "cache_reduction",
-    "set_mem_type",  "var_split", "var_merge",
-    "var_reorder",   "inline",    "parallelize",
-    "unroll",        "vectorize", "separate_tail",
-    "as_matmul",     "permute",   "pluto_fuse",
-    "pluto_permute",
+    "split",         "reorder",              "merge",
+    "fission",       "fuse",                 "swap",
+    "blend",         "cache",                "cache_reduction",
+    "set_mem_type",  "var_split",            "var_merge",
+    "var_reorder",   "inline",               "parallelize",
+    "unroll",        "vectorize",            "separate_tail",
+    "as_matmul",     "permute",              "pluto_fuse",
+    "pluto_permute", "parallelize_as_tasks",
 };
 static_assert(scheduleTypeNames.size() == (size_t)ScheduleType::NumTypes);
 
@@ -74,7 +75,29 @@ class ScheduleLogItem {
     virtual std::string toPrettyString() const = 0;
     virtual size_t hash() const = 0;
     virtual bool equals(const ScheduleLogItem &other) const = 0;
-    virtual void run() = 0;
+
+    /**
+     * Run the schedule if not run yet
+     *
+     * @return : False if the result has been released by `releaseResult`, in
+     * which case it can not be recomputed from this object
+     */
+    virtual bool run() = 0;
+
+    /**
+     * Drop the result to save memory, if no one else than the caller is
+     * referring to this object via `self`
+     *
+     * A released log item can still be compared, but not run again
+     *
+     * @return : False if the result is kept because it is still in use
+     */
+    virtual bool releaseResult(const Ref<ScheduleLogItem> &self) = 0;
+
+    /**
+     * AST resulting from the schedule, or null if the schedule fails, or if
+     * the result is released
+     */
     virtual Stmt resultAST() const = 0;
 };
 
@@ -157,6 +180,7 @@ class ScheduleLogItemImpl : public ScheduleLogItem {
     Params params_;
     std::variant<std::nullopt_t, Result, std::exception_ptr> result_ =
         std::nullopt;
+    bool released_ = false;
     std::mutex lock_;
 
   public:
@@ -193,8 +217,11 @@ class ScheduleLogItemImpl : public ScheduleLogItem {
     /**
      * Run a schedule and save its result or its exception
      */
-    void run() override {
+    bool run() override {
         std::lock_guard<std::mutex> guard(lock_);
+        if (released_) {
+            return false;
+        }
         if (std::holds_alternative<std::nullopt_t>(result_)) {
             try {
                 result_ = std::apply(doSchedule_, getIDFromPack(params_));
@@ -202,6 +229,21 @@ class ScheduleLogItemImpl : public ScheduleLogItem {
                 result_ = std::current_exception();
             }
         }
+        return true;
+    }
+
+    bool releaseResult(const Ref<ScheduleLogItem> &self) override {
+        std::lock_guard<std::mutex> guard(lock_);
+        // Anyone going to read the result holds a reference before `run`,
+        // which is synchronized by `lock_`
+        if (self.useCount() > 1) {
+            return false;
+        }
+        if (std::holds_alternative<Result>(result_)) {
+            result_ = std::nullopt;
+            released_ = true;
+        }
+        return true;
     }
 
     /**
@@ -219,7 +261,9 @@ class ScheduleLogItemImpl : public ScheduleLogItem {
     }
 
     Stmt resultAST() const override final {
-        if (std::holds_alternative<std::nullopt_t>(result_)) {
+        if (released_) {
+            return nullptr;
+        } else if (std::holds_alternative<std::nullopt_t>(result_)) {
             ERROR("The schedule log is not run yet");
         } else if (std::holds_alternative<Result>(result_)) {
             Result result = std::get<Result>(result_);
@@ -1,6 +1,7 @@
 #ifndef FREE_TENSOR_LOAD_DRIVER_H
 #define FREE_TENSOR_LOAD_DRIVER_H
 
+#include <driver.h>
 #include <driver/array.h>
 #include <driver/device.h>
 #include <driver/target.h>
@@ -11,6 +12,16 @@ Ref<Target> loadTarget(const std::string &txt, const std::string &data);
 Ref<Device> loadDevice(const std::string &txt, const std::string &data);
 Ref<Array> loadArray(const std::string &txt, const std::string &data);
 
+/**
+ * Load a program exported by `dumpDriver`, without any backend compiler
+ */
+Ref<Driver> loadDriver(const std::string &txt, const std::string &data);
+
+/**
+ * Load a program exported by `exportDriver`, without any backend compiler
+ */
+Ref<Driver> importDriver(const std::string &path);
+
 /**
  * The function is only for serialization
  * The original Array constructor is disabled
@@ -5,6 +5,7 @@
 
 #include <string>
 
+#include <driver.h>
 #include <driver/array.h>
 #include <driver/device.h>
 #include <driver/target.h>
@@ -16,6 +17,25 @@ std::pair<std::string, std::string> dumpTarget(const Ref<Target> &target_);
 std::pair<std::string, std::string> dumpDevice(const Ref<Device> &device_);
 std::pair<std::string, std::string> dumpArray(const Ref<Array> &array_);
 
+/**
+ * Export a compiled program ahead of time, as an artifact that can be loaded
+ * by `loadDriver` without any backend compiler
+ *
+ * The artifact contains the AST of the function (for its signature), the
+ * native code and the compiled shared object. The shared object is native
+ * code, so it can only be loaded on a machine compatible with the one it is
+ * compiled on (e.g. the same CPU features when compiled with `-march=native`)
+ *
+ * Functions with closures are not supported, since closures refer to objects
+ * in the running process
+ */
+std::pair<std::string, std::string> dumpDriver(const Ref<Driver> &driver);
+
+/**
+ * Export a compiled program into a file. See `dumpDriver`
+ */
+void exportDriver(const Ref<Driver> &driver, const std::string &path);
+
 } // namespace freetensor
 
 #endif // FREE_TENSOR_PRINT_DRIVER_H
@@ -1,8 +1,11 @@
 import freetensor_ffi as ffi
-import xgboost as xgb
 import numpy as np
 import os
 
+from freetensor_ffi import CostModel, TuningRecord, TuningRecordDB
+
+from .remote_measure import RemoteMeasurer
+
 
 class AutoSchedule(ffi.AutoSchedule):
 
@@ -18,6 +21,10 @@ class AutoSchedule(ffi.AutoSchedule):
                  continue_training=False,
                  random_seed=None,
                  rule_set=None,
+                 remote_workers=None,
+                 remote_token=None,
+                 tuning_records=None,
+                 cost_model="xgboost",
                  verbose=0):
         '''
         Automatic scheduler
@@ -43,6 +50,24 @@ class AutoSchedule(ffi.AutoSchedule):
             measures real performance. Default to a non-deterministic seed
         rule_set : Optional[set]
             Explicitly control over what rules to use. None for defualt rules
+        remote_workers : Optional[Sequence[str]]
+            Measure programs on these workers ("host:port") in parallel,
+            instead of on `device`. See `freetensor.core.remote_measure` for
+            how to start a worker. Uploaded parameters are dropped from the
+            workers when this object is collected
+        remote_token : Optional[str]
+            The token shared with `remote_workers`. Default to the environment
+            variable `FT_REMOTE_MEASURE_TOKEN`
+        tuning_records : Optional[Union[str, TuningRecordDB]]
+            Save all measured programs to a database (or a file path of it), and
+            start from the records already in it: programs recorded are not
+            measured again, and the best record is returned by
+            `get_best_schedule` if none found in this run is faster
+        cost_model : str
+            "xgboost" to predict performance with XGBoost in Python, or "native"
+            for the built-in `CostModel` in C++, which does not call back into
+            Python during the search. The XGBoost model is saved to
+            "<tag>_xgb.model", while the native one is in memory only
         verbose : int
             Verbosity level. 0 = print nothing, 1 = print tuning progress, 2 = print
             extra info mation of each rule
@@ -54,24 +79,45 @@ class AutoSchedule(ffi.AutoSchedule):
         self.model = None
         self.xgb_params = {}
         self.save_file_name = tag + "_xgb.model"
-        if continue_training and os.path.isfile(self.save_file_name):
-            self.model = xgb.Booster()
-            self.model.load_model(self.save_file_name)
         self.verbose = verbose
 
-        def predict_func(features):
-            return self.predict(features)
+        if cost_model == "xgboost":
+            if continue_training and os.path.isfile(self.save_file_name):
+                import xgboost as xgb
+                self.model = xgb.Booster()
+                self.model.load_model(self.save_file_name)
+
+            def predict_func(features):
+                return self.predict(features)
 
-        def update_func(features, times):
-            return self.update(features, times)
+            def update_func(features, times):
+                return self.update(features, times)
+        elif cost_model == "native":
+            predict_func = update_func = None
+        else:
+            raise ValueError(f"Unrecognized cost model: {cost_model}")
 
         super(AutoSchedule,
               self).__init__(schedule, target, device, predict_func,
                              update_func, tag, min_block_size, random_seed,
                              rule_set, verbose)
 
+        self.remote_measurer = None
+        if remote_workers is not None:
+            self.remote_measurer = RemoteMeasurer(remote_workers,
+                                                  target.type(),
+                                                  token=remote_token)
+            self.set_measure_func(self.remote_measurer)
+
+        if tuning_records is not None:
+            if isinstance(tuning_records, str):
+                tuning_records = TuningRecordDB(tuning_records)
+            self.set_tuning_records(tuning_records)
+
     def set_params(self, *args, **kws):
         super(AutoSchedule, self).set_params(args, kws)
+        if self.remote_measurer is not None:
+            self.remote_measurer.set_params(args, kws)
 
     def run(self, iteration):
         for i in range(iteration):
@@ -84,9 +130,11 @@ class AutoSchedule(ffi.AutoSchedule):
     def predict(self, features):
         if not self.model:
             return [1] * len(features)
+        import xgboost as xgb
         return self.model.predict(xgb.DMatrix(np.array(features), missing=-1))
 
     def update(self, features, times):
+        import xgboost as xgb
         dtrain = xgb.DMatrix(np.array(features), np.array(times), missing=-1)
         self.model = xgb.train(self.xgb_params, dtrain, xgb_model=self.model)
         self.model.save_model(self.save_file_name)
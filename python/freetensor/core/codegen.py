@@ -5,7 +5,7 @@ import functools
 from . import config
 from .. import debug
 
-from typing import Optional
+from typing import Optional, Sequence
 
 
 class NativeCode:
@@ -27,10 +27,12 @@ def codegen(ast=None,
 
     Parameters
     ----------
-    ast : AST
+    ast : AST, or a sequence of AST
         The AST to be lowered. It must includes function signature to determine
         parameters and return values. If not specified, a partial function is
-        returned, which can be used as a decorator
+        returned, which can be used as a decorator. If a sequence of ASTs is
+        given, they are generated into one translation unit, which can be
+        compiled at once by `build_binary`. Only supported on CPU
     target : Target (Optional)
         The target architecture. If omitted, use the default one in config
     '''
@@ -39,6 +41,8 @@ def codegen(ast=None,
 
         if target is None:
             target = config.default_target()
+        if isinstance(ast, Sequence):
+            ast = list(ast)
         raw_code = ffi.code_gen(ast, target)
         if verbose:
             print(debug.with_line_no(raw_code), file=sys.stderr)
@@ -44,6 +44,58 @@ backend_compiler_cxx = _import_func(ffi.backend_compiler_cxx)
 set_backend_compiler_nvcc = _import_func(ffi.set_backend_compiler_nvcc)
 backend_compiler_nvcc = _import_func(ffi.backend_compiler_nvcc)
 
+set_kernel_cache_dir = _import_func(ffi.set_kernel_cache_dir)
+kernel_cache_dir = _import_func(ffi.kernel_cache_dir)
+
+set_kernel_cache_size = _import_func(ffi.set_kernel_cache_size)
+kernel_cache_size = _import_func(ffi.kernel_cache_size)
+
+clear_kernel_cache = _import_func(ffi.clear_kernel_cache)
+
+set_precompiled_header = _import_func(ffi.set_precompiled_header)
+precompiled_header = _import_func(ffi.precompiled_header)
+
+set_compile_workers = _import_func(ffi.set_compile_workers)
+compile_workers = _import_func(ffi.compile_workers)
+
+set_array_pool_size = _import_func(ffi.set_array_pool_size)
+array_pool_size = _import_func(ffi.array_pool_size)
+
+set_array_alignment = _import_func(ffi.set_array_alignment)
+array_alignment = _import_func(ffi.array_alignment)
+
+set_array_huge_page = _import_func(ffi.set_array_huge_page)
+array_huge_page = _import_func(ffi.array_huge_page)
+
+set_array_numa_local = _import_func(ffi.set_array_numa_local)
+array_numa_local = _import_func(ffi.array_numa_local)
+
+array_pool_stats = _import_func(ffi.array_pool_stats)
+
+release_array_pool = _import_func(ffi.release_array_pool)
+
+set_pb_memo_size = _import_func(ffi.set_pb_memo_size)
+pb_memo_size = _import_func(ffi.pb_memo_size)
+
+presburger_stats = _import_func(ffi.presburger_stats)
+
+clear_pb_memo = _import_func(ffi.clear_pb_memo)
+
+set_memoized_schedules_size = _import_func(ffi.set_memoized_schedules_size)
+memoized_schedules_size = _import_func(ffi.memoized_schedules_size)
+
+set_lower_cache_size = _import_func(ffi.set_lower_cache_size)
+lower_cache_size = _import_func(ffi.lower_cache_size)
+
+set_z3_query_timeout = _import_func(ffi.set_z3_query_timeout)
+z3_query_timeout = _import_func(ffi.z3_query_timeout)
+
+set_z3_pass_budget = _import_func(ffi.set_z3_pass_budget)
+z3_pass_budget = _import_func(ffi.z3_pass_budget)
+
+set_z3_cache_size = _import_func(ffi.set_z3_cache_size)
+z3_cache_size = _import_func(ffi.z3_cache_size)
+
 set_default_target = _import_func(ffi.set_default_target)
 default_target = _import_func(ffi.default_target)
 
@@ -3,7 +3,7 @@ import functools
 import numpy as np
 
 from typing import Optional, Sequence
-from freetensor_ffi import Target, Array
+from freetensor_ffi import Target, Array, BenchmarkOptions
 
 from . import config
 from .codegen import NativeCode
@@ -188,7 +188,10 @@ class Driver(ffi.Driver):
                  src: str,
                  device: Optional[Device] = None,
                  host_device: Optional[Device] = None,
-                 verbose: Optional[bool] = None):
+                 verbose: Optional[bool] = None,
+                 async_build: bool = False,
+                 entry: str = 'run',
+                 share_with: Optional['Driver'] = None):
         '''
         Compile a program using a backend compiler and load it into memory
 
@@ -206,19 +209,53 @@ class Driver(ffi.Driver):
             in config
         verbose : bool (Optional)
             True to print extra infomation
+        async_build : bool
+            If true, return as soon as the program is submitted to the
+            compiling workers. The program is loaded in `wait`, or in the first
+            `run`, where compiling errors are also reported
+        entry : str
+            Symbol of the entry function. Only needed for code generated from
+            multiple functions
+        share_with : Driver (Optional)
+            If set, do not compile or load anything, but run `entry` in the
+            program loaded by `share_with`
         '''
-        self.src = str(src)
+        src = str(src)
         if device is None:
             device = config.default_device()
         if verbose is None:
             verbose = False
-        if host_device is None:
-            super(Driver, self).__init__(func, self.src, device, verbose)
+        if share_with is not None:
+            super(Driver, self).__init__(func, share_with, entry)
+        elif host_device is None:
+            super(Driver, self).__init__(func, src, device, verbose,
+                                         async_build, entry)
         else:
-            super(Driver, self).__init__(func, self.src, device, host_device,
-                                         verbose)
-        self.func = func
+            super(Driver, self).__init__(func, src, device, host_device,
+                                         verbose, async_build, entry)
+        self._init_arg_holders()
 
+    @classmethod
+    def load(cls, txt_data_or_path):
+        '''
+        Load a program exported by `dump_driver` or `export_driver`, without
+        any backend compiler
+
+        Parameters
+        ----------
+        txt_data_or_path : Tuple[str, bytes] or str
+            Result of `dump_driver`, or path to a file written by
+            `export_driver`
+        '''
+        self = cls.__new__(cls)
+        if isinstance(txt_data_or_path, str):
+            ffi.Driver.__init__(self, txt_data_or_path)
+        else:
+            ffi.Driver.__init__(self, tuple(txt_data_or_path))
+        self._init_arg_holders()
+        return self
+
+    def _init_arg_holders(self):
         # When we pass numpy or pytorch tensors to `set_args`, they are
         # converted to `Array` objects by reference. In `Array`'s FFI, we
         # keep these tensors alive whenever the `Array`'s PYTHON objects
@@ -227,6 +264,7 @@ class Driver(ffi.Driver):
         # C++ implementation, where we can only hold the `Array`'s C++
         # objects alive.
         self.args_ref_cnt_holder = []
+        self.bound_ref_cnt_holder = {}
 
     def native_code(self):
         ''' Get native code compiled by backend compiler '''
@@ -237,6 +275,7 @@ class Driver(ffi.Driver):
 
         # No need to hold reference of the last run any more
         self.args_ref_cnt_holder = []
+        self.bound_ref_cnt_holder = {}
 
         args = list(args)
         kws = dict(kws)
@@ -252,7 +291,26 @@ class Driver(ffi.Driver):
 
         super(Driver, self).set_args(args, kws)
 
-    def collect_returns(self, always_return_pack: bool = False):
+    def set_arg(self, param, value):
+        '''
+        Set one argument for an invocation, by the index or the name of its
+        parameter
+
+        This is a fast path for running a program repeatedly with mostly the
+        same arguments: set all arguments once with `set_args`, and then only
+        swap the changed ones with `set_arg` before each `run`. Resolve names
+        to indices once with `param_index` for less overhead. Use
+        `collect_returns(keep_args=True)` to keep the arguments between runs
+        '''
+        if isinstance(param, str):
+            param = self.param_index(param)
+        value = array(value, True)
+        self.bound_ref_cnt_holder[param] = value
+        super(Driver, self).set_arg(param, value)
+
+    def collect_returns(self,
+                        always_return_pack: bool = False,
+                        keep_args: bool = False):
         '''
         Collect return values from an invocation
 
@@ -261,8 +319,11 @@ class Driver(ffi.Driver):
         If there is only one return value, it is returned directly. Otherwise,
         or if `always_return_pack` is set, the return values are packed in a
         ReturnValuesPack
+
+        If `keep_args` is set, the arguments are kept, so the program can be
+        run again without setting them
         '''
-        values = super(Driver, self).collect_returns()
+        values = super(Driver, self).collect_returns(keep_args)
         if len(values) == 0 and not always_return_pack:
             return None
         elif len(values) == 1 and not always_return_pack:
@@ -274,6 +335,38 @@ class Driver(ffi.Driver):
                     filter(lambda r: not r.is_in_closure or r.return_closure,
                            self.func.returns)), values)
 
+    def benchmark(self,
+                  options: Optional[BenchmarkOptions] = None,
+                  **kws) -> ffi.BenchmarkResult:
+        '''
+        Run the program and measure its time cost, with adaptive stopping and
+        outlier rejection
+
+        Please set the arguments with `set_args` first
+
+        Parameters
+        ----------
+        options : BenchmarkOptions (Optional)
+            Options of measurement. Default options are used if omitted
+        kws :
+            Override fields of `options`, e.g. `max_rounds=1000`,
+            `time_budget=500` (in ms), `flush_cache=True` or `pin_cpu=0`
+
+        Returns
+        -------
+        BenchmarkResult
+            Sorted samples, average time and its standard deviation excluding
+            outliers, and percentiles (via `percentile` or `median`), in ms
+        '''
+        new_options = BenchmarkOptions()
+        if options is not None:
+            for key in dir(options):
+                if not key.startswith('_'):
+                    setattr(new_options, key, getattr(options, key))
+        for key, value in kws.items():
+            setattr(new_options, key, value)
+        return super(Driver, self).benchmark(new_options)
+
     def __call__(self, *args, **kws):
         '''
         Set argument, execute the binary code, and collect the returns
@@ -283,7 +376,8 @@ class Driver(ffi.Driver):
 
         This function will introduce some overhaed handling arguments and return
         values. For an accurate execution time measurement, plase call
-        `self.set_args` first, then `self.time`, and finally `self.collect_returns`
+        `self.set_args` first, then `self.time` or `self.benchmark`, and finally
+        `self.collect_returns`
         '''
         self.set_args(*args, **kws)
         self.run()
@@ -293,7 +387,8 @@ class Driver(ffi.Driver):
 def build_binary(code: Optional[NativeCode] = None,
                  device: Optional[Device] = None,
                  host_device: Optional[Device] = None,
-                 verbose: Optional[bool] = None):
+                 verbose: Optional[bool] = None,
+                 async_build: Optional[bool] = None):
     '''
     Compile a program using a backend compiler and load it into memory
 
@@ -301,10 +396,16 @@ def build_binary(code: Optional[NativeCode] = None,
     ----------
     code : NativeCode
         Native code generated by `codegen`. If not specified, a partial
-        function is returned, which can be used as a decorator
+        function is returned, which can be used as a decorator. If the code is
+        generated from multiple functions, they are compiled and loaded only
+        once, and a list of Drivers, one for each function, is returned
     device : Device (Optional)
         The device to run the program. If omitted, use the default device
         in config
+    async_build : bool (Optional)
+        If true, return a Driver as soon as the program is submitted to the
+        compiling workers, so compiling can overlap with other work. Call
+        `Driver.wait` to wait for it, or it is waited for in the first run
     '''
 
     if code is not None:
@@ -314,7 +415,21 @@ def build_binary(code: Optional[NativeCode] = None,
             raise ffi.DriverError(
                 f"Codegen target ({code.target}) is inconsistent with device target ({device.target()})"
             )
-        return Driver(code.func, code.code, device, host_device, verbose)
+        if isinstance(code.func, Sequence):
+            drivers = []
+            for i, func in enumerate(code.func):
+                drivers.append(
+                    Driver(func,
+                           code.code,
+                           device,
+                           host_device,
+                           verbose,
+                           bool(async_build),
+                           entry=ffi.multi_kernel_entry(i, func.name),
+                           share_with=drivers[0] if i > 0 else None))
+            return drivers
+        return Driver(code.func, code.code, device, host_device, verbose,
+                      bool(async_build))
     else:
         f = build_binary
         if device is not None:
@@ -323,4 +438,6 @@ def build_binary(code: Optional[NativeCode] = None,
             f = functools.partial(f, host_device=host_device)
         if verbose is not None:
             f = functools.partial(f, verbose=verbose)
+        if async_build is not None:
+            f = functools.partial(f, async_build=async_build)
         return f
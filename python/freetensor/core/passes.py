@@ -12,6 +12,8 @@ from freetensor_ffi import prop_one_time_use
 from freetensor_ffi import simplify
 from freetensor_ffi import pb_simplify
 from freetensor_ffi import z3_simplify
+from freetensor_ffi import z3_stats
+from freetensor_ffi import clear_z3_cache
 from freetensor_ffi import sink_var
 from freetensor_ffi import shrink_var
 from freetensor_ffi import shrink_for
@@ -25,6 +27,8 @@ from freetensor_ffi import use_builtin_div
 from freetensor_ffi import hoist_var_over_stmt_seq
 from freetensor_ffi import flatten_stmt_seq
 from freetensor_ffi import cpu_lower_parallel_reduction
+from freetensor_ffi import lower_cache_stats
+from freetensor_ffi import clear_lower_cache
 
 if config.with_cuda():
     from freetensor_ffi import gpu_lower_parallel_reduction
@@ -0,0 +1,339 @@
+'''
+Measure programs on remote workers
+
+A worker is a process serving measuring requests over XML-RPC. It receives the
+serialized lowered AST and the generated code of a program, compiles it with
+its local backend compiler, runs it on its local device, and returns the time.
+Start a worker with
+
+```
+export FT_REMOTE_MEASURE_TOKEN=<a secret shared with the clients>
+PYTHONPATH=../python:../build:$PYTHONPATH python3 -m freetensor.core.remote_measure --port 8000
+```
+
+and pass its address to `AutoSchedule(..., remote_workers=["host:8000"])`,
+with the same `FT_REMOTE_MEASURE_TOKEN` set (or pass `remote_token`). Workers
+should have the same kind of devices as the one the program is tuned for
+
+A worker compiles and runs any code it receives, so every request must carry
+the token. Still, the token is sent in plain text over HTTP: a worker listens on
+127.0.0.1 by default, and binding it to a public interface (`--host 0.0.0.0`)
+is UNSAFE. Reach workers on other machines through an SSH tunnel or a trusted
+private network instead
+'''
+
+import argparse
+import collections
+import hmac
+import os
+import secrets
+import sys
+import threading
+import uuid
+import xmlrpc.client
+import xmlrpc.server
+from typing import Optional, Sequence
+
+import freetensor_ffi as ffi
+
+from .driver import Device, Driver, BenchmarkOptions
+from .serialize import dump_ast, load_ast, dump_array, load_array
+
+_OPTION_FIELDS = [
+    'warmups', 'min_rounds', 'max_rounds', 'target_rel_ci', 'time_budget',
+    'flush_cache', 'pin_cpu', 'abort_threshold', 'reject_outliers'
+]
+
+
+def _dump_options(options: BenchmarkOptions):
+    # XML-RPC does not support infinity or integers beyond 32 bits, so pass
+    # all the numbers as strings
+    return {key: repr(getattr(options, key)) for key in _OPTION_FIELDS}
+
+
+def _load_options(options):
+    ret = BenchmarkOptions()
+    for key, value in options.items():
+        field_type = type(getattr(ret, key))
+        setattr(ret, key,
+                value == 'True' if field_type is bool else field_type(value))
+    return ret
+
+
+_TOKEN_ENV = 'FT_REMOTE_MEASURE_TOKEN'
+
+
+def _dump_array(arr):
+    meta, data = dump_array(arr)
+    return [meta, xmlrpc.client.Binary(data)]
+
+
+def _load_array(txt_data):
+    meta, data = txt_data
+    return load_array((meta, data.data))
+
+
+class MeasureWorker:
+    '''
+    Methods served by a worker process
+
+    Every method takes the shared token as the first argument, and rejects the
+    request if it does not match
+    '''
+
+    # Parameters of sessions not closed (e.g. the client crashed) are dropped
+    # when there are too many
+    MAX_SESSIONS = 8
+
+    def __init__(self, token: str, device_num: int = 0):
+        if not token:
+            raise ValueError("A token is required")
+        self.token = token
+        self.device_num = device_num
+        self.params = collections.OrderedDict()  # session -> (args, kws)
+
+    def _check_token(self, token):
+        if not isinstance(token, str) or not hmac.compare_digest(
+                token.encode(), self.token.encode()):
+            raise PermissionError("Invalid token")
+
+    def set_params(self, token: str, session: str, args, kws):
+        self._check_token(token)
+        self.params.pop(session, None)
+        self.params[session] = ([_load_array(a) for a in args],
+                                {k: _load_array(v) for k, v in kws.items()})
+        while len(self.params) > self.MAX_SESSIONS:
+            self.params.popitem(last=False)
+        return True
+
+    def drop_params(self, token: str, session: str):
+        self._check_token(token)
+        self.params.pop(session, None)
+        return True
+
+    def measure(self, token: str, session: str, target_type: str,
+                func_txt: str, code: str, options):
+        '''
+        Compile and measure a program
+
+        Returns a dict of `time` and `stddev` (as strings), or `error` if
+        failed
+        '''
+        self._check_token(token)
+        try:
+            if session not in self.params:
+                raise KeyError(f"Parameters of session {session} are not set")
+            args, kws = self.params[session]
+            func = load_ast(func_txt)
+            device = Device(getattr(ffi.TargetType, target_type),
+                            self.device_num)
+            driver = Driver(func, code, device)
+            driver.set_args(*args, **kws)
+            result = driver.benchmark(_load_options(options))
+            driver.collect_returns()
+            return {'time': repr(result.avg), 'stddev': repr(result.stddev)}
+        except Exception as e:
+            return {'error': str(e)}
+
+
+class RemoteMeasurer:
+    '''
+    Spread programs to measure across multiple workers
+
+    Each worker measures one program at a time, and takes the next one as soon
+    as it finishes. A worker that cannot be reached is dropped, and its program
+    is measured by others
+
+    Parameters
+    ----------
+    workers : Sequence[str]
+        Addresses of workers, in the form of "host:port"
+    target_type : TargetType
+        The type of devices to measure on
+    token : Optional[str]
+        The token shared with the workers. Default to the environment variable
+        `FT_REMOTE_MEASURE_TOKEN`
+    timeout : float
+        Timeout of each request in seconds
+
+    Parameters uploaded to the workers are dropped by `close`, which is also
+    called when leaving a `with` block or when this object is collected
+    '''
+
+    def __init__(self,
+                 workers: Sequence[str],
+                 target_type,
+                 token: Optional[str] = None,
+                 timeout: float = 600):
+        if len(workers) == 0:
+            raise ffi.DriverError("At least one worker is required")
+        if token is None:
+            token = os.environ.get(_TOKEN_ENV)
+        if not token:
+            raise ffi.DriverError(
+                f"A token shared with the workers is required. Set {_TOKEN_ENV}"
+            )
+        self.token = token
+        self.workers = list(workers)
+        self.target_type = target_type.name
+        self.timeout = timeout
+        self.session = uuid.uuid4().hex
+        self.params = None
+
+    def _proxy(self, worker):
+        host, port = worker.rsplit(':', 1)
+        transport = _TimeoutTransport(self.timeout)
+        return xmlrpc.client.ServerProxy(f"http://{host}:{port}",
+                                         transport=transport,
+                                         allow_none=True)
+
+    def set_params(self, args, kws):
+        ''' Set arguments of the programs to measure '''
+        self.params = ([_dump_array(a) for a in args],
+                       {k: _dump_array(v) for k, v in kws.items()})
+        alive = []
+        for worker in self.workers:
+            try:
+                self._proxy(worker).set_params(self.token, self.session,
+                                               *self.params)
+                alive.append(worker)
+            except (OSError, xmlrpc.client.Error) as e:
+                print(f"Worker {worker} failed: {e}. Dropping it",
+                      file=sys.stderr)
+        if not alive:
+            raise ffi.DriverError("All remote workers failed")
+        self.workers = alive
+
+    def close(self):
+        ''' Drop the parameters uploaded to the workers '''
+        if self.params is None:
+            return
+        self.params = None
+        for worker in self.workers:
+            try:
+                self._proxy(worker).drop_params(self.token, self.session)
+            except (OSError, xmlrpc.client.Error):
+                pass  # The worker has gone, with the parameters
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+    def __call__(self, funcs, codes, options: BenchmarkOptions):
+        ''' Measure programs. Returns lists of average time and stddev '''
+        if self.params is None:
+            raise ffi.DriverError("Parameters are not set")
+        n = len(funcs)
+        times = [float('inf')] * n
+        stddevs = [0.] * n
+        todo = list(range(n))
+        options = _dump_options(options)
+        lock = threading.Lock()
+        alive = list(self.workers)
+
+        def work(worker):
+            proxy = self._proxy(worker)
+            while True:
+                with lock:
+                    if not todo:
+                        return
+                    i = todo.pop()
+                try:
+                    ret = proxy.measure(self.token, self.session,
+                                        self.target_type,
+                                        dump_ast(funcs[i], True), codes[i],
+                                        options)
+                except (OSError, xmlrpc.client.Error) as e:
+                    print(f"Worker {worker} failed: {e}. Dropping it",
+                          file=sys.stderr)
+                    with lock:
+                        todo.append(i)
+                        alive.remove(worker)
+                    return
+                if 'error' in ret:
+                    print(f"ERROR measure on {worker}: {ret['error']}",
+                          file=sys.stderr)
+                else:
+                    times[i] = float(ret['time'])
+                    stddevs[i] = float(ret['stddev'])
+
+        # Programs of a dropped worker may be put back after other workers
+        # have returned, so repeat until all done
+        while todo and alive:
+            threads = [
+                threading.Thread(target=work, args=(w,)) for w in list(alive)
+            ]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+        self.workers = alive
+        if todo:
+            raise ffi.DriverError("All remote workers failed")
+        return times, stddevs
+
+
+class _TimeoutTransport(xmlrpc.client.Transport):
+
+    def __init__(self, timeout):
+        super().__init__()
+        self.timeout = timeout
+
+    def make_connection(self, host):
+        conn = super().make_connection(host)
+        conn.timeout = self.timeout
+        return conn
+
+
+def serve(host: str = '127.0.0.1',
+          port: int = 0,
+          device_num: int = 0,
+          token: Optional[str] = None):
+    '''
+    Run a worker until killed
+
+    The port actually listened is printed in a line of "Listening on
+    <host>:<port>", which is useful when `port` is 0 (any free port)
+
+    `token` defaults to the environment variable `FT_REMOTE_MEASURE_TOKEN`. If
+    neither is set, a random token is generated and printed in a line of
+    "Token: <token>" before the address. Listening on a public interface is
+    unsafe, see the module documentation
+    '''
+    if token is None:
+        token = os.environ.get(_TOKEN_ENV)
+    if not token:
+        token = secrets.token_hex(16)
+        print(f"Token: {token}", flush=True)
+    if host not in ('127.0.0.1', 'localhost', '::1'):
+        print(
+            f"WARNING: Listening on {host}. Anyone reaching this port with "
+            "the token can run arbitrary code on this machine",
+            file=sys.stderr)
+    server = xmlrpc.server.SimpleXMLRPCServer((host, port),
+                                              logRequests=False,
+                                              allow_none=True)
+    server.register_instance(MeasureWorker(token, device_num))
+    print(f"Listening on {host}:{server.server_address[1]}", flush=True)
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description="Worker measuring programs for remote auto-scheduling. "
+        f"The token is read from {_TOKEN_ENV}")
+    parser.add_argument('--host',
+                        default='127.0.0.1',
+                        help="Binding to a public interface is unsafe")
+    parser.add_argument('--port', type=int, default=0)
+    parser.add_argument('--device-num', type=int, default=0)
+    cmd_args = parser.parse_args()
+    serve(cmd_args.host, cmd_args.port, cmd_args.device_num)
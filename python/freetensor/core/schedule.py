@@ -598,7 +598,12 @@ class Schedule(ffi.Schedule):
         """
         return super().inline(self._lookup(vardef))
 
-    def parallelize(self, loop, parallel):
+    def parallelize(self,
+                    loop,
+                    parallel,
+                    schedule: Optional[str] = None,
+                    chunk: Optional[int] = None,
+                    num_threads: Optional[int] = None):
         """
         Mark a loop with a parallel implementation
 
@@ -659,8 +664,55 @@ class Schedule(ffi.Schedule):
             The loop
         parallel : ParallelScope
             Parallel scope
+        schedule : str (Optional)
+            For "openmp" only. OpenMP schedule kind: "static", "dynamic" or
+            "guided". Default to OpenMP's default
+        chunk : int (Optional)
+            For "openmp" only. Number of iterations per chunk
+        num_threads : int (Optional)
+            For "openmp" only. Number of threads to run the loop
+        """
+        parallel = ParallelScope(parallel)
+        if schedule is not None or chunk is not None or num_threads is not None:
+            if not isinstance(parallel, ffi.OpenMPScope):
+                raise ffi.InvalidSchedule(
+                    "schedule, chunk and num_threads are only for OpenMP")
+            parallel = ffi.OpenMPScope(
+                schedule if schedule is not None else parallel.schedule.name,
+                chunk if chunk is not None else parallel.chunk,
+                num_threads
+                if num_threads is not None else parallel.num_threads)
+        super().parallelize(self._lookup(loop), parallel)
+
+    def parallelize_as_tasks(self, stmts):
+        """
+        Run consecutive independent statements as concurrent tasks on CPU
+
+        The statements are wrapped in a new loop, each iteration of which runs
+        one of them, and the loop is parallelized with "openmp_task". E.g. two
+        independent matrix multiplications can then run at the same time, each
+        using a part of the cores. OpenMP loops inside the statements run
+        serially in the thread of their task
+
+        Parameters
+        ----------
+        stmts : List[str (Selector string), ID, List[ID], Stmt, or List[Stmt]]
+            The statements. They should be consecutive in the same block. If one
+            item of the `stmts` list contains multiple statements, the list will
+            be flattened
+
+        Raises
+        ------
+        InvalidSchedule
+            if the statements are not found or not consecutive, or if there are
+            dependences among them
+
+        Returns
+        -------
+        ID
+            ID of the new loop
         """
-        super().parallelize(self._lookup(loop), ParallelScope(parallel))
+        return super().parallelize_as_tasks(self._lookup_list(stmts))
 
     def unroll(self, loop, immediate=False):
         """
@@ -836,7 +888,7 @@ class Schedule(ffi.Schedule):
         return super().pluto_permute(self._lookup(loop), nest_level,
                                      do_simplify)
 
-    def auto_schedule(self, target):
+    def auto_schedule(self, target, records=None):
         """
         (Experimental) Automatic scheduling using some heuristics
 
@@ -844,8 +896,14 @@ class Schedule(ffi.Schedule):
         ----------
         target : Target
             Target architecture
-        """
-        super().auto_schedule(target)
+        records : Optional[Union[str, TuningRecordDB]]
+            A tuning record database (or a file path of it). If a record of the
+            same program on the same target is found, apply the best record
+            instead of any heuristics
+        """
+        if isinstance(records, str):
+            records = ffi.TuningRecordDB(records)
+        super().auto_schedule(target, records)
 
     def auto_use_lib(self, target):
         """
@@ -1,2 +1,19 @@
 from freetensor_ffi import dump_ast, dump_target, dump_device, dump_array
+from freetensor_ffi import dump_driver, export_driver
 from freetensor_ffi import load_ast, load_target, load_device, load_array
+
+from .driver import Driver
+
+
+def load_driver(txt_data) -> Driver:
+    '''
+    Load a program exported by `dump_driver`, without any backend compiler
+    '''
+    return Driver.load(txt_data)
+
+
+def import_driver(path: str) -> Driver:
+    '''
+    Load a program exported by `export_driver`, without any backend compiler
+    '''
+    return Driver.load(path)
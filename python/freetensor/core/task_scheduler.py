@@ -1,7 +1,7 @@
 from typing import List
 import numpy as np
 
-from .auto_schedule import AutoSchedule
+from .auto_schedule import AutoSchedule, TuningRecordDB
 
 
 class TaskScheduler:
@@ -14,7 +14,8 @@ class TaskScheduler:
                  backward_window=3,
                  alpha=0.2,
                  beta=2,
-                 gamma=0.5):
+                 gamma=0.5,
+                 tuning_records=None):
         self.score_func = sum
         self.measures_per_round = measures_per_round
         self.backward_window = backward_window
@@ -22,10 +23,16 @@ class TaskScheduler:
         self.beta = beta
         self.gamma = gamma
         self.tasks = tasks
+        if tuning_records is not None:
+            # Share one database among all the tasks
+            if isinstance(tuning_records, str):
+                tuning_records = TuningRecordDB(tuning_records)
+            for task in tasks:
+                task.set_tuning_records(tuning_records)
         self.task_cts = [0] * len(tasks)
         self.task_best_cts = [0] * len(tasks)
         self.task_history = [[]] * len(tasks)
-        self.bests = [1e30] * len(tasks)
+        self.bests = [min(1e30, task.get_best_time()) for task in tasks]
         self.score = self.compute_score(self.bests)
         self.best_score = None
         self.dead_tasks = set()
@@ -1,9 +1,48 @@
 #ifndef FREE_TENSOR_CPU_CONTEXT_H
 #define FREE_TENSOR_CPU_CONTEXT_H
 
+#include <cstdint>
+#include <cstdlib>
+
 #include "context.h"
+#include "cpu_thread_pool.h"
+
+class CPUContext : public Context {
+    ThreadPool *(*getThreadPool_)() = nullptr;
+    ThreadPool *threadPool_ = nullptr;
+    int numThreads_ = 0;
+    uint8_t *(*allocReturn_)(size_t) = nullptr;
+
+  public:
+    /**
+     * @param getThreadPool : Function to get the thread pool, called lazily
+     * on the first parallel loop run by the pool. It should be a function in
+     * the FreeTensor library (see `ThreadPool`)
+     * @param numThreads : Maximum number of threads of each parallel loop run
+     * by the pool. Non-positive for the whole pool
+     * @param allocReturn : Function to allocate buffers of returned values,
+     * which will be owned by `Array`s. It should be a function in the
+     * FreeTensor library. Null to use `malloc`
+     */
+    CPUContext(ThreadPool *(*getThreadPool)() = nullptr, int numThreads = 0,
+               uint8_t *(*allocReturn)(size_t) = nullptr)
+        : getThreadPool_(getThreadPool), numThreads_(numThreads),
+          allocReturn_(allocReturn) {}
+
+    ThreadPool &threadPool() {
+        if (threadPool_ == nullptr) {
+            threadPool_ = getThreadPool_();
+        }
+        return *threadPool_;
+    }
+
+    int numThreads() const { return numThreads_; }
+    void setNumThreads(int numThreads) { numThreads_ = numThreads; }
 
-class CPUContext : public Context {};
+    void *allocReturn(size_t size) {
+        return allocReturn_ != nullptr ? allocReturn_(size) : malloc(size);
+    }
+};
 
 extern "C" typedef CPUContext *CPUContext_t;
 
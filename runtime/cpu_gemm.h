@@ -0,0 +1,286 @@
+#ifndef FREE_TENSOR_CPU_GEMM_H
+#define FREE_TENSOR_CPU_GEMM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <new> // align_val_t
+
+#include <omp.h>
+
+#include "cpu_runtime.h" // SIMDVec, ThreadPool
+
+/**
+ * Built-in GEMM for `MatMul`, used when FreeTensor is not built with MKL (or
+ * if `CPUTarget::useNativeGEMM` is set)
+ *
+ * It follows the GotoBLAS / BLIS scheme: B is packed panel by panel (KC x NC)
+ * and A block by block (MC x KC), so a micro-kernel computes an MR x NR tile
+ * of C in registers, reading both operands contiguously. The micro-kernel is
+ * specialized at compile time for the data type, and the transposition of the
+ * operands only affects packing
+ */
+
+namespace gemm_detail {
+
+/**
+ * Blocking of a GEMM of `T` on a target with `VEC_BYTES`-byte SIMD vectors. A
+ * row of a micro-kernel tile fits in one vector register
+ */
+template <class T, int VEC_BYTES> struct Blocking {
+    static constexpr int NR =
+        sizeof(T) >= VEC_BYTES ? 1 : VEC_BYTES / sizeof(T);
+    static constexpr int MR = 6;
+    static constexpr int64_t KC = 256;
+    static constexpr int64_t MC = MR * 16;
+    static constexpr int64_t NC = NR * 256;
+    static constexpr int64_t NB = NR * 8; // Columns of a task in a panel
+    static constexpr int64_t MG = // Blocks of A packed at a time (<= 4 MiB)
+        std::max<int64_t>(1, (4 << 20) / (MC * KC * sizeof(T)));
+};
+
+/**
+ * Buffer for packed A or B, allocated per GEMM
+ *
+ * No thread-local storage is used: a non-trivially-destructible `thread_local`
+ * registers a destructor against the shared object of the compiled program,
+ * which then cannot be unloaded while any thread that ran a GEMM is alive
+ */
+template <class T> class PackBuffer {
+    T *data_;
+
+  public:
+    explicit PackBuffer(size_t size)
+        : data_((T *)operator new(size * sizeof(T), std::align_val_t(64))) {}
+    ~PackBuffer() { operator delete(data_, std::align_val_t(64)); }
+
+    PackBuffer(const PackBuffer &) = delete;
+    PackBuffer &operator=(const PackBuffer &) = delete;
+
+    T *data() const { return data_; }
+};
+
+/**
+ * Pack mc x kc of A into slivers of MR rows, padded with zeros
+ */
+template <class T, int VEC_BYTES, bool TRANS_A>
+void packA(int64_t mc, int64_t kc, const T *a, int64_t lda, T *ap) {
+    constexpr int MR = Blocking<T, VEC_BYTES>::MR;
+    for (int64_t ir = 0; ir < mc; ir += MR, ap += MR * kc) {
+        int mr = std::min<int64_t>(MR, mc - ir);
+        for (int64_t p = 0; p < kc; p++) {
+            for (int i = 0; i < MR; i++) {
+                ap[p * MR + i] =
+                    i < mr ? (TRANS_A ? a[p * lda + ir + i]
+                                      : a[(ir + i) * lda + p])
+                           : T(0);
+            }
+        }
+    }
+}
+
+/**
+ * Pack the `js`-th sliver of NR columns of kc x nc of B, padded with zeros
+ */
+template <class T, int VEC_BYTES, bool TRANS_B>
+void packBSliver(int64_t js, int64_t kc, int64_t nc, const T *b, int64_t ldb,
+                 T *bp) {
+    constexpr int NR = Blocking<T, VEC_BYTES>::NR;
+    int64_t jr = js * NR;
+    int nr = std::min<int64_t>(NR, nc - jr);
+    bp += jr * kc;
+    for (int64_t p = 0; p < kc; p++) {
+        for (int j = 0; j < NR; j++) {
+            bp[p * NR + j] = j < nr ? (TRANS_B ? b[(jr + j) * ldb + p]
+                                               : b[p * ldb + jr + j])
+                                    : T(0);
+        }
+    }
+}
+
+/**
+ * c[0:mr, 0:nr] = alpha * ap * bp + beta * c. `c` is not read if beta is 0
+ */
+template <class T, int VEC_BYTES>
+inline void microKernel(int64_t kc, const T *ap, const T *bp, T alpha, T beta,
+                        T *c, int64_t ldc, int mr, int nr) {
+    typedef Blocking<T, VEC_BYTES> B;
+    constexpr int MR = B::MR, NR = B::NR;
+    SIMDVec<T, NR> acc[MR] = {};
+    for (int64_t p = 0; p < kc; p++) {
+        auto bv = simdLoad<T, NR>(bp + p * NR);
+        for (int i = 0; i < MR; i++) {
+            acc[i] += simdBroadcast<T, NR>(ap[p * MR + i]) * bv;
+        }
+    }
+    if (nr == NR) {
+        for (int i = 0; i < mr; i++) {
+            auto cv = acc[i] * simdBroadcast<T, NR>(alpha);
+            if (beta != T(0)) {
+                cv += simdLoad<T, NR>(c + i * ldc) * simdBroadcast<T, NR>(beta);
+            }
+            simdStore<T, NR>(c + i * ldc, cv);
+        }
+    } else {
+        for (int i = 0; i < mr; i++) {
+            for (int j = 0; j < nr; j++) {
+                T &x = c[i * ldc + j];
+                x = alpha * acc[i][j] + (beta != T(0) ? beta * x : T(0));
+            }
+        }
+    }
+}
+
+/**
+ * One GEMM, with tasks run by `parallelFor(n, f)`, which calls `f(i)` for
+ * each `i` in `[0, n)`
+ */
+template <class T, int VEC_BYTES, bool TRANS_A, bool TRANS_B,
+          class ParallelFor>
+void gemm(int64_t m, int64_t n, int64_t k, T alpha, const T *a, int64_t lda,
+          const T *b, int64_t ldb, T beta, T *c, int64_t ldc,
+          ParallelFor &&parallelFor) {
+    typedef Blocking<T, VEC_BYTES> B;
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+    if (k <= 0) {
+        for (int64_t i = 0; i < m; i++) {
+            for (int64_t j = 0; j < n; j++) {
+                T &x = c[i * ldc + j];
+                x = beta != T(0) ? beta * x : T(0);
+            }
+        }
+        return;
+    }
+
+    // Shared by all tasks. Tasks of different panels are separated by the
+    // join of `parallelFor`
+    int64_t kcMax = std::min(B::KC, k);
+    int64_t ncMax = (std::min(B::NC, n) + B::NR - 1) / B::NR * B::NR;
+    int64_t nBlocksM = (m + B::MC - 1) / B::MC;
+    PackBuffer<T> bBuf(kcMax * ncMax);
+    PackBuffer<T> aBuf(std::min(B::MG, nBlocksM) * B::MC * kcMax);
+    T *bp = bBuf.data(), *ap = aBuf.data();
+    for (int64_t jc = 0; jc < n; jc += B::NC) {
+        int64_t nc = std::min(B::NC, n - jc);
+        int64_t nSlivers = (nc + B::NR - 1) / B::NR;
+        for (int64_t pc = 0; pc < k; pc += B::KC) {
+            int64_t kc = std::min(B::KC, k - pc);
+            T betaBlk = pc == 0 ? beta : T(1);
+            auto bBlk = TRANS_B ? b + jc * ldb + pc : b + pc * ldb + jc;
+            parallelFor(nSlivers, [&](int64_t js) {
+                packBSliver<T, VEC_BYTES, TRANS_B>(js, kc, nc, bBlk, ldb, bp);
+            });
+
+            int64_t nTilesN = (nc + B::NB - 1) / B::NB;
+            for (int64_t ib0 = 0; ib0 < nBlocksM; ib0 += B::MG) {
+                // Each block of A is packed once, and shared by the tiles of
+                // all the columns
+                int64_t nBlocks = std::min(B::MG, nBlocksM - ib0);
+                parallelFor(nBlocks, [&](int64_t ib) {
+                    int64_t ic = (ib0 + ib) * B::MC;
+                    int64_t mc = std::min(B::MC, m - ic);
+                    packA<T, VEC_BYTES, TRANS_A>(mc, kc,
+                                      TRANS_A ? a + pc * lda + ic
+                                              : a + ic * lda + pc,
+                                      lda, ap + ib * B::MC * kc);
+                });
+
+                parallelFor(nBlocks * nTilesN, [&](int64_t tile) {
+                    int64_t ib = tile / nTilesN;
+                    int64_t ic = (ib0 + ib) * B::MC;
+                    int64_t j0 = tile % nTilesN * B::NB;
+                    int64_t mc = std::min(B::MC, m - ic);
+                    int64_t nb = std::min(B::NB, nc - j0);
+                    const T *apBlk = ap + ib * B::MC * kc;
+                    for (int64_t jr = j0; jr < j0 + nb; jr += B::NR) {
+                        for (int64_t ir = 0; ir < mc; ir += B::MR) {
+                            microKernel<T, VEC_BYTES>(
+                                kc, apBlk + ir * kc, bp + jr * kc, alpha,
+                                betaBlk, c + (ic + ir) * ldc + jc + jr, ldc,
+                                std::min<int64_t>(B::MR, mc - ir),
+                                std::min<int64_t>(B::NR, nc - jr));
+                        }
+                    }
+                });
+            }
+        }
+    }
+}
+
+} // namespace gemm_detail
+
+/**
+ * Ways to run the tasks of `gemmBatchStrided`
+ * @{
+ */
+struct GEMMSerial {
+    template <class F> void operator()(int64_t n, F &&f) const {
+        for (int64_t i = 0; i < n; i++) {
+            f(i);
+        }
+    }
+};
+
+struct GEMMOpenMP {
+    template <class F> void operator()(int64_t n, F &&f) const {
+        if (n == 1) {
+            f(0);
+            return;
+        }
+#pragma omp parallel for schedule(dynamic)
+        for (int64_t i = 0; i < n; i++) {
+            f(i);
+        }
+    }
+};
+
+struct GEMMThreadPool {
+    ThreadPool &pool_;
+    int budget_;
+
+    template <class F> void operator()(int64_t n, F &&f) const {
+        pool_.parallelFor(
+            n, budget_,
+            [&](int64_t begin, int64_t end, int) {
+                for (int64_t i = begin; i < end; i++) {
+                    f(i);
+                }
+            },
+            1);
+    }
+};
+/** @} */
+
+/**
+ * Row-major C = alpha * op(A) * op(B) + beta * C for each of `batchSize`
+ * matrices, with the same semantics as MKL's `cblas_?gemm_batch_strided`
+ *
+ * Independent GEMMs of a batch run in parallel if each alone does not have
+ * enough tiles to share among the threads
+ */
+template <class T, int VEC_BYTES, bool TRANS_A, bool TRANS_B,
+          class ParallelFor>
+void gemmBatchStrided(int64_t m, int64_t n, int64_t k, T alpha, const T *a,
+                      int64_t lda, int64_t strideA, const T *b, int64_t ldb,
+                      int64_t strideB, T beta, T *c, int64_t ldc,
+                      int64_t strideC, int64_t batchSize,
+                      const ParallelFor &parallelFor) {
+    typedef gemm_detail::Blocking<T, VEC_BYTES> B;
+    int64_t nTiles = ((m + B::MC - 1) / B::MC) * ((n + B::NB - 1) / B::NB);
+    if (batchSize > 1 && nTiles < batchSize) {
+        parallelFor(batchSize, [&](int64_t i) {
+            gemm_detail::gemm<T, VEC_BYTES, TRANS_A, TRANS_B>(
+                m, n, k, alpha, a + i * strideA, lda, b + i * strideB, ldb,
+                beta, c + i * strideC, ldc, GEMMSerial{});
+        });
+    } else {
+        for (int64_t i = 0; i < batchSize; i++) {
+            gemm_detail::gemm<T, VEC_BYTES, TRANS_A, TRANS_B>(
+                m, n, k, alpha, a + i * strideA, lda, b + i * strideB, ldb,
+                beta, c + i * strideC, ldc, parallelFor);
+        }
+    }
+}
+
+#endif // FREE_TENSOR_CPU_GEMM_H
@@ -7,6 +7,8 @@
 #include <cassert>
 #include <cmath> // INFINITY, sqrt, exp
 #include <cstdint>
+#include <cstring> // memcpy
+#include <new>     // align_val_t
 #include <type_traits>
 
 #include <omp.h>
@@ -68,4 +70,117 @@ template <class T> void atomicUpdate(T &x, auto &&update) {
     // of this access with other accesses that cause side effect
 }
 
+/**
+ * Number of threads running concurrently at the current point, counting the
+ * teams of all enclosing OpenMP parallel regions. An inner region run with
+ * only one thread (nesting disabled) does not hide the outer team
+ */
+inline int ompTeamThreads() {
+    int ret = 1;
+    for (int level = omp_get_level(); level > 0; level--) {
+        ret *= std::max(1, omp_get_team_size(level));
+    }
+    return ret;
+}
+
+/**
+ * Number of threads of a multi-threaded library call (e.g. MKL) in a parallel
+ * loop of `extent` iterations run by `team` threads, to share `cores` cores
+ * without oversubscription
+ */
+inline int nestedThreadBudget(int cores, int64_t extent, int team) {
+    int busy = std::max<int64_t>(1, std::min<int64_t>(extent, team));
+    return std::max(1, cores / busy);
+}
+
+/**
+ * Thread-local stacks of a program, one per slot of the `ThreadPool` (allocated
+ * on the first run) or per OpenMP thread number (allocated on loading)
+ */
+inline void ensureThreadStacks(uint8_t **&stacks, int &nStacks, int nSlots,
+                               size_t size, std::align_val_t align) {
+    if (nStacks >= nSlots) {
+        return;
+    }
+    auto newStacks = new uint8_t *[nSlots];
+    for (int i = 0; i < nSlots; i++) {
+        newStacks[i] = i < nStacks ? stacks[i] : new (align) uint8_t[size];
+    }
+    delete[] stacks;
+    stacks = newStacks;
+    nStacks = nSlots;
+}
+
+inline void freeThreadStacks(uint8_t **&stacks, int &nStacks,
+                             std::align_val_t align) {
+    for (int i = 0; i < nStacks; i++) {
+        operator delete[](stacks[i], align);
+    }
+    delete[] stacks;
+    stacks = nullptr;
+    nStacks = 0;
+}
+
+/**
+ * Explicit SIMD vectors, generated by `cpu::lowerVector`
+ *
+ * The vectors are GCC's vector extensions (also supported by Clang), which
+ * support element-wise arithmetics, and are lowered to SIMD instructions of
+ * the target (or split into narrower ones if not supported)
+ */
+template <class T, int N> struct SIMDVecImpl {
+    typedef T type __attribute__((vector_size(N * sizeof(T))));
+};
+template <class T, int N> using SIMDVec = typename SIMDVecImpl<T, N>::type;
+
+template <class T, int N> inline SIMDVec<T, N> simdBroadcast(T x) {
+    return SIMDVec<T, N>{} + x;
+}
+
+template <class T, int N> inline SIMDVec<T, N> simdIota(T base) {
+    SIMDVec<T, N> ret;
+    for (int i = 0; i < N; i++) {
+        ret[i] = base + i;
+    }
+    return ret;
+}
+
+template <class T, int N> inline SIMDVec<T, N> simdLoad(const T *p) {
+    SIMDVec<T, N> ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+
+template <class T, int N> inline SIMDVec<T, N> simdLoadAligned(const T *p) {
+    return *(const SIMDVec<T, N> *)__builtin_assume_aligned(
+        p, sizeof(SIMDVec<T, N>));
+}
+
+// Load only the first n lanes, without touching memory beyond
+template <class T, int N>
+inline SIMDVec<T, N> simdLoadMasked(const T *p, int64_t n) {
+    SIMDVec<T, N> ret{};
+    memcpy(&ret, p, n * sizeof(T));
+    return ret;
+}
+
+template <class T, int N> inline void simdStore(T *p, SIMDVec<T, N> x) {
+    memcpy(p, &x, sizeof(x));
+}
+
+template <class T, int N> inline void simdStoreAligned(T *p, SIMDVec<T, N> x) {
+    *(SIMDVec<T, N> *)__builtin_assume_aligned(p, sizeof(x)) = x;
+}
+
+// Store only the first n lanes, without touching memory beyond
+template <class T, int N>
+inline void simdStoreMasked(T *p, SIMDVec<T, N> x, int64_t n) {
+    memcpy(p, &x, n * sizeof(T));
+}
+
+template <class V> inline V simdMin(V a, V b) { return a < b ? a : b; }
+template <class V> inline V simdMax(V a, V b) { return a > b ? a : b; }
+
+#include "cpu_gemm.h" // Relies on the SIMD vectors above
+
 #endif // FREE_TENSOR_CPU_RUNTIME_H
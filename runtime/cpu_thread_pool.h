@@ -0,0 +1,253 @@
+#ifndef FREE_TENSOR_CPU_THREAD_POOL_H
+#define FREE_TENSOR_CPU_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A work-stealing thread pool for parallel loops in generated programs, as an
+ * alternative to OpenMP
+ *
+ * A parallel loop is split into chunks, which are claimed dynamically by the
+ * calling thread and by at most `budget - 1` helper tasks pushed to the
+ * workers' queues. An idle worker runs tasks from its own queue first, and
+ * steals from the other queues otherwise. The calling thread claims chunks by
+ * itself and never waits for a helper to start, so busy workers only slow a
+ * loop down instead of blocking it, and nested parallel loops cannot deadlock
+ *
+ * The number of threads running a loop is bounded by both its budget and the
+ * size of the pool, so concurrent programs sharing one pool never
+ * oversubscribe the cores
+ *
+ * Each thread has a "slot": 0 for threads outside of the pool, and 1 to
+ * `numSlots() - 1` for the workers. Generated programs index their
+ * thread-local stacks by the slots
+ *
+ * NOTE: The pool must be created by the FreeTensor library, not by generated
+ * programs, so the workers never run code from an unloaded program. A job only
+ * calls into a program while the program is waiting for it
+ */
+class ThreadPool {
+    static constexpr int CHUNKS_PER_THREAD = 4;
+
+    struct Job {
+        // A plain function pointer instead of `std::function`, so destroying a
+        // job never calls into the program that submitted it
+        void (*fn_)(void *closure, int64_t begin, int64_t end, int slot);
+        void *closure_;
+        int64_t n_, chunk_;
+        std::atomic<int64_t> next_{0}; // Next iteration to claim
+        std::atomic<int64_t> done_{0}; // Number of finished iterations
+    };
+
+    struct Worker {
+        std::mutex lock_;
+        std::deque<std::shared_ptr<Job>> queue_;
+        std::thread thread_;
+        std::thread::id id_;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<int64_t> pending_{0}; // Number of queued tasks
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex idleLock_;
+    std::condition_variable idleCV_;
+
+  public:
+    /**
+     * @param nWorkers : Number of worker threads. The calling threads are
+     * extra, so `hardware_concurrency() - 1` workers fill the machine
+     */
+    explicit ThreadPool(int nWorkers) {
+        workers_.reserve(nWorkers);
+        for (int i = 0; i < nWorkers; i++) {
+            workers_.emplace_back(std::make_unique<Worker>());
+        }
+        for (int i = 0; i < nWorkers; i++) {
+            workers_[i]->thread_ = std::thread([this, i]() { workerLoop(i); });
+            workers_[i]->id_ = workers_[i]->thread_.get_id();
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(idleLock_);
+            stop_ = true;
+        }
+        idleCV_.notify_all();
+        for (auto &&worker : workers_) {
+            worker->thread_.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int numSlots() const { return workers_.size() + 1; }
+
+    /**
+     * Slot of the calling thread
+     */
+    int slot() const {
+        auto id = std::this_thread::get_id();
+        for (size_t i = 0, n = workers_.size(); i < n; i++) {
+            if (workers_[i]->id_ == id) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Maximum number of threads of a `parallelFor` with a budget
+     */
+    int teamSize(int budget) const {
+        return budget <= 0 || budget > numSlots() ? numSlots() : budget;
+    }
+
+    /**
+     * Run `f(begin, end, slot)` over chunks of `[0, n)` in parallel
+     *
+     * @param n : Number of iterations
+     * @param budget : Maximum number of threads to use, including the calling
+     * one. Non-positive for the whole pool
+     * @param chunk : Number of iterations per chunk. Non-positive to split the
+     * loop into `CHUNKS_PER_THREAD` chunks per thread
+     */
+    template <class F>
+    void parallelFor(int64_t n, int budget, F &&f, int64_t chunk = 0) {
+        if (n <= 0) {
+            return;
+        }
+        int mySlot = slot();
+        budget = teamSize(budget);
+        if (chunk <= 0) {
+            chunk = std::max<int64_t>(1, n / ((int64_t)budget *
+                                              CHUNKS_PER_THREAD));
+        }
+        int64_t nChunks = (n + chunk - 1) / chunk;
+        int nHelpers = std::min<int64_t>(budget, nChunks) - 1;
+        if (nHelpers <= 0) {
+            f(0, n, mySlot);
+            return;
+        }
+
+        typedef std::remove_reference_t<F> Closure;
+        auto job = std::make_shared<Job>();
+        job->fn_ = [](void *closure, int64_t begin, int64_t end, int slot) {
+            (*(Closure *)closure)(begin, end, slot);
+        };
+        job->closure_ = (void *)std::addressof(f);
+        job->n_ = n;
+        job->chunk_ = chunk;
+        submit(job, nHelpers, mySlot);
+
+        runChunks(*job, mySlot);
+        while (job->done_.load(std::memory_order_acquire) < n) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Run `f(i, slot)` for each `i` in `[0, n)` as concurrent tasks, e.g. for
+     * independent statements
+     */
+    template <class F> void parallelInvoke(int n, int budget, F &&f) {
+        parallelFor(
+            n, budget,
+            [&](int64_t begin, int64_t end, int slot) {
+                for (int64_t i = begin; i < end; i++) {
+                    f((int)i, slot);
+                }
+            },
+            1);
+    }
+
+  private:
+    static void runChunks(Job &job, int slot) {
+        while (true) {
+            int64_t begin = job.next_.fetch_add(job.chunk_);
+            if (begin >= job.n_) {
+                break;
+            }
+            int64_t end = std::min(begin + job.chunk_, job.n_);
+            job.fn_(job.closure_, begin, end, slot);
+            job.done_.fetch_add(end - begin, std::memory_order_release);
+        }
+    }
+
+    void submit(const std::shared_ptr<Job> &job, int nTasks, int mySlot) {
+        for (int i = 0; i < nTasks; i++) {
+            // Workers push nested tasks to their own queues to keep locality,
+            // while outside threads spread them over the pool
+            size_t q = mySlot > 0 ? mySlot - 1
+                                  : nextQueue_.fetch_add(1) % workers_.size();
+            std::lock_guard<std::mutex> guard(workers_[q]->lock_);
+            workers_[q]->queue_.emplace_back(job);
+        }
+        pending_.fetch_add(nTasks);
+        {
+            // Synchronize with `workerLoop` to avoid lost wake-ups
+            std::lock_guard<std::mutex> guard(idleLock_);
+        }
+        if (nTasks > 1) {
+            idleCV_.notify_all();
+        } else {
+            idleCV_.notify_one();
+        }
+    }
+
+    std::shared_ptr<Job> take(int i, std::mt19937 &rng) {
+        // Own queue: LIFO, for locality of nested tasks
+        {
+            auto &&worker = *workers_[i];
+            std::lock_guard<std::mutex> guard(worker.lock_);
+            if (!worker.queue_.empty()) {
+                auto job = std::move(worker.queue_.back());
+                worker.queue_.pop_back();
+                return job;
+            }
+        }
+        // Steal: FIFO, for the oldest (usually the largest) tasks
+        size_t n = workers_.size();
+        size_t start = rng() % n;
+        for (size_t k = 0; k < n; k++) {
+            auto &&victim = *workers_[(start + k) % n];
+            std::lock_guard<std::mutex> guard(victim.lock_);
+            if (!victim.queue_.empty()) {
+                auto job = std::move(victim.queue_.front());
+                victim.queue_.pop_front();
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void workerLoop(int i) {
+        std::mt19937 rng(i);
+        while (true) {
+            if (auto job = take(i, rng); job != nullptr) {
+                pending_.fetch_sub(1);
+                runChunks(*job, i + 1);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleLock_);
+            idleCV_.wait(lock, [&]() { return stop_ || pending_ > 0; });
+            if (stop_) {
+                return;
+            }
+        }
+    }
+};
+
+#endif // FREE_TENSOR_CPU_THREAD_POOL_H
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <atomic>
 #include <sstream>
 
 #include <analyze/all_uses.h>
@@ -6,6 +7,7 @@
 #include <analyze/find_stmt.h>
 #include <container_utils.h>
 #include <except.h>
+#include <hash_combine.h>
 #include <mutator.h>
 #include <omp_utils.h>
 #include <pass/const_fold.h>
@@ -1127,22 +1129,196 @@ PBMap Dependence::extraCheck(PBMap dep,
     return dep;
 }
 
-void FindDeps::operator()(const Stmt &op, const FindDepsCallback &found) {
+namespace {
+
+/**
+ * Encode the statement IDs in a VarDef and the control flows around it as a
+ * part of the key in `DepsCache`
+ *
+ * Not cacheable if the accesses or the control flows depend on values of other
+ * variables, because whether they vary in a loop is then determined by writes
+ * outside the VarDef (see `findLoopVariance`)
+ */
+class CacheKeyOfVarDef : public Visitor {
+    std::string var_;
+    size_t idHash_ = 0;
+    bool cacheable_ = true;
+
+  public:
+    CacheKeyOfVarDef(const std::string &var) : var_(var) {}
+
+    size_t idHash() const { return idHash_; }
+    bool cacheable() const { return cacheable_; }
+
+    void check(const Expr &expr) {
+        if (cacheable_ && !allReads(expr).empty()) {
+            cacheable_ = false;
+        }
+    }
+
+    template <class T> void checkIndices(const T &op) {
+        if (op->var_ == var_) {
+            for (auto &&idx : op->indices_) {
+                check(idx);
+            }
+        }
+    }
+
+  protected:
+    void visitStmt(const Stmt &op) override {
+        idHash_ = hashCombine(idHash_, std::hash<ID>()(op->id()));
+        Visitor::visitStmt(op);
+    }
+
+    void visit(const For &op) override {
+        check(op->begin_), check(op->end_), check(op->step_);
+        Visitor::visit(op);
+    }
+    void visit(const If &op) override {
+        check(op->cond_);
+        Visitor::visit(op);
+    }
+    void visit(const Assert &op) override {
+        check(op->cond_);
+        Visitor::visit(op);
+    }
+    void visit(const Assume &op) override {
+        check(op->cond_);
+        Visitor::visit(op);
+    }
+    void visit(const Load &op) override {
+        checkIndices(op);
+        Visitor::visit(op);
+    }
+    void visit(const Store &op) override {
+        checkIndices(op);
+        Visitor::visit(op);
+    }
+    void visit(const ReduceTo &op) override {
+        checkIndices(op);
+        Visitor::visit(op);
+    }
+};
+
+/**
+ * Key of a VarDef in `DepsCache`, or an empty string if not cacheable
+ */
+std::string cacheKeyOf(const VarDef &def, const Stmt &root,
+                       const std::string &query) {
+    CacheKeyOfVarDef visitor(def->name_);
+    visitor(def);
+    std::ostringstream os;
+    os << query << "|" << visitor.idHash() << "|";
+    for (Stmt child = def, s = def->parentStmt(); child != root && s.isValid();
+         child = s, s = s->parentStmt()) {
+        os << s->id() << " ";
+        switch (s->nodeType()) {
+        case ASTNodeType::For: {
+            auto loop = s.as<ForNode>();
+            visitor.check(loop->begin_), visitor.check(loop->end_),
+                visitor.check(loop->step_);
+            os << "for " << loop->iter_ << " " << loop->begin_ << " "
+               << loop->end_ << " " << loop->step_ << " "
+               << loop->property_->parallel_;
+            for (auto &&var : loop->property_->noDeps_) {
+                os << " " << var;
+            }
+            break;
+        }
+        case ASTNodeType::If: {
+            auto branch = s.as<IfNode>();
+            visitor.check(branch->cond_);
+            os << "if " << branch->cond_
+               << (child == branch->thenCase_ ? " then" : " else");
+            break;
+        }
+        case ASTNodeType::Assert:
+            visitor.check(s.as<AssertNode>()->cond_);
+            os << "assert " << s.as<AssertNode>()->cond_;
+            break;
+        case ASTNodeType::Assume:
+            visitor.check(s.as<AssumeNode>()->cond_);
+            os << "assume " << s.as<AssumeNode>()->cond_;
+            break;
+        default:;
+        }
+        os << ";";
+    }
+    return visitor.cacheable() ? os.str() : "";
+}
+
+} // Anonymous namespace
+
+std::string FindDeps::cacheQuery() const {
+    if (!cache_.isValid() || opaque_) {
+        return "";
+    }
+    std::ostringstream os;
+    os << (int)mode_ << " " << type_ << " " << ignoreReductionWAW_
+       << eraseOutsideVarDef_ << noProjectOutPrivateAxis_ << " ";
+    for (auto &&dir : direction_) {
+        os << "(";
+        for (auto &&[nodeOrParallel, d] : dir) {
+            if (nodeOrParallel.isNode_) {
+                os << nodeOrParallel.id_;
+            } else {
+                os << "@" << nodeOrParallel.parallel_;
+            }
+            os << ":" << (int)d << ",";
+        }
+        os << ")";
+    }
+    os << " " << cacheTag_;
+    return os.str();
+}
+
+bool FindDeps::run(const Stmt &op, const FindDepsCallback &found,
+                   bool stopAtAny) {
     if (direction_.empty()) {
-        return;
+        return false;
     }
 
     if (mode_ != FindDepsMode::Dep) {
         noProjectOutPrivateAxis_ = true;
     }
 
+    auto defs = findAllStmt(
+        op, [](const Stmt &s) { return s->nodeType() == ASTNodeType::VarDef; });
+
+    // Skip VarDefs known to be free of the dependences from `DepsCache`.
+    // `keys[i]` is non-empty if the result of `defs[i]` shall be saved
+    std::vector<std::string> keys(defs.size());
+    if (auto query = cacheQuery(); !query.empty()) {
+        std::vector<Stmt> toAnalyze;
+        std::vector<std::string> toAnalyzeKeys;
+        for (auto &&def : defs) {
+            auto key = cacheKeyOf(def.as<VarDefNode>(), op, query);
+            if (!key.empty()) {
+                if (auto any = cache_->lookup(def, key); any.has_value()) {
+                    if (!*any) {
+                        continue;
+                    }
+                    if (stopAtAny) {
+                        return true;
+                    }
+                    key.clear(); // Already saved
+                }
+            }
+            toAnalyze.emplace_back(def);
+            toAnalyzeKeys.emplace_back(std::move(key));
+        }
+        defs = std::move(toAnalyze);
+        keys = std::move(toAnalyzeKeys);
+        if (defs.empty()) {
+            return false;
+        }
+    }
+
     FindAllNoDeps noDepsFinder;
     noDepsFinder(op);
 
     // Number the iteration space coordinates variable by variable, in order to
     // make the space more compact, so can be better coalesced
-    auto defs = findAllStmt(
-        op, [](const Stmt &s) { return s->nodeType() == ASTNodeType::VarDef; });
     std::vector<FindAccessPoint> finders;
     finders.reserve(defs.size());
     for (auto &&def : defs) {
@@ -1159,14 +1335,27 @@ void FindDeps::operator()(const Stmt &op, const FindDepsCallback &found) {
 
     auto variantExpr = LAZY(findLoopVariance(op).first);
 
+    // Record whether each VarDef has any dependence. `found` is called by the
+    // wrappers, so it still synchronizes by itself if required
+    std::vector<std::atomic_bool> anyFound(defs.size());
+    std::vector<FindDepsCallback> wrappedFound;
+    wrappedFound.reserve(defs.size());
+    for (size_t i = 0, n = defs.size(); i < n; i++) {
+        wrappedFound.emplace_back(
+            unsyncFunc([&found, &any = anyFound[i]](const Dependence &d) {
+                any = true;
+                found(d);
+            }));
+    }
+
     std::vector<std::function<void()>> tasks;
     std::vector<AnalyzeDeps> analyzers;
     analyzers.reserve(defs.size());
-    for (auto &&accFinder : finders) {
+    for (auto &&[accFinder, f] : views::zip(finders, wrappedFound)) {
         analyzers.emplace_back(
             accFinder.reads(), accFinder.writes(), accFinder.scope2coord(),
-            noDepsFinder.results(), variantExpr, direction_, found, mode_,
-            type_, earlierFilter_, laterFilter_, filter_, ignoreReductionWAW_,
+            noDepsFinder.results(), variantExpr, direction_, f, mode_, type_,
+            earlierFilter_, laterFilter_, filter_, ignoreReductionWAW_,
             eraseOutsideVarDef_, noProjectOutPrivateAxis_);
         auto &analyzer = analyzers.back();
         analyzer.genTasks();
@@ -1174,20 +1363,43 @@ void FindDeps::operator()(const Stmt &op, const FindDepsCallback &found) {
             tasks.emplace_back(task);
         }
     }
-    exceptSafeParallelFor<size_t>(
-        0, tasks.size(), 1, [&](size_t i) { tasks[i](); }, omp_sched_dynamic);
+
+    // If interrupted by an exception, only the VarDefs with dependences found
+    // have known results
+    auto save = [&](bool complete) {
+        for (size_t i = 0, n = defs.size(); i < n; i++) {
+            if (!keys[i].empty() && (complete || anyFound[i])) {
+                cache_->save(defs[i], keys[i], anyFound[i]);
+            }
+        }
+    };
+    try {
+        exceptSafeParallelFor<size_t>(
+            0, tasks.size(), 1, [&](size_t i) { tasks[i](); },
+            omp_sched_dynamic);
+    } catch (...) {
+        save(false);
+        throw;
+    }
+    save(true);
+    return false;
+}
+
+void FindDeps::operator()(const Stmt &op, const FindDepsCallback &found) {
+    run(op, found, false);
 }
 
 bool FindDeps::exists(const Stmt &op) {
     struct DepExistsExcept {};
     try {
-        (*this)(op, unsyncFunc([](const Dependence &dep) {
-                    throw DepExistsExcept();
-                }));
+        return run(op,
+                   unsyncFunc([](const Dependence &dep) {
+                       throw DepExistsExcept();
+                   }),
+                   true);
     } catch (const DepExistsExcept &e) {
         return true;
     }
-    return false;
 }
 
 std::ostream &operator<<(std::ostream &_os, const Dependence &dep) {
@@ -0,0 +1,43 @@
+#include <analyze/deps_cache.h>
+
+namespace freetensor {
+
+thread_local Ref<DepsCache> DepsCache::current_;
+
+std::optional<bool> DepsCache::lookup(const Stmt &def,
+                                      const std::string &key) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (auto it = results_.find(def); it != results_.end()) {
+        if (auto jt = it->second.find(key); jt != it->second.end()) {
+            return jt->second;
+        }
+    }
+    return std::nullopt;
+}
+
+void DepsCache::save(const Stmt &def, const std::string &key, bool found) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (size_ >= maxSize_) {
+        // Results are cheap to recompute compared to keeping sub-ASTs of all
+        // tried programs alive, so simply start over
+        results_.clear();
+        size_ = 0;
+    }
+    size_ += results_[def].insert_or_assign(key, found).second;
+}
+
+void DepsCache::invalidate(const Stmt &def) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (auto it = results_.find(def); it != results_.end()) {
+        size_ -= it->second.size();
+        results_.erase(it);
+    }
+}
+
+void DepsCache::clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    results_.clear();
+    size_ = 0;
+}
+
+} // namespace freetensor
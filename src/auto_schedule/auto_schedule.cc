@@ -16,8 +16,10 @@
 #include <codegen/code_gen.h>
 #include <container_utils.h>
 #include <driver.h>
+#include <hash_combine.h>
 #include <lower.h>
 #include <omp_utils.h>
+#include <serialize/print_ast.h>
 
 namespace freetensor {
 
@@ -45,6 +47,19 @@ AutoSchedule::AutoSchedule(
       paramsSet_(false), rng_(decideSeed(randomSeed, verbose)),
       predictFunc_(std::move(predictFunc)), updateFunc_(std::move(updateFunc)),
       tag_(std::move(tag)), minBlockSize_(minBlockSize), verbose_(verbose) {
+    if (!predictFunc_ && !updateFunc_) {
+        costModel_ = Ref<CostModel>::make();
+        predictFunc_ = [model = costModel_](const Features &features) {
+            return model->predict(features);
+        };
+        updateFunc_ = [model = costModel_](const Features &features,
+                                           const Predicts &flops) {
+            model->update(features, flops);
+        };
+    } else if (!predictFunc_ || !updateFunc_) {
+        ERROR("predictFunc and updateFunc should be set or unset together");
+    }
+
     flop_ = 0;
     auto opCnt =
         structuralFeature(original_.ast())[original_.ast()->id()].opCnt_;
@@ -60,8 +75,9 @@ AutoSchedule::AutoSchedule(
     if (target->type() == TargetType::CPU) {
         ADD_RULE("cache_write", CacheWriteRule, target->type(), verbose_);
         ADD_RULE("multi_level_tiling_with_fusion",
-                 MultiLevelTilingWithFusionRule, target->type());
-        ADD_RULE("multi_level_tiling", MultiLevelTilingRule, target->type());
+                 MultiLevelTilingWithFusionRule, target.as<CPUTarget>());
+        ADD_RULE("multi_level_tiling", MultiLevelTilingRule,
+                 target.as<CPUTarget>());
         ADD_RULE("parallelize", ParallelizeRule);
         ADD_RULE("unroll", UnrollRule, target->type());
     } else {
@@ -75,6 +91,12 @@ AutoSchedule::AutoSchedule(
 #undef ADD_RULE
 
     rules_.emplace_back("skip", Ref<SkipRule>::make());
+
+    measureOptions_.warmups = 3;
+    measureOptions_.minRounds = 5;
+    measureOptions_.maxRounds = 100;
+    measureOptions_.targetRelCI = 0.02;
+    measureOptions_.timeBudget = 1000;
 }
 
 void AutoSchedule::setParams(
@@ -85,35 +107,115 @@ void AutoSchedule::setParams(
     paramsSet_ = true;
 }
 
+void AutoSchedule::setMeasureOptions(const BenchmarkOptions &options,
+                                     double abortRatio) {
+    measureOptions_ = options;
+    abortRatio_ = abortRatio;
+}
+
+void AutoSchedule::setTuningRecords(const Ref<TuningRecordDB> &records,
+                                    bool warmStart) {
+    records_ = records;
+    workload_ = TuningRecordDB::workloadKey(original_.ast(), target_);
+    bestRecord_ = std::nullopt;
+    if (!warmStart || !records_.isValid()) {
+        return;
+    }
+    auto history = records_->query(workload_);
+    if (history.empty()) {
+        return;
+    }
+    Features features;
+    Predicts flopsList;
+    for (auto &&record : history) {
+        // `Sketch::hash` is process-local, so sketches measured by other
+        // processes are recognized by their ASTs in `testAndAdd`
+        recordedASTHashes_.insert(record.astHash);
+        if (!record.features.empty()) {
+            features.emplace_back(record.features);
+            flopsList.emplace_back(flop_ / record.time);
+        }
+    }
+    if (!features.empty()) {
+        updateFunc_(features, flopsList);
+    }
+    bestRecord_ = history.front();
+    if (verbose_ >= 1) {
+        logger() << "Warm-started from " << history.size()
+                 << " tuning records. Best time: " << bestRecord_->time
+                 << std::endl;
+    }
+}
+
 std::pair<std::vector<double>, std::vector<double>>
 AutoSchedule::measure(const std::vector<Ref<Sketch>> &sketches) {
-    // Compile in parallel, and measure sequentially
-    // TODO: Parallel among computing nodes
+    // Lower and generate code in parallel, submit them to the compile service
+    // to compile, and measure sequentially. Or, pass them to `measureFunc_`,
+    // which may measure them in parallel among computing nodes
 
     if (verbose_ >= 1) {
         logger() << "Compiling code" << std::endl;
     }
     size_t n = sketches.size();
+    std::vector<Func> funcs(n);
+    std::vector<std::string> codes(n);
     std::vector<Ref<Driver>> drivers(n);
 #pragma omp parallel for schedule(dynamic)
     for (size_t i = 0; i < n; i++) {
         try {
-            auto lowered = sketches[i]->lowered();
-            auto code = codeGen(lowered, target_);
-            drivers[i] = Ref<Driver>::make(lowered, code, device_);
+            funcs[i] = sketches[i]->lowered();
+            codes[i] = codeGen(funcs[i], target_);
+            if (!measureFunc_) {
+                drivers[i] =
+                    Ref<Driver>::make(funcs[i], codes[i], device_, false, true);
+            }
         } catch (const std::exception &e) {
             // OpenMP threads won't report an exception message
             std::cerr << "ERROR measure: " << e.what() << std::endl;
+            funcs[i] = nullptr;
             drivers[i] = nullptr;
         }
     }
 
+    if (measureFunc_) {
+        ASSERT(paramsSet_);
+        std::vector<size_t> ids;
+        std::vector<Func> validFuncs;
+        std::vector<std::string> validCodes;
+        for (size_t i = 0; i < n; i++) {
+            if (funcs[i].isValid()) {
+                ids.emplace_back(i);
+                validFuncs.emplace_back(funcs[i]);
+                validCodes.emplace_back(codes[i]);
+            }
+        }
+        auto options = measureOptions_;
+        options.abortThreshold =
+            std::min(options.abortThreshold, abortRatio_ * getBestTime());
+        if (verbose_ >= 1) {
+            logger() << "Measuring time with a custom measure function"
+                     << std::endl;
+        }
+        auto &&[validTimes, validStddevs] =
+            measureFunc_(validFuncs, validCodes, options);
+        ASSERT(validTimes.size() == ids.size());
+        ASSERT(validStddevs.size() == ids.size());
+        std::vector<double> times(n, INFINITY), stddevs(n, 0);
+        for (size_t j = 0, m = ids.size(); j < m; j++) {
+            times[ids[j]] = validTimes[j];
+            stddevs[ids[j]] = validStddevs[j];
+        }
+        return std::make_pair(times, stddevs);
+    }
+
     if (verbose_ >= 1) {
         logger() << "Measuring time" << std::endl;
     }
     std::vector<double> times, stddevs;
     times.reserve(n);
     stddevs.reserve(n);
+    double best = getBestTime();
+    int nAborted = 0;
     for (size_t i = 0; i < n; i++) {
         ASSERT(paramsSet_);
         try {
@@ -122,10 +224,20 @@ AutoSchedule::measure(const std::vector<Ref<Sketch>> &sketches) {
                 stddevs.emplace_back(0);
                 continue;
             }
+            drivers[i]->wait();
             drivers[i]->setArgs(args_, kws_);
-            auto [avg, stddev] = drivers[i]->time(100, 10);
-            times.emplace_back(avg);
-            stddevs.emplace_back(stddev);
+            auto options = measureOptions_;
+            // Sketches clearly slower than the best one are hopeless. Stop
+            // measuring them early, and record what we have measured, which
+            // is still useful for the cost model
+            options.abortThreshold =
+                std::min(options.abortThreshold, abortRatio_ * best);
+            auto result = drivers[i]->benchmark(options);
+            drivers[i]->collectReturns();
+            nAborted += result.aborted;
+            best = std::min(best, result.avg);
+            times.emplace_back(result.avg);
+            stddevs.emplace_back(result.stddev);
         } catch (const std::exception &e) {
             // OpenMP threads won't report an exception message
             std::cerr << "ERROR measure: " << e.what() << std::endl;
@@ -133,6 +245,10 @@ AutoSchedule::measure(const std::vector<Ref<Sketch>> &sketches) {
             stddevs.emplace_back(0);
         }
     }
+    if (verbose_ >= 1 && nAborted > 0) {
+        logger() << nAborted << " clearly slower sketches are not measured "
+                 << "fully" << std::endl;
+    }
     return std::make_pair(times, stddevs);
 }
 
@@ -171,18 +287,39 @@ AutoSchedule::genFeatures(const std::vector<Ref<Sketch>> &sketches) {
 }
 
 std::vector<double>
-AutoSchedule::testAndAdd(const std::vector<Ref<Sketch>> &sketches) {
+AutoSchedule::testAndAdd(const std::vector<Ref<Sketch>> &sketchesIn) {
+    std::vector<Ref<Sketch>> sketches;
+    if (recordedASTHashes_.empty()) {
+        sketches = sketchesIn;
+    } else {
+        // Skip sketches already measured in tuning records. Their features
+        // and times have been fed to the cost model in `setTuningRecords`
+        for (auto &&sketch : sketchesIn) {
+            if (recordedASTHashes_.count(sketch->astHash())) {
+                measuredHashes_.insert(sketch->hash());
+            } else {
+                sketches.emplace_back(sketch);
+            }
+        }
+        if (sketches.empty()) {
+            return {};
+        }
+    }
+
     auto features = genFeatures(sketches);
     size_t n = sketches.size();
     ASSERT(features.size() == n);
     auto &&[times, stddevs] = measure(sketches);
+    // Failed or timed-out sketches are not fed to the cost model
+    Features validFeatures;
     std::vector<double> flopsList;
-    for (auto [t, stddev] : views::zip(times, stddevs)) {
+    for (auto &&[t, feature] : views::zip(times, features)) {
         if (t < 1e20) {
+            validFeatures.emplace_back(feature);
             flopsList.emplace_back(flop_ / t);
         }
     }
-    updateFunc_(features, flopsList);
+    updateFunc_(validFeatures, flopsList);
     double allAvg = 0, maxStddevPercent = 0;
     int cnt = 0;
     for (auto &&[t, stddev, sketch] : views::zip(times, stddevs, sketches)) {
@@ -193,6 +330,21 @@ AutoSchedule::testAndAdd(const std::vector<Ref<Sketch>> &sketches) {
             measuredSketches_.emplace_back(sketch);
             measuredSketches_.back()->setTime(t);
             measuredHashes_.insert(sketch->hash());
+            if (records_.isValid()) {
+                TuningRecord record;
+                record.workload = workload_;
+                record.target = TuningRecordDB::targetKey(target_);
+                auto &&schedule = sketch->genSchedule();
+                for (auto &&log : schedule.logs().asVector()) {
+                    record.logs.emplace_back(log->toString());
+                }
+                record.features = sketch->feature();
+                record.time = t;
+                // Print without IDs, so it can be loaded in other processes
+                record.ast = printWithoutIDs(schedule.ast());
+                record.astHash = sketch->astHash();
+                records_->append(record);
+            }
         }
     }
     allAvg /= cnt;
@@ -212,19 +364,32 @@ AutoSchedule::testAndAdd(const std::vector<Ref<Sketch>> &sketches) {
 }
 
 Schedule AutoSchedule::getBestSchedule() {
+    if (bestRecord_.has_value() && bestRecord_->time < getBestMeasuredTime()) {
+        auto ret = original_.fork();
+        ret.applyTuningRecord(*bestRecord_);
+        return ret;
+    }
     if (measuredSketches_.empty()) {
         return {};
     }
     return measuredSketches_[0]->genSchedule();
 }
 
-double AutoSchedule::getBestTime() {
+double AutoSchedule::getBestMeasuredTime() const {
     if (measuredSketches_.empty()) {
         return INFINITY;
     }
     return measuredSketches_[0]->time();
 }
 
+double AutoSchedule::getBestTime() {
+    auto ret = getBestMeasuredTime();
+    if (bestRecord_.has_value()) {
+        ret = std::min(ret, bestRecord_->time);
+    }
+    return ret;
+}
+
 std::vector<Ref<Sketch>> AutoSchedule::getRandPopulation(size_t nRand) {
     std::vector<Ref<Sketch>> ret;
     std::set<size_t> used(measuredHashes_);
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cmath>
+
+#include <auto_schedule/cost_model.h>
+#include <except.h>
+
+namespace freetensor {
+
+static constexpr int N_BINS = 64;
+
+CostModel::CostModel(int nTrees, int maxDepth, double learningRate,
+                     int minSamplesLeaf, double lambda, size_t maxSamples)
+    : nTrees_(nTrees), maxDepth_(maxDepth), minSamplesLeaf_(minSamplesLeaf),
+      learningRate_(learningRate), lambda_(lambda), maxSamples_(maxSamples) {
+    ASSERT(nTrees_ > 0 && maxDepth_ > 0 && minSamplesLeaf_ > 0);
+}
+
+void CostModel::update(const Features &features, const Predicts &flops) {
+    ASSERT(features.size() == flops.size());
+    for (size_t i = 0, n = features.size(); i < n; i++) {
+        if (!std::isfinite(flops[i]) || flops[i] <= 0) {
+            continue;
+        }
+        if (!xs_.empty() && features[i].size() != xs_.front().size()) {
+            ERROR("Features of different lengths are fed to the cost model");
+        }
+        xs_.emplace_back(features[i]);
+        ys_.emplace_back(std::log(flops[i]));
+    }
+    if (xs_.size() > maxSamples_) {
+        auto drop = xs_.size() - maxSamples_;
+        xs_.erase(xs_.begin(), xs_.begin() + drop);
+        ys_.erase(ys_.begin(), ys_.begin() + drop);
+    }
+    train();
+}
+
+void CostModel::train() {
+    trees_.clear();
+    size_t n = xs_.size();
+    if (n == 0) {
+        return;
+    }
+    size_t nFeat = xs_.front().size();
+
+    // Quantile cuts of each feature. A sample goes left in a split at cut k if
+    // its value <= thresholds[f][k], i.e. its bin <= k. Bins are stored
+    // feature-major, for building histograms of one feature at a time
+    std::vector<std::vector<double>> thresholds(nFeat);
+    std::vector<std::vector<uint8_t>> binned(nFeat, std::vector<uint8_t>(n));
+#pragma omp parallel for schedule(dynamic)
+    for (size_t f = 0; f < nFeat; f++) {
+        std::vector<double> col(n);
+        for (size_t i = 0; i < n; i++) {
+            col[i] = xs_[i][f];
+        }
+        std::sort(col.begin(), col.end());
+        auto &thr = thresholds[f];
+        for (int q = 1; q < N_BINS; q++) {
+            double cut = col[q * n / N_BINS];
+            if (cut < col.back() && (thr.empty() || cut > thr.back())) {
+                thr.emplace_back(cut);
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            binned[f][i] =
+                std::lower_bound(thr.begin(), thr.end(), xs_[i][f]) -
+                thr.begin();
+        }
+    }
+
+    base_ = 0;
+    for (double y : ys_) {
+        base_ += y;
+    }
+    base_ /= n;
+    std::vector<double> preds(n, base_), residuals(n);
+    std::vector<size_t> samples(n);
+    for (int t = 0; t < nTrees_; t++) {
+        for (size_t i = 0; i < n; i++) {
+            residuals[i] = ys_[i] - preds[i];
+            samples[i] = i;
+        }
+        Tree tree;
+        buildNode(tree, samples, 0, n, 0, binned, thresholds, residuals);
+        for (size_t i = 0; i < n; i++) {
+            int node = 0;
+            while (tree[node].feature_ != -1) {
+                node = binned[tree[node].feature_][i] <= tree[node].threshold_
+                           ? tree[node].left_
+                           : tree[node].right_;
+            }
+            preds[i] += tree[node].value_;
+        }
+        // Store real-valued thresholds for prediction
+        for (auto &node : tree) {
+            if (node.feature_ != -1) {
+                node.threshold_ =
+                    thresholds[node.feature_][(int)node.threshold_];
+            }
+        }
+        trees_.emplace_back(std::move(tree));
+    }
+}
+
+int CostModel::buildNode(Tree &tree, std::vector<size_t> &samples,
+                         size_t begin, size_t end, int depth,
+                         const std::vector<std::vector<uint8_t>> &binned,
+                         const std::vector<std::vector<double>> &thresholds,
+                         const std::vector<double> &residuals) const {
+    int id = tree.size();
+    tree.emplace_back();
+
+    size_t n = end - begin;
+    double sum = 0;
+    for (size_t i = begin; i < end; i++) {
+        sum += residuals[samples[i]];
+    }
+    tree[id].value_ = learningRate_ * sum / (n + lambda_);
+    if (depth >= maxDepth_ || n < 2 * (size_t)minSamplesLeaf_) {
+        return id;
+    }
+
+    // Find the best split of each feature in parallel, and pick the best one
+    // serially to be deterministic
+    size_t nFeat = thresholds.size();
+    double parentScore = sum * sum / (n + lambda_);
+    std::vector<double> bestGain(nFeat, 0);
+    std::vector<int> bestCut(nFeat, -1);
+#pragma omp parallel for schedule(dynamic) if (n * nFeat > 65536)
+    for (size_t f = 0; f < nFeat; f++) {
+        int nCuts = thresholds[f].size();
+        if (nCuts == 0) {
+            continue;
+        }
+        double histSum[N_BINS] = {0};
+        size_t histCnt[N_BINS] = {0};
+        for (size_t i = begin; i < end; i++) {
+            auto s = samples[i];
+            histSum[binned[f][s]] += residuals[s];
+            histCnt[binned[f][s]]++;
+        }
+        double leftSum = 0;
+        size_t leftCnt = 0;
+        for (int k = 0; k < nCuts; k++) {
+            leftSum += histSum[k];
+            leftCnt += histCnt[k];
+            size_t rightCnt = n - leftCnt;
+            if (leftCnt < (size_t)minSamplesLeaf_ ||
+                rightCnt < (size_t)minSamplesLeaf_) {
+                continue;
+            }
+            double rightSum = sum - leftSum;
+            double gain = leftSum * leftSum / (leftCnt + lambda_) +
+                          rightSum * rightSum / (rightCnt + lambda_) -
+                          parentScore;
+            if (gain > bestGain[f]) {
+                bestGain[f] = gain;
+                bestCut[f] = k;
+            }
+        }
+    }
+    int feature = -1;
+    for (size_t f = 0; f < nFeat; f++) {
+        if (bestCut[f] != -1 &&
+            (feature == -1 || bestGain[f] > bestGain[feature])) {
+            feature = f;
+        }
+    }
+    if (feature == -1 || bestGain[feature] <= 1e-12) {
+        return id;
+    }
+
+    int cut = bestCut[feature];
+    auto mid = std::partition(
+        samples.begin() + begin, samples.begin() + end,
+        [&](size_t s) { return binned[feature][s] <= cut; });
+    size_t split = mid - samples.begin();
+    int left = buildNode(tree, samples, begin, split, depth + 1, binned,
+                         thresholds, residuals);
+    int right = buildNode(tree, samples, split, end, depth + 1, binned,
+                          thresholds, residuals);
+    // `tree` may have been reallocated, so do not hold references across the
+    // recursion
+    tree[id].feature_ = feature;
+    tree[id].threshold_ = cut; // Converted to a real value after the tree
+    tree[id].left_ = left;
+    tree[id].right_ = right;
+    return id;
+}
+
+double CostModel::predictOne(const std::vector<double> &x) const {
+    double ret = base_;
+    for (auto &&tree : trees_) {
+        int node = 0;
+        while (tree[node].feature_ != -1) {
+            node = x[tree[node].feature_] <= tree[node].threshold_
+                       ? tree[node].left_
+                       : tree[node].right_;
+        }
+        ret += tree[node].value_;
+    }
+    return std::exp(ret);
+}
+
+CostModel::Predicts CostModel::predict(const Features &features) const {
+    Predicts ret(features.size(), 1);
+    if (trees_.empty()) {
+        return ret;
+    }
+    size_t nFeat = xs_.front().size();
+    for (auto &&x : features) {
+        if (x.size() != nFeat) {
+            ERROR("Features of different lengths are fed to the cost model");
+        }
+    }
+#pragma omp parallel for schedule(static) if (features.size() > 64)
+    for (size_t i = 0; i < features.size(); i++) {
+        ret[i] = predictOne(features[i]);
+    }
+    return ret;
+}
+
+} // namespace freetensor
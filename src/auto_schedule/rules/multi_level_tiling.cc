@@ -14,32 +14,68 @@ RuleStatus MultiLevelTilingRule::analyze(const Sketch &sketch) {
 
 std::vector<Ref<Sketch>> MultiLevelTilingRule::genPart(const Sketch &sketch) {
     auto newSketch = sketch.clone();
-    newSketch->addPart(
-        Ref<MultiLevelTilingPart>::make(sketch.nowSubSketch().target, pat_));
+    auto &&target = sketch.nowSubSketch().target;
+    auto &&ast = sketch.schedule().ast();
+    newSketch->addPart(Ref<MultiLevelTilingPart>::make(
+        target, pat_, cacheCapacity(ast, target.dest, l1Size_),
+        cacheCapacity(ast, target.dest, l2Size_)));
     newSketch->addLog("multi_level_tiling");
     return {newSketch};
 }
 
+bool MultiLevelTilingPart::fitsCache(
+    const MultiLevelTilingAnnotation &annotation) const {
+    auto fits = [&](int level, int64_t capacity) {
+        if (capacity == 0 || level >= spaceLoopTimes_ ||
+            level >= reductionLoopTimes_) {
+            return true;
+        }
+        double space = 1, reduction = 1;
+        for (auto &&tiling : annotation.spaceLoopTiling) {
+            for (int i = 0; i <= level; i++) {
+                space *= tiling[i];
+            }
+        }
+        for (auto &&tiling : annotation.reductionLoopTiling) {
+            for (int i = 0; i <= level; i++) {
+                reduction *= tiling[i];
+            }
+        }
+        double footprint =
+            space + target_.reads.size() * reduction * std::sqrt(space);
+        return footprint <= capacity;
+    };
+    return fits(0, l1Elems_) && fits(1, l2Elems_);
+}
+
 void MultiLevelTilingPart::genRandAnnotation(RNG &gen) {
     int spaceLoopLength = target_.spaceLoops.size();
     int reductionLoopLength = target_.reductionLoops.size();
-    std::vector<std::vector<int>> spaceLoopTiling(spaceLoopLength);
-    std::vector<std::vector<int>> reductionLoopTiling(reductionLoopLength);
-    for (int i = 0; i < spaceLoopLength; i++) {
-        spaceLoopTiling[i] =
-            randomFillArray(target_.spaceLoops[i].length, spaceLoopTimes_, gen);
-    }
-    for (int i = 0; i < reductionLoopLength; i++) {
-        reductionLoopTiling[i] = randomFillArray(
-            target_.reductionLoops[i].length, reductionLoopTimes_, gen);
+    MultiLevelTilingAnnotation annotation;
+    annotation.spaceLoopTiling.resize(spaceLoopLength);
+    annotation.reductionLoopTiling.resize(reductionLoopLength);
+    // Retry for tiles fitting the caches, but do not insist on it if the
+    // estimation is too pessimistic
+    for (int tries = 0; tries < MAX_CACHE_FIT_TRIES; tries++) {
+        for (int i = 0; i < spaceLoopLength; i++) {
+            annotation.spaceLoopTiling[i] = randomFillArray(
+                target_.spaceLoops[i].length, spaceLoopTimes_, gen);
+        }
+        for (int i = 0; i < reductionLoopLength; i++) {
+            annotation.reductionLoopTiling[i] = randomFillArray(
+                target_.reductionLoops[i].length, reductionLoopTimes_, gen);
+        }
+        if (fitsCache(annotation)) {
+            break;
+        }
     }
-    annotation_.spaceLoopTiling = spaceLoopTiling;
-    annotation_.reductionLoopTiling = reductionLoopTiling;
+    annotation_ = std::move(annotation);
 }
 
 MultiLevelTilingPart::MultiLevelTilingPart(ForsWithDataReuse fors,
-                                           std::string pat)
-    : pat_(std::move(pat)) {
+                                           std::string pat, int64_t l1Elems,
+                                           int64_t l2Elems)
+    : pat_(std::move(pat)), l1Elems_(l1Elems), l2Elems_(l2Elems) {
     target_ = std::move(fors);
     spaceLoopTimes_ = 0;
     frontSpaceLoopTimes_ = 0;
@@ -72,16 +108,21 @@ bool MultiLevelTilingPart::mutate(RNG &gen) {
     } else if (!reduceSize) {
         mutPart = 0;
     }
+    MultiLevelTilingAnnotation mut = annotation_;
     if (mutPart == 0) {
         int mut_idx = randomInt(target_.spaceLoops.size() - 1, gen);
-        annotation_.spaceLoopTiling[mut_idx] = randomFillArray(
+        mut.spaceLoopTiling[mut_idx] = randomFillArray(
             target_.spaceLoops[mut_idx].length, spaceLoopTimes_, gen);
 
     } else {
         int mut_idx = randomInt(target_.reductionLoops.size() - 1, gen);
-        annotation_.reductionLoopTiling[mut_idx] = randomFillArray(
+        mut.reductionLoopTiling[mut_idx] = randomFillArray(
             target_.reductionLoops[mut_idx].length, reductionLoopTimes_, gen);
     }
+    if (fitsCache(annotation_) && !fitsCache(mut)) {
+        return false;
+    }
+    annotation_ = std::move(mut);
     return true;
 }
 
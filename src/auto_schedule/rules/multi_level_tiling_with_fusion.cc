@@ -23,11 +23,15 @@ RuleStatus MultiLevelTilingWithFusionRule::analyze(const Sketch &sketch) {
 std::vector<Ref<Sketch>>
 MultiLevelTilingWithFusionRule::genPart(const Sketch &sketch) {
     std::vector<Ref<Sketch>> ret;
+    auto &&target = sketch.nowSubSketch().target;
+    auto &&ast = sketch.schedule().ast();
+    auto l1Elems = cacheCapacity(ast, target.dest, l1Size_);
+    auto l2Elems = cacheCapacity(ast, target.dest, l2Size_);
     for (size_t i = 0; i < fuseLevels_.size(); i++) {
         auto newSketch = sketch.clone();
         newSketch->addPart(Ref<MultiLevelTilingWithFusionPart>::make(
-            sketch.nowSubSketch().target, toFuse_, fuseLevels_[i], pat_,
-            targetType_, minBlockSize_));
+            target, toFuse_, fuseLevels_[i], pat_, targetType_, minBlockSize_,
+            l1Elems, l2Elems));
         newSketch->addLog("multi_level_tiling_with_fusion " +
                           std::to_string(fuseLevels_[i]));
         ret.push_back(newSketch);
@@ -40,7 +44,7 @@ void MultiLevelTilingWithFusionPart::genRandAnnotation(RNG &gen) {
     int reductionLoopLength = target_.reductionLoops.size();
     std::vector<std::vector<int>> spaceLoopTiling(spaceLoopLength);
     std::vector<std::vector<int>> reductionLoopTiling(reductionLoopLength);
-    while (true) {
+    for (int tries = 0;; tries++) {
         for (int i = 0; i < spaceLoopLength; i++) {
             spaceLoopTiling[i] = randomFillArray(target_.spaceLoops[i].length,
                                                  spaceLoopTimes_, gen);
@@ -50,7 +54,13 @@ void MultiLevelTilingWithFusionPart::genRandAnnotation(RNG &gen) {
                 target_.reductionLoops[i].length, reductionLoopTimes_, gen);
         }
         if (targetType_ == TargetType::CPU) {
-            break;
+            // Retry for tiles fitting the caches, but do not insist on it if
+            // the estimation is too pessimistic
+            if (tries + 1 >= MAX_CACHE_FIT_TRIES ||
+                fitsCache({spaceLoopTiling, reductionLoopTiling})) {
+                break;
+            }
+            continue;
         }
         int vthread = 1;
         int thread = 1;
@@ -73,8 +83,8 @@ void MultiLevelTilingWithFusionPart::genRandAnnotation(RNG &gen) {
 
 MultiLevelTilingWithFusionPart::MultiLevelTilingWithFusionPart(
     ForsWithDataReuse fors, ElementWiseInfo toFuse, int level, std::string pat,
-    TargetType targetType, int minBlockSize)
-    : MultiLevelTilingPart(std::move(fors), std::move(pat)),
+    TargetType targetType, int minBlockSize, int64_t l1Elems, int64_t l2Elems)
+    : MultiLevelTilingPart(std::move(fors), std::move(pat), l1Elems, l2Elems),
       targetType_(targetType), level_(level), toFuse_(std::move(toFuse)),
       minBlockSize_(minBlockSize) {
     frontSpaceLoopTimes_ = level_;
@@ -119,6 +129,9 @@ bool MultiLevelTilingWithFusionPart::mutate(RNG &gen) {
         mut.reductionLoopTiling[mut_idx] = randomFillArray(
             target_.reductionLoops[mut_idx].length, reductionLoopTimes_, gen);
     }
+    if (fitsCache(annotation_) && !fitsCache(mut)) {
+        return false;
+    }
     annotation_ = mut;
     return true;
 }
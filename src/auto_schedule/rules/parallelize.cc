@@ -29,23 +29,48 @@ void ParallelizePart::apply(Schedule &schedule, SubSketch &subSketch) {
         return;
     }
     lastParallelizedID_ = mergeLoops(schedule, toFuse);
-    schedule.parallelize(lastParallelizedID_, OpenMPScope{});
+    schedule.parallelize(lastParallelizedID_,
+                         OpenMPScope{(OpenMPScope::Schedule)schedule_,
+                                     CHUNK_SIZES[chunkIdx_]});
 }
 
 void ParallelizePart::genRandAnnotation(RNG &gen) {
     parallelSize_ = randomInt(maxSize_ - 1, gen) + 1;
+    schedule_ = randomInt(OpenMPScope::Guided, gen);
+    chunkIdx_ = randomInt(N_CHUNK_SIZES - 1, gen);
 }
 
-void ParallelizePart::genFakeAnnotation(RNG &gen) { parallelSize_ = maxSize_; }
+void ParallelizePart::genFakeAnnotation(RNG &gen) {
+    parallelSize_ = maxSize_;
+    schedule_ = OpenMPScope::Default;
+    chunkIdx_ = 0;
+}
 
 bool ParallelizePart::mutate(RNG &gen) {
-    parallelSize_ = randomInt(maxSize_ - 1, gen) + 1;
+    switch (randomInt(2, gen)) {
+    case 0:
+        parallelSize_ = randomInt(maxSize_ - 1, gen) + 1;
+        break;
+    case 1:
+        schedule_ = randomInt(OpenMPScope::Guided, gen);
+        break;
+    default:
+        chunkIdx_ = randomInt(N_CHUNK_SIZES - 1, gen);
+    }
     return true;
 }
 bool ParallelizePart::crossover(const SketchPart &part, RNG &gen) {
     if (auto p = part.as<ParallelizePart>();
         p.isValid() && p->partType() == SketchPartType::Parallelize) {
-        parallelSize_ = p->parallelSize_;
+        // Take the degree of parallelism and the load balancing policy from
+        // either parent independently
+        if (randomInt(1, gen)) {
+            parallelSize_ = p->parallelSize_;
+        }
+        if (randomInt(1, gen)) {
+            schedule_ = p->schedule_;
+            chunkIdx_ = p->chunkIdx_;
+        }
         return true;
     }
     return false;
@@ -3,6 +3,7 @@
 #include <auto_schedule/sketch.h>
 #include <auto_schedule/utils.h>
 #include <hash.h>
+#include <hash_combine.h>
 #include <lower.h>
 
 namespace freetensor {
@@ -94,4 +95,11 @@ const std::vector<double> &Sketch::feature() {
     return *feature_;
 }
 
+uint64_t Sketch::astHash() {
+    if (!astHash_.has_value()) {
+        astHash_ = stableHash(printWithoutIDs(genSchedule().ast()));
+    }
+    return *astHash_;
+}
+
 } // namespace freetensor
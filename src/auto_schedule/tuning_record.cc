@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdio>  // snprintf
+#include <fcntl.h> // open
+#include <fstream>
+#include <sstream>
+#include <sys/file.h> // flock
+#include <unistd.h>   // write, close
+
+#include <auto_schedule/tuning_record.h>
+#include <container_utils.h>
+#include <except.h>
+#include <hash_combine.h>
+#include <serialize/print_ast.h>
+
+namespace freetensor {
+
+static const std::string RECORD_MAGIC = "REC2";
+
+static std::string escape(const std::string &str) {
+    std::string ret;
+    ret.reserve(str.size());
+    for (char c : str) {
+        switch (c) {
+        case '\\':
+            ret += "\\\\";
+            break;
+        case '\t':
+            ret += "\\t";
+            break;
+        case '\n':
+            ret += "\\n";
+            break;
+        default:
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+static std::string unescape(const std::string &str) {
+    std::string ret;
+    ret.reserve(str.size());
+    for (size_t i = 0, n = str.size(); i < n; i++) {
+        if (str[i] == '\\' && i + 1 < n) {
+            switch (str[++i]) {
+            case 't':
+                ret += '\t';
+                break;
+            case 'n':
+                ret += '\n';
+                break;
+            default:
+                ret += str[i];
+            }
+        } else {
+            ret += str[i];
+        }
+    }
+    return ret;
+}
+
+static std::string formatDouble(double x) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", x);
+    return buf;
+}
+
+static std::string toLine(const TuningRecord &record) {
+    std::string logs, features;
+    for (auto &&[i, log] : views::enumerate(record.logs)) {
+        logs += (i > 0 ? "\n" : "") + log;
+    }
+    for (auto &&[i, feature] : views::enumerate(record.features)) {
+        features += (i > 0 ? " " : "") + formatDouble(feature);
+    }
+    return RECORD_MAGIC + "\t" + escape(record.workload) + "\t" +
+           std::to_string(record.astHash) + "\t" + escape(record.target) +
+           "\t" + escape(logs) + "\t" + features + "\t" +
+           formatDouble(record.time) + "\t" + escape(record.ast) + "\n";
+}
+
+static std::optional<TuningRecord> fromLine(const std::string &line) {
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    while (true) {
+        auto end = line.find('\t', begin);
+        fields.emplace_back(line.substr(begin, end - begin));
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    if (fields.size() != 8 || fields[0] != RECORD_MAGIC) {
+        return std::nullopt;
+    }
+    try {
+        TuningRecord ret;
+        ret.workload = unescape(fields[1]);
+        ret.astHash = std::stoull(fields[2]);
+        ret.target = unescape(fields[3]);
+        if (auto logs = unescape(fields[4]); !logs.empty()) {
+            std::istringstream is(logs);
+            for (std::string log; std::getline(is, log);) {
+                ret.logs.emplace_back(log);
+            }
+        }
+        std::istringstream is(fields[5]);
+        for (double feature; is >> feature;) {
+            ret.features.emplace_back(feature);
+        }
+        ret.time = std::stod(fields[6]);
+        ret.ast = unescape(fields[7]);
+        return ret;
+    } catch (const std::logic_error &) { // Thrown by std::sto*
+        return std::nullopt;
+    }
+}
+
+TuningRecordDB::TuningRecordDB(const std::string &path) : path_(path) {
+    reload();
+}
+
+void TuningRecordDB::add(TuningRecord &&record) {
+    byWorkload_[record.workload].emplace_back(records_.size());
+    records_.emplace_back(std::move(record));
+}
+
+void TuningRecordDB::append(const TuningRecord &record) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!path_.empty()) {
+        // Write a whole line with one `write` to an `O_APPEND` file, under a
+        // `flock` in case of other processes
+        auto line = toLine(record);
+        int fd = open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0) {
+            throw DriverError("Unable to open tuning records " + path_);
+        }
+        flock(fd, LOCK_EX);
+        auto written = write(fd, line.data(), line.size());
+        close(fd);
+        if (written != (ssize_t)line.size()) {
+            throw DriverError("Unable to write tuning records " + path_);
+        }
+    }
+    add(TuningRecord(record));
+}
+
+void TuningRecordDB::reload() {
+    std::lock_guard<std::mutex> guard(lock_);
+    records_.clear();
+    byWorkload_.clear();
+    if (path_.empty()) {
+        return;
+    }
+    std::ifstream f(path_);
+    for (std::string line; std::getline(f, line);) {
+        if (f.eof()) {
+            break; // Truncated last line without '\n'
+        }
+        if (auto record = fromLine(line); record.has_value()) {
+            add(std::move(*record));
+        }
+    }
+}
+
+std::vector<TuningRecord> TuningRecordDB::query(const std::string &workload,
+                                                size_t limit) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::vector<TuningRecord> ret;
+    if (auto it = byWorkload_.find(workload); it != byWorkload_.end()) {
+        for (size_t i : it->second) {
+            ret.emplace_back(records_[i]);
+        }
+    }
+    std::stable_sort(ret.begin(), ret.end(),
+                     [](const TuningRecord &lhs, const TuningRecord &rhs) {
+                         return lhs.time < rhs.time;
+                     });
+    if (limit > 0 && ret.size() > limit) {
+        ret.resize(limit);
+    }
+    return ret;
+}
+
+std::optional<TuningRecord>
+TuningRecordDB::best(const std::string &workload) const {
+    auto ret = query(workload, 1);
+    if (ret.empty()) {
+        return std::nullopt;
+    }
+    return ret.front();
+}
+
+size_t TuningRecordDB::size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return records_.size();
+}
+
+std::string TuningRecordDB::workloadKey(const Stmt &ast,
+                                        const Ref<Target> &target) {
+    // Print without IDs, which differ from process to process
+    auto txt = toString(ast, false, false, true, true, true);
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx",
+             (unsigned long long)stableHash(targetKey(target) + "\n" + txt));
+    return buf;
+}
+
+std::string TuningRecordDB::targetKey(const Ref<Target> &target) {
+    std::string ret = target->toString();
+    if (target->useNativeArch()) {
+        ret += " native";
+    }
+    if (target->type() == TargetType::CPU) {
+        // Schedules are tuned for the SIMD width and the cache sizes
+        auto &&cpu = target.as<CPUTarget>();
+        ret += " " + cpu->isa() + " L1=" +
+               std::to_string(cpu->l1DataCacheSize()) +
+               " L2=" + std::to_string(cpu->l2CacheSize()) +
+               " L3=" + std::to_string(cpu->l3CacheSize());
+        if (cpu->useThreadPool()) {
+            ret += " thread_pool";
+        }
+    }
+#ifdef FT_WITH_CUDA
+    if (target->type() == TargetType::GPU) {
+        auto cc = target.as<GPUTarget>()->computeCapability();
+        ret += " sm_" + std::to_string(cc.first) + std::to_string(cc.second);
+    }
+#endif // FT_WITH_CUDA
+    return ret;
+}
+
+} // namespace freetensor
@@ -1,13 +1,14 @@
 #include <codegen/code_gen.h>
 #include <codegen/code_gen_cpu.h>
 #include <codegen/code_gen_cuda.h>
+#include <serialize/mangle.h>
 
 namespace freetensor {
 
 std::string codeGen(const Func &func, const Ref<Target> &target) {
     switch (target->type()) {
     case TargetType::CPU:
-        return codeGenCPU(func);
+        return codeGenCPU(func, target.as<CPUTarget>());
     case TargetType::GPU:
         return codeGenCUDA(func);
     default:
@@ -15,4 +16,20 @@ std::string codeGen(const Func &func, const Ref<Target> &target) {
     }
 }
 
+std::string codeGen(const std::vector<Func> &funcs,
+                    const Ref<Target> &target) {
+    switch (target->type()) {
+    case TargetType::CPU:
+        return codeGenCPU(funcs, target.as<CPUTarget>());
+    default:
+        ERROR("Generating code of multiple functions in one translation unit "
+              "is not supported for target " +
+              target->toString());
+    }
+}
+
+std::string multiKernelEntry(size_t i, const std::string &funcName) {
+    return "run" + std::to_string(i) + mangle(funcName);
+}
+
 } // namespace freetensor
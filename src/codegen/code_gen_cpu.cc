@@ -1,7 +1,9 @@
+#include <codegen/code_gen.h>
 #include <codegen/code_gen_cpu.h>
 #include <container_utils.h>
 #include <math/utils.h>
 #include <pass/simplify.h>
+#include <reduce_op.h>
 #include <serialize/mangle.h>
 
 #include "detail/code_gen_c.h"
@@ -31,7 +33,7 @@ void CodeGenCPU::genAlloc(const Ref<Tensor> &tensor, const std::string &rawPtr,
     os() << shapePtr << " = " << ndim << " > 0 ? (size_t*)malloc((" << dimPtr
          << " = " << ndim << ") * sizeof(size_t)) : NULL;" << std::endl;
     makeIndent();
-    os() << rawPtr << " = malloc(";
+    os() << rawPtr << " = _ctx->allocReturn(";
     for (auto &&[i, dim] : views::enumerate(tensor->shape())) {
         os() << "(" << shapePtr << "[" << i << "] = ";
         (*this)(dim);
@@ -84,50 +86,18 @@ void CodeGenCPU::visit(const VarDef &op) {
             // e.g.
             // auto &&x = mdspan_r<float, std::extents<5, 5,
             // 5>>(&__threadStack[0]);
+            if (!plan_.planned(op->id())) {
+                ERROR("BUG: Dyanmic sized variables cannot be allocated on "
+                      "stack. Should be transformed to heap-allocated in "
+                      "pass/make_heap_alloc");
+            }
             this->makeIndent();
             this->os() << "auto &&" << name << " = ";
-            std::string rawPtr;
-            if (inParallel_) {
-                rawPtr = "&__threadStack[omp_get_thread_num()][" +
-                         std::to_string(threadStackTop_) + "]";
-            } else {
-                rawPtr =
-                    "&__sharedStack[" + std::to_string(sharedStackTop_) + "]";
-            }
-            this->genMdPtrDef(op, rawPtr);
+            this->genMdPtrDef(op, stackPtr(op));
             this->os() << ";" << std::endl;
-
-            int64_t size = sizeOf(tensor->dtype());
-            for (auto &&dim : shape) {
-                if (dim->nodeType() == ASTNodeType::IntConst) {
-                    size *= dim.as<IntConstNode>()->val_;
-                } else {
-                    ERROR("BUG: Dyanmic sized variables cannot be allocated on "
-                          "stack. Should be transformed to heap-allocated in "
-                          "pass/make_heap_alloc");
-                }
-            }
-
-            // Align to 64 bytes (TODO: look up cache line size from Target)
-            size = ceilDiv<int64_t>(size, 64) * 64;
-
-            if (inParallel_) {
-                threadStackSize_ =
-                    std::max(threadStackSize_, threadStackTop_ + size);
-                threadStackTop_ += size;
-                this->markDef(op);
-                (*this)(op->body_);
-                this->markUndef(op);
-                threadStackTop_ -= size;
-            } else {
-                sharedStackSize_ =
-                    std::max(sharedStackSize_, sharedStackTop_ + size);
-                sharedStackTop_ += size;
-                this->markDef(op);
-                (*this)(op->body_);
-                this->markUndef(op);
-                sharedStackTop_ -= size;
-            }
+            this->markDef(op);
+            (*this)(op->body_);
+            this->markUndef(op);
             break;
         }
 
@@ -139,7 +109,7 @@ void CodeGenCPU::visit(const VarDef &op) {
 }
 
 void CodeGenCPU::visit(const ReduceTo &op) {
-    if (op->sync_) {
+    if (op->sync_ || atomicReduction_.count(def(op->var_))) {
         switch (op->op_) {
         case ReduceOp::Add:
         case ReduceOp::Mul:
@@ -179,16 +149,185 @@ void CodeGenCPU::visit(const ReduceTo &op) {
     }
 }
 
+void CodeGenCPU::genThreadPoolFor(const For &op) {
+    // Scalar reductions are accumulated privately in each chunk, and then
+    // merged atomically. Reductions to arrays are done atomically
+    std::vector<std::pair<Ref<ReductionItem>, std::string>> scalarReductions;
+    for (auto &&r : op->property_->reductions_) {
+        if (buffer(r->var_)->tensor()->shape().empty()) {
+            scalarReductions.emplace_back(r, mangle(r->var_));
+        } else {
+            atomicReduction_.insert(def(r->var_));
+        }
+    }
+
+    // The pool always schedules chunks dynamically, so only the chunk size and
+    // the number of threads are respected. Each task is a chunk
+    int chunk = 1, numThreads = 0;
+    if (auto scope = std::get_if<OpenMPScope>(&op->property_->parallel_)) {
+        chunk = scope->chunk_, numThreads = scope->numThreads_;
+    }
+    std::string budget = "_ctx->numThreads()";
+    if (numThreads > 0) {
+        budget = "std::min(" + budget + " > 0 ? " + budget + " : " +
+                 std::to_string(numThreads) + ", " +
+                 std::to_string(numThreads) + ")";
+    }
+    makeIndent();
+    os() << "_ctx->threadPool().parallelFor(";
+    (*this)(op->len_);
+    os() << ", " << budget
+         << ", [&](int64_t __begin, int64_t __end, int __slot) ";
+    beginBlock();
+    for (auto &&[r, var] : scalarReductions) {
+        makeIndent();
+        os() << "auto &&" << var << "_shared = " << var << ";" << std::endl;
+        makeIndent();
+        os() << "std::remove_cvref_t<decltype(" << var << ")> " << var
+             << "_priv = ";
+        (*this)(neutralVal(buffer(r->var_)->tensor()->dtype(), r->op_));
+        os() << ";" << std::endl;
+    }
+    makeIndent();
+    beginBlock();
+    for (auto &&[r, var] : scalarReductions) {
+        makeIndent();
+        os() << "auto &" << var << " = " << var << "_priv;" << std::endl;
+    }
+    auto iterCnt = mangle(op->iter_ + ".cnt");
+    makeIndent();
+    os() << "for (int " << iterCnt << " = __begin; " << iterCnt
+         << " < __end; " << iterCnt << "++) ";
+    beginBlock();
+    makeIndent();
+    os() << "int " << mangle(op->iter_) << " = ";
+    (*this)(op->begin_);
+    os() << " + " << iterCnt << " * ";
+    (*this)(op->step_);
+    os() << ";" << std::endl;
+    auto oldParallel = enterParallel(
+        op->len_, "_ctx->threadPool().teamSize(" + budget + ")");
+    markDefIter(op);
+    (*this)(op->body_);
+    markUndefIter(op);
+    exitParallel(oldParallel);
+    endBlock();
+    endBlock();
+    for (auto &&[r, var] : scalarReductions) {
+        makeIndent();
+        // User names are prefixed by an `_`, so we are safe with `x` here
+        os() << "atomicUpdate(" << var << "_shared, [&](auto &&x) { return ";
+        switch (r->op_) {
+        case ReduceOp::Add:
+            os() << "x + " << var << "_priv";
+            break;
+        case ReduceOp::Mul:
+            os() << "x * " << var << "_priv";
+            break;
+        case ReduceOp::Min:
+            os() << "std::min(x, " << var << "_priv)";
+            break;
+        case ReduceOp::Max:
+            os() << "std::max(x, " << var << "_priv)";
+            break;
+        case ReduceOp::LAnd:
+            os() << "x && " << var << "_priv";
+            break;
+        case ReduceOp::LOr:
+            os() << "x || " << var << "_priv";
+            break;
+        default:
+            ASSERT(false);
+        }
+        os() << "; });" << std::endl;
+    }
+    for (auto &&r : op->property_->reductions_) {
+        if (!buffer(r->var_)->tensor()->shape().empty()) {
+            atomicReduction_.erase(def(r->var_));
+        }
+    }
+    nIndent()--;
+    makeIndent();
+    os() << "}, " << chunk << ");" << std::endl;
+}
+
+void CodeGenCPU::genOpenMPTaskFor(const For &op) {
+    // Reductions among the tasks are done atomically
+    for (auto &&r : op->property_->reductions_) {
+        atomicReduction_.insert(def(r->var_));
+    }
+
+    // One thread creates the tasks, and the whole team runs them
+    os() << "#pragma omp parallel" << std::endl;
+    os() << "#pragma omp single" << std::endl;
+    auto iterCnt = mangle(op->iter_ + ".cnt");
+    makeIndent();
+    os() << "for (int " << iterCnt << " = 0; " << iterCnt << " < ";
+    (*this)(op->len_);
+    os() << "; " << iterCnt << "++) ";
+    beginBlock();
+    makeIndent();
+    os() << "int " << mangle(op->iter_) << " = ";
+    (*this)(op->begin_);
+    os() << " + " << iterCnt << " * ";
+    (*this)(op->step_);
+    os() << ";" << std::endl;
+    os() << "#pragma omp task" << std::endl;
+    makeIndent();
+    beginBlock();
+    auto oldParallel = enterParallel(op->len_, "ompTeamThreads()");
+    markDefIter(op);
+    (*this)(op->body_);
+    markUndefIter(op);
+    exitParallel(oldParallel);
+    endBlock();
+    endBlock();
+
+    for (auto &&r : op->property_->reductions_) {
+        atomicReduction_.erase(def(r->var_));
+    }
+}
+
 void CodeGenCPU::visit(const For &op) {
+    bool isTasks =
+        std::holds_alternative<OpenMPTaskScope>(op->property_->parallel_);
+    if ((std::holds_alternative<OpenMPScope>(op->property_->parallel_) ||
+         isTasks) &&
+        useThreadPool_) {
+        genThreadPoolFor(op);
+        return;
+    }
+    if (isTasks) {
+        if (inParallel_) {
+            // A nested OpenMP parallel region runs with only one thread by
+            // default, which would also share its thread stack with other
+            // threads. Just run the tasks one by one in the current thread
+            BaseClass::visit(op);
+        } else {
+            genOpenMPTaskFor(op);
+        }
+        return;
+    }
+    if (std::holds_alternative<OpenMPScope>(op->property_->parallel_) &&
+        inParallel_ && !collapsed_.count(op)) {
+        // Same as above: a nested region (e.g. in a task) runs with one
+        // thread, whose `omp_get_thread_num()` is 0 in every enclosing thread
+        // or task, so they would all share `__threadStack[0]`. Run it serially
+        // in the current thread, which owns its slot
+        BaseClass::visit(op);
+        return;
+    }
     if (std::holds_alternative<OpenMPScope>(op->property_->parallel_) &&
         !collapsed_.count(op)) {
         int collapse = 1;
+        Expr extent = op->len_;
         for (Stmt inner = op->body_;
              inner->nodeType() == ASTNodeType::For &&
              std::holds_alternative<OpenMPScope>(
                  inner.as<ForNode>()->property_->parallel_);
              inner = inner.as<ForNode>()->body_) {
             collapse++;
+            extent = makeMul(extent, inner.as<ForNode>()->len_);
             collapsed_.insert(inner.as<ForNode>());
             if (!inner.as<ForNode>()->property_->reductions_.empty())
                 ERROR("Collapsed inner parallel loop should not have reduction "
@@ -208,6 +347,20 @@ void CodeGenCPU::visit(const For &op) {
         if (collapse > 1) {
             os() << " collapse(" << collapse << ")";
         }
+        auto &&scope = std::get<OpenMPScope>(op->property_->parallel_);
+        if (scope.schedule_ != OpenMPScope::Default) {
+            os() << " schedule(" << scope.schedule_;
+            if (scope.chunk_ > 0) {
+                os() << ", " << scope.chunk_;
+            }
+            os() << ")";
+        } else if (scope.chunk_ > 0) {
+            os() << " schedule(static, " << scope.chunk_ << ")";
+        }
+        if (scope.numThreads_ > 0) {
+            os() << " num_threads(" << scope.numThreads_ << ")";
+            maxNumThreads_ = std::max(maxNumThreads_, scope.numThreads_);
+        }
         if (!op->property_->reductions_.empty()) {
             for (size_t i = 1, n = op->property_->reductions_.size(); i < n;
                  i++) {
@@ -266,10 +419,9 @@ void CodeGenCPU::visit(const For &op) {
             os() << ")";
         }
         os() << std::endl;
-        bool oldInParallel = inParallel_;
-        inParallel_ = true;
+        auto oldParallel = enterParallel(extent, "ompTeamThreads()");
         BaseClass::visit(op);
-        inParallel_ = oldInParallel;
+        exitParallel(oldParallel);
         for (auto &&r : op->property_->reductions_) {
             if (!buffer(r->var_)->tensor()->shape().empty()) {
                 usedAsReduction_.erase(def(r->var_));
@@ -285,19 +437,10 @@ void CodeGenCPU::visit(const For &op) {
 }
 
 void CodeGenCPU::visit(const MatMul &op) {
-#ifdef FT_WITH_MKL
-    makeIndent();
-    if (inParallel_) {
-        os() << "mkl_set_num_threads_local(1);" << std::endl;
-        // TODO: set it to max(1, cpu_count / outer_threads_count)
-    } else {
-        os() << "mkl_set_num_threads_local(0); // 0 == reset" << std::endl;
-    }
-
     auto d = op->c_->dtype();
     if (op->a_->dtype() != d || op->b_->dtype() != d) {
-        throw InvalidProgram(
-            "MKL requires all matrices have the same data type");
+        throw InvalidProgram("MatMul requires all matrices have the same data "
+                             "type");
     }
 
     bool transA = !op->aIsRowMajor_, transB = !op->bIsRowMajor_;
@@ -315,11 +458,46 @@ void CodeGenCPU::visit(const MatMul &op) {
         std::swap(n, m);
     }
 
-    makeIndent();
-    os() << "cblas_" << genMKLTypeMark(d)
-         << "gemm_batch_strided(CblasRowMajor, "
-         << (transA ? "CblasTrans" : "CblasNoTrans") << ", "
-         << (transB ? "CblasTrans" : "CblasNoTrans") << ", ";
+    // MKL supports only floating-point GEMMs
+    bool useMKL = false;
+#ifdef FT_WITH_MKL
+    useMKL = !useNativeGEMM_ && (d.base() == DataType::Float32 ||
+                                 d.base() == DataType::Float64);
+    if (useMKL) {
+        makeIndent();
+        if (inParallel_) {
+            // Share the cores among the threads running the enclosing parallel
+            // loops. `nestedThreadBudget` and `ompTeamThreads` are defined in
+            // `runtime/cpu_runtime.h`
+            os() << "mkl_set_num_threads_local(nestedThreadBudget("
+                 << (numCores_ > 0 ? std::to_string(numCores_)
+                                   : "omp_get_num_procs()")
+                 << ", ";
+            (*this)(parallelExtent_);
+            os() << ", " << parallelTeam_ << "));" << std::endl;
+        } else if (useThreadPool_) {
+            // Respect the thread budget of the `Driver`
+            os() << "mkl_set_num_threads_local(std::max(_ctx->numThreads(), "
+                    "0)); // 0 == reset"
+                 << std::endl;
+        } else {
+            os() << "mkl_set_num_threads_local(0); // 0 == reset" << std::endl;
+        }
+
+        makeIndent();
+        os() << "cblas_" << genMKLTypeMark(d)
+             << "gemm_batch_strided(CblasRowMajor, "
+             << (transA ? "CblasTrans" : "CblasNoTrans") << ", "
+             << (transB ? "CblasTrans" : "CblasNoTrans") << ", ";
+    }
+#endif // FT_WITH_MKL
+    if (!useMKL) {
+        // `gemmBatchStrided` is defined in `runtime/cpu_gemm.h`
+        makeIndent();
+        os() << "gemmBatchStrided<" << gen(d) << ", " << vectorBytes_ << ", "
+             << (transA ? "true" : "false") << ", "
+             << (transB ? "true" : "false") << ">(";
+    }
     (*this)(m);
     os() << ", ";
     (*this)(n);
@@ -349,64 +527,176 @@ void CodeGenCPU::visit(const MatMul &op) {
     (*this)(stridec);
     os() << ", ";
     (*this)(op->batchSize_);
-    os() << ");" << std::endl;
-#else
-    ERROR("Configuring with MKL is needed");
-#endif
+    if (useMKL) {
+        os() << ");" << std::endl;
+        return;
+    }
+    // Run the tasks of the GEMM by the runtime of the parallel loops, or
+    // serially inside a parallel loop
+    if (inParallel_) {
+        os() << ", GEMMSerial{});" << std::endl;
+    } else if (useThreadPool_) {
+        os() << ", GEMMThreadPool{_ctx->threadPool(), _ctx->numThreads()});"
+             << std::endl;
+    } else {
+        os() << ", GEMMOpenMP{});" << std::endl;
+    }
+}
+
+CodeGenCPU::ParallelState CodeGenCPU::enterParallel(const Expr &extent,
+                                                    const std::string &team) {
+    ParallelState old{inParallel_, parallelExtent_, parallelTeam_};
+    parallelExtent_ = inParallel_ ? makeMul(parallelExtent_, extent) : extent;
+    if (!inParallel_) {
+        // A nested region runs with only one thread by default, so the team
+        // of the outermost one is kept
+        parallelTeam_ = team;
+    }
+    inParallel_ = true;
+    return old;
+}
+
+void CodeGenCPU::exitParallel(const ParallelState &old) {
+    inParallel_ = old.inParallel_;
+    parallelExtent_ = old.extent_;
+    parallelTeam_ = old.team_;
+}
+
+std::string CodeGenCPU::stackPtr(const VarDef &def) const {
+    auto offset = std::to_string(plan_.offset_.at(def->id()));
+    if (inParallel_) {
+        return "&__threadStack[" + threadSlot() + "][" + offset + "]";
+    } else {
+        return "&__sharedStack[" + offset + "]";
+    }
 }
 
-std::string codeGenCPU(const Func &func) {
-    CodeGenCPU visitor(func->params_, func->returns_);
+void CodeGenCPU::visit(const Alloc &op) {
+    auto &&d = def(op->var_);
+    if (!plan_.planned(d->id())) {
+        BaseClass::visit(op);
+        return;
+    }
+
+    // e.g. x_opt = mdspan_r<int, extents<5, 5>>(&__sharedStack[64]);
+    this->markUse(op->var_);
+    this->makeIndent();
+    this->os() << mangle(op->var_) << "_opt = ";
+    this->genMdPtrDef(d, stackPtr(d));
+    this->os() << ";" << std::endl;
+}
+
+void CodeGenCPU::visit(const Free &op) {
+    if (!plan_.planned(def(op->var_)->id())) {
+        BaseClass::visit(op);
+        return;
+    }
+
+    // e.g. x_opt.drop();
+    //      x_opt = std::nullopt;
+    auto &&name = mangle(op->var_);
+    this->makeIndent();
+    this->os() << name << "_opt.drop();" << std::endl;
+    this->makeIndent();
+    this->os() << name << "_opt = std::nullopt;" << std::endl;
+}
+
+/**
+ * Generate the static data and the entry function of a program
+ */
+static std::string genKernel(const Func &func, const std::string &entry,
+                             const Ref<CPUTarget> &target) {
+    // Align stack-allocated variables to cache lines, and no less than the
+    // vector width for aligned SIMD accesses
+    int alignment = std::max(target->cacheLineSize(), target->vectorBytes());
+    CodeGenCPU visitor(func->params_, func->returns_, alignment,
+                       target->useThreadPool(),
+                       cpu::planMemory(func->body_, alignment),
+                       target->useNativeGEMM(), target->physicalCores(),
+                       target->vectorBytes());
+    auto align = "std::align_val_t(" + std::to_string(alignment) + ")";
     auto &&op = func->body_;
     visitor.beginBlock();
     visitor(op);
     visitor.endBlock();
 
-    const char *header = R"~~~(
-#include <cpu_runtime.h>
-
-extern "C" {
-)~~~";
-    const char *tailer = R"~~~(
-}
-)~~~";
-
-    auto body = visitor.toString([&](const CodeGenStream &stream) {
+    return visitor.toString([&](const CodeGenStream &stream) {
         std::string s;
         if (visitor.sharedStackSize() > 0) {
             s += "static uint8_t *__sharedStack = nullptr;\n";
         }
         if (visitor.threadStackSize() > 0) {
             s += "static uint8_t **__threadStack = nullptr;\n";
+            s += "static int __nThreadStacks = 0;\n";
         }
+        // Stacks are aligned to `alignment`, so are variables on them, which
+        // is relied on by aligned SIMD accesses from `cpu::lowerVector`
         s += "__attribute__((constructor)) static void initStack() {\n";
         if (visitor.sharedStackSize() > 0) {
-            s += "  __sharedStack = new uint8_t[" +
+            s += "  __sharedStack = new (" + align + ") uint8_t[" +
                  std::to_string(visitor.sharedStackSize()) + "];\n";
         }
-        if (visitor.threadStackSize() > 0) {
-            s += "  __threadStack = new uint8_t *[omp_get_max_threads()];\n";
-            s += "  #pragma omp parallel\n";
-            s += "  __threadStack[omp_get_thread_num()] = new uint8_t[" +
-                 std::to_string(visitor.threadStackSize()) + "];\n";
+        if (visitor.threadStackSize() > 0 && !visitor.useThreadPool()) {
+            // One slot per thread number, including those of loops with
+            // explicit `num_threads` beyond the default
+            s += "  ensureThreadStacks(__threadStack, __nThreadStacks, "
+                 "std::max(omp_get_max_threads(), " +
+                 std::to_string(visitor.maxNumThreads()) + "), " +
+                 std::to_string(visitor.threadStackSize()) + ", " + align +
+                 ");\n";
         }
         s += "}\n";
         s += "__attribute__((destructor)) static void deinitStack() {\n";
         if (visitor.sharedStackSize() > 0) {
-            s += "  delete[] __sharedStack;\n";
+            s += "  operator delete[](__sharedStack, " + align + ");\n";
         }
         if (visitor.threadStackSize() > 0) {
-            s += "  #pragma omp parallel\n";
-            s += "  delete[] __threadStack[omp_get_thread_num()];\n";
-            s += "  delete[] __threadStack;\n";
+            s += "  freeThreadStacks(__threadStack, __nThreadStacks, " + align +
+                 ");\n";
         }
         s += "}\n";
-        s += "void run(void **_params, void **_returns, size_t **_retShapes, "
+        s += "void " + entry +
+             "(void **_params, void **_returns, size_t **_retShapes, "
              "size_t *_retDims, CPUContext_t _ctx) {\n";
+        if (visitor.threadStackSize() > 0 && visitor.useThreadPool()) {
+            // The number of slots of the pool is only known at run time
+            s += "  ensureThreadStacks(__threadStack, __nThreadStacks, "
+                 "_ctx->threadPool().numSlots(), " +
+                 std::to_string(visitor.threadStackSize()) + ", " + align +
+                 ");\n";
+        }
         s += stream.os_.str();
         s += "}";
         return s;
     });
+}
+
+static const char *header = R"~~~(
+#include <cpu_runtime.h>
+
+extern "C" {
+)~~~";
+static const char *tailer = R"~~~(
+}
+)~~~";
+
+std::string codeGenCPU(const Func &func, const Ref<CPUTarget> &_target) {
+    auto target = _target.isValid() ? _target : Ref<CPUTarget>::make();
+    return header + genKernel(func, "run", target) + tailer;
+}
+
+std::string codeGenCPU(const std::vector<Func> &funcs,
+                       const Ref<CPUTarget> &_target) {
+    auto target = _target.isValid() ? _target : Ref<CPUTarget>::make();
+    std::string body;
+    for (auto &&[i, func] : views::enumerate(funcs)) {
+        // Each program's static data is put in its own namespace, while the
+        // entry function still has a C linkage with a unique name
+        auto entry = multiKernelEntry(i, func->name_);
+        body += "namespace __ns" + entry + " {\n";
+        body += genKernel(func, entry, target);
+        body += "\n} // namespace __ns" + entry + "\n";
+    }
     return header + body + tailer;
 }
 
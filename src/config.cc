@@ -60,6 +60,19 @@ static std::string getStrEnvRequired(const char *name) {
     }
 }
 
+static std::optional<size_t> getSizeEnv(const char *name) {
+    if (auto env = getStrEnv(name); env.has_value()) {
+        try {
+            return std::stoull(*env);
+        } catch (const std::logic_error &) {
+            ERROR((std::string) "Value of " + name +
+                  " must be a non-negative integer");
+        }
+    } else {
+        return std::nullopt;
+    }
+}
+
 static std::optional<bool> getBoolEnv(const char *name) {
     if (auto _env = getStrEnv(name); _env.has_value()) {
         auto &&env = tolower(*_env);
@@ -89,6 +102,20 @@ std::vector<fs::path> Config::backendCompilerNVCC_;
 Ref<Target> Config::defaultTarget_;
 Ref<Device> Config::defaultDevice_;
 std::vector<fs::path> Config::runtimeDir_;
+fs::path Config::kernelCacheDir_;
+size_t Config::kernelCacheSize_ = 1ull << 30; // 1 GiB
+bool Config::precompiledHeader_ = true;
+size_t Config::compileWorkers_ = 0;
+size_t Config::arrayPoolSize_ = 1ull << 30; // 1 GiB
+size_t Config::arrayAlignment_ = 64;        // A cache line
+bool Config::arrayHugePage_ = false;
+bool Config::arrayNUMALocal_ = false;
+size_t Config::pbMemoSize_ = 64ull << 20;           // 64 MiB
+size_t Config::memoizedSchedulesSize_ = 4ull << 30; // 4 GiB
+size_t Config::lowerCacheSize_ = 0;                 // Disabled
+size_t Config::z3QueryTimeout_ = 1000;              // 1 s
+size_t Config::z3PassBudget_ = 30000;               // 30 s
+size_t Config::z3CacheSize_ = 16ull << 20;          // 16 MiB
 
 std::vector<fs::path>
 Config::checkValidPaths(const std::vector<fs::path> &paths, bool required) {
@@ -100,6 +127,16 @@ Config::checkValidPaths(const std::vector<fs::path> &paths, bool required) {
     return ret;
 }
 
+void Config::setArrayAlignment(size_t bytes) {
+    if (bytes < sizeof(void *) || (bytes & (bytes - 1)) != 0) {
+        ERROR("Alignment of Array buffers should be a power of 2 no less "
+              "than " +
+              std::to_string(sizeof(void *)) + ", got " +
+              std::to_string(bytes));
+    }
+    arrayAlignment_ = bytes;
+}
+
 void Config::init() {
     Config::setPrettyPrint(isatty(fileno(stdout)));
 #ifdef FT_BACKEND_COMPILER_CXX
@@ -147,6 +184,52 @@ void Config::init() {
         Config::setBackendCompilerNVCC(makePaths(*path));
     }
 #endif // FT_WITH_CUDA
+    if (auto home = getStrEnv("HOME"); home.has_value()) {
+        Config::setKernelCacheDir(fs::path(*home) / ".freetensor" / "cache");
+    }
+    if (auto path = getStrEnv("FT_KERNEL_CACHE_DIR"); path.has_value()) {
+        Config::setKernelCacheDir(*path);
+    }
+    if (auto size = getSizeEnv("FT_KERNEL_CACHE_SIZE"); size.has_value()) {
+        Config::setKernelCacheSize(*size);
+    }
+    if (auto flag = getBoolEnv("FT_PRECOMPILED_HEADER"); flag.has_value()) {
+        Config::setPrecompiledHeader(*flag);
+    }
+    if (auto n = getSizeEnv("FT_COMPILE_WORKERS"); n.has_value()) {
+        Config::setCompileWorkers(*n);
+    }
+    if (auto size = getSizeEnv("FT_ARRAY_POOL_SIZE"); size.has_value()) {
+        Config::setArrayPoolSize(*size);
+    }
+    if (auto size = getSizeEnv("FT_ARRAY_ALIGNMENT"); size.has_value()) {
+        Config::setArrayAlignment(*size);
+    }
+    if (auto flag = getBoolEnv("FT_ARRAY_HUGE_PAGE"); flag.has_value()) {
+        Config::setArrayHugePage(*flag);
+    }
+    if (auto flag = getBoolEnv("FT_ARRAY_NUMA_LOCAL"); flag.has_value()) {
+        Config::setArrayNUMALocal(*flag);
+    }
+    if (auto size = getSizeEnv("FT_PB_MEMO_SIZE"); size.has_value()) {
+        Config::setPBMemoSize(*size);
+    }
+    if (auto size = getSizeEnv("FT_MEMOIZED_SCHEDULES_SIZE");
+        size.has_value()) {
+        Config::setMemoizedSchedulesSize(*size);
+    }
+    if (auto size = getSizeEnv("FT_LOWER_CACHE_SIZE"); size.has_value()) {
+        Config::setLowerCacheSize(*size);
+    }
+    if (auto ms = getSizeEnv("FT_Z3_QUERY_TIMEOUT"); ms.has_value()) {
+        Config::setZ3QueryTimeout(*ms);
+    }
+    if (auto ms = getSizeEnv("FT_Z3_PASS_BUDGET"); ms.has_value()) {
+        Config::setZ3PassBudget(*ms);
+    }
+    if (auto size = getSizeEnv("FT_Z3_CACHE_SIZE"); size.has_value()) {
+        Config::setZ3CacheSize(*size);
+    }
     auto device = Ref<Device>::make(TargetType::CPU);
     Config::setDefaultDevice(device);
     Config::setDefaultTarget(device->target());
@@ -1,20 +1,29 @@
+#include <atomic>
 #include <chrono>
 #include <cmath>   // sqrt
 #include <cstdio>  // remove
 #include <cstdlib> // mkdtemp, system
 #include <cstring> // memset
 #include <dlfcn.h> // dlopen
+#include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <sched.h> // sched_setaffinity
+#include <sstream>
 #include <sys/stat.h>    // mkdir
 #include <sys/syscall.h> // SYS_fork
 #include <sys/wait.h>    // waitpid
 #include <unistd.h>      // rmdir
+#include <unordered_set>
 
 #include <analyze/find_stmt.h>
 #include <config.h>
 #include <container_utils.h>
 #include <debug.h>
 #include <driver.h>
+#include <driver/array_allocator.h>
+#include <driver/compile_service.h>
+#include <driver/kernel_cache.h>
 #include <except.h>
 #ifdef FT_WITH_CUDA
 #include <driver/gpu.h>
@@ -58,27 +67,115 @@ static void *requestPtr(const Ref<Array> &arr, const Ref<Device> &device,
     }
 }
 
+static void runBackendCompiler(const char *executable,
+                               const std::vector<std::string> &args,
+                               bool verbose) {
+    if (Config::debugBinary() || verbose) {
+        std::stringstream cmdStream;
+        cmdStream << "\"" << executable << "\" ";
+        for (auto &s : args) {
+            cmdStream << "\"" << s << "\" ";
+        }
+        auto cmd = cmdStream.str();
+
+        if (Config::debugBinary()) {
+            WARNING("debug-binary mode on. Compiling with " + cmd);
+        }
+        if (verbose) {
+            logger() << "Running " << cmd << std::endl;
+        }
+    }
+
+    // fork + execv to execute the compiler
+    {
+        // construct the argv array
+        std::vector<const char *> argv;
+        argv.push_back(executable);
+        for (auto &s : args) {
+            argv.push_back(s.c_str());
+        }
+        argv.push_back(nullptr);
+
+        int pid = vfork();
+        if (pid == 0) {
+            execv(executable, const_cast<char *const *>(argv.data()));
+            std::cerr << "Failed to execute " << executable << ": "
+                      << strerror(errno);
+            exit(-1);
+        } else {
+            int status;
+            waitpid(pid, &status, 0);
+            if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
+                // Interrupted (Ctrl+C). Interrupt FreeTensor as well
+                // Do not directly raise SIGINT. See the doc of InterruptExcept
+                throw InterruptExcept();
+            }
+            if (status != 0)
+                throw DriverError("Backend compiler reports error");
+        }
+    }
+}
+
 Driver::Driver(const Func &f, const std::string &src, const Ref<Device> &dev,
-               const Ref<Device> &hostDev, bool verbose)
-    : f_(f), src_(src), args_(f->params_.size(), nullptr),
+               const Ref<Device> &hostDev, bool verbose, bool asyncBuild,
+               const std::string &entry)
+    : entry_(entry), f_(f), src_(src), args_(f->params_.size(), nullptr),
       rawArgs(f->params_.size(), nullptr), rawRets(f->returns_.size(), nullptr),
       retShapes_(f->returns_.size(), nullptr), retDims_(f->returns_.size(), 0),
       dev_(dev), hostDev_(hostDev), verbose_(verbose) {
-    auto nParams = f->params_.size();
+    initParams();
+    build();
+    if (!asyncBuild) {
+        load();
+    }
+}
+
+Driver::Driver(const Func &f, Driver &loaded, const std::string &entry)
+    : entry_(entry), f_(f), src_(loaded.src_),
+      args_(f->params_.size(), nullptr), rawArgs(f->params_.size(), nullptr),
+      rawRets(f->returns_.size(), nullptr),
+      retShapes_(f->returns_.size(), nullptr), retDims_(f->returns_.size(), 0),
+      dev_(loaded.dev_), hostDev_(loaded.hostDev_), verbose_(loaded.verbose_) {
+    initParams();
+    loaded.wait();
+    dlHandle_ = loaded.dlHandle_;
+    binary_ = loaded.binary_;
+    loadEntry();
+}
+
+Driver::Driver(const Func &f, const std::string &src,
+               const Ref<CompiledObject> &binary, const Ref<Device> &dev,
+               const Ref<Device> &hostDev, const std::string &entry,
+               bool verbose)
+    : entry_(entry), f_(f), src_(src), args_(f->params_.size(), nullptr),
+      rawArgs(f->params_.size(), nullptr), rawRets(f->returns_.size(), nullptr),
+      retShapes_(f->returns_.size(), nullptr), retDims_(f->returns_.size(), 0),
+      dev_(dev), hostDev_(hostDev), verbose_(verbose) {
+    initParams();
+    std::promise<Ref<CompiledObject>> ready;
+    ready.set_value(binary);
+    compiled_ = ready.get_future().share();
+    load();
+}
+
+void Driver::initParams() {
+    auto nParams = f_->params_.size();
     name2param_.reserve(nParams);
     name2buffer_.reserve(nParams);
+    param2buffer_.resize(nParams, nullptr);
     for (size_t i = 0; i < nParams; i++) {
-        name2param_[f->params_[i].name_] = i;
-        auto possibleNode = findAllStmt(f->body_, [&](const Stmt &s) -> bool {
+        name2param_[f_->params_[i].name_] = i;
+        auto possibleNode = findAllStmt(f_->body_, [&](const Stmt &s) -> bool {
             return s->nodeType() == ASTNodeType::VarDef &&
-                   s.as<VarDefNode>()->name_ == f->params_[i].name_;
+                   s.as<VarDefNode>()->name_ == f_->params_[i].name_;
         });
         if (possibleNode.size() > 1) {
-            throw DriverError("Name " + f->params_[i].name_ +
+            throw DriverError("Name " + f_->params_[i].name_ +
                               " should be unique in the AST as a paramerter");
         } else if (!possibleNode.empty()) {
             auto &&node = possibleNode.front();
-            name2buffer_[f->params_[i].name_] = node.as<VarDefNode>()->buffer_;
+            name2buffer_[f_->params_[i].name_] = param2buffer_[i] =
+                node.as<VarDefNode>()->buffer_;
         } else {
             // This parameter is not used. Ignore it. NOTE: Since we allow
             // removing a parameter, please be aware of potential bugs that a
@@ -89,19 +186,77 @@ Driver::Driver(const Func &f, const std::string &src, const Ref<Device> &dev,
             // This block is left empty
         }
     }
-    buildAndLoad();
 }
 
-void Driver::buildAndLoad() {
-    std::string home = getenv("HOME");
-    mkdir((home + "/.freetensor").c_str(), 0755);
-    std::string path_string = home + "/.freetensor/XXXXXX";
-    char path[64];
-    ASSERT(path_string.size() < 64);
-    strncpy(path, path_string.c_str(), 63);
-    auto mkdtempPtr = mkdtemp(path);
-    ASSERT(mkdtempPtr != nullptr);
+/**
+ * Get a directory containing a precompiled `cpu_runtime.h`, which is built on
+ * first use and kept in the kernel cache
+ *
+ * Passing `-I<dir>` before other include paths to GCC makes it use the
+ * precompiled header. GCC silently falls back to the normal header if the
+ * precompiled one is missing (e.g. evicted) or incompatible
+ *
+ * @param executable : Path to the backend compiler
+ * @param flags : Flags used to compile the kernel, not including input files,
+ * output files or linking flags
+ * @return : The directory, or an empty string if unavailable
+ */
+static std::string
+precompiledRuntimeHeader(const std::string &executable,
+                         const std::vector<std::string> &flags, bool verbose) {
+    if (!Config::precompiledHeader() || Config::kernelCacheDir().empty()) {
+        return "";
+    }
+    if (std::filesystem::path(executable).filename().string().find("clang") !=
+        std::string::npos) {
+        return ""; // Clang does not look up `.gch` files implicitly
+    }
+    std::filesystem::path header;
+    for (auto &&dir : Config::runtimeDir()) {
+        if (std::filesystem::exists(dir / "cpu_runtime.h")) {
+            header = dir / "cpu_runtime.h";
+            break;
+        }
+    }
+    if (header.empty()) {
+        return "";
+    }
+
+    auto key = KernelCache::makeKey("precompiled header: cpu_runtime.h",
+                                    executable, flags);
 
+    // Build only once even if requested by multiple compiling workers
+    static std::mutex lock;
+    static std::unordered_set<std::string> failed;
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto dir = KernelCache::lookupDir(key); !dir.empty()) {
+        return dir;
+    }
+    if (failed.count(key)) {
+        return "";
+    }
+    auto tmp = KernelCache::makeTempDir();
+    if (tmp.empty()) {
+        failed.insert(key);
+        return "";
+    }
+    auto args = flags;
+    args.insert(args.end(), {"-x", "c++-header", header.string(), "-o",
+                             tmp + "/cpu_runtime.h.gch"});
+    try {
+        runBackendCompiler(executable.c_str(), args, verbose);
+    } catch (const DriverError &) {
+        WARNING("Unable to build a precompiled header. Compiling without it");
+        failed.insert(key);
+        std::error_code ec;
+        std::filesystem::remove_all(tmp, ec);
+        return "";
+    }
+    KernelCache::insertDir(key, tmp);
+    return KernelCache::lookupDir(key);
+}
+
+void Driver::build() {
     std::string srcSuffix;
     switch (dev_->type()) {
     case TargetType::CPU:
@@ -114,56 +269,63 @@ void Driver::buildAndLoad() {
         ASSERT(false);
     }
 
-    auto cpp = (std::string)path + "/run" + srcSuffix;
-    auto so = (std::string)path + "/run.so";
-    {
-        std::ofstream f(cpp);
-        f << src_;
-    }
-    const char *executable;
+    // Paths to temporary files are relative to the temporary directory, which
+    // is created only when the job runs. Relative paths also make the key of
+    // the job independent of the directory
+    std::string cpp = "run" + srcSuffix;
+    std::string so = "run.so";
+    std::string executable;
     std::vector<std::string> args;
+    std::vector<std::string> pchFlags; /// Flags to build a precompiled header
     auto addArgs = [&](auto... s) {
         args.insert(args.end(), {std::string(s)...});
     };
+    auto addFlags = [&](auto... s) {
+        addArgs(s...);
+        pchFlags.insert(pchFlags.end(), {std::string(s)...});
+    };
     // We enable fast-math because our own transformations do not preserve
     // strict floating point rounding order either
     switch (dev_->type()) {
     case TargetType::CPU:
         ASSERT(!Config::backendCompilerCXX().empty());
-        executable = Config::backendCompilerCXX().front().c_str();
+        executable = Config::backendCompilerCXX().front();
         for (auto &&path : Config::runtimeDir()) {
             // For path arguments, we do not quote it again since the arguments
             // are passed directly to the compiler (with execv) without going
             // through the shell. Spaces are preserved and the argument will not
             // be split into multiple arguments.
-            addArgs("-I" + (std::string)path);
+            addFlags("-I" + (std::string)path);
         }
-        addArgs("-std=c++20", "-shared", "-O3", "-fPIC", "-Wall", "-fopenmp",
-                "-ffast-math");
-        addArgs("-o", so, cpp);
+        addFlags("-std=c++20", "-O3", "-fPIC", "-Wall", "-fopenmp",
+                 "-ffast-math");
+        addArgs("-shared", "-o", so, cpp);
 #ifdef FT_WITH_MKL
-        addArgs("-I" FT_WITH_MKL "/include", "-Wl,--start-group",
+        addFlags("-I" FT_WITH_MKL "/include", "-DFT_WITH_MKL=" FT_WITH_MKL);
+        addArgs("-Wl,--start-group",
                 FT_WITH_MKL "/lib/intel64/libmkl_intel_lp64.a",
                 FT_WITH_MKL "/lib/intel64/libmkl_gnu_thread.a",
-                FT_WITH_MKL "/lib/intel64/libmkl_core.a", "-Wl,--end-group",
-                "-DFT_WITH_MKL=" FT_WITH_MKL);
+                FT_WITH_MKL "/lib/intel64/libmkl_core.a", "-Wl,--end-group");
         // Link statically, or there will be dlopen issues
         // Generated with MKL Link Line Advisor
 #endif // FT_WITH_MKL
         if (dev_->target()->useNativeArch()) {
-            addArgs("-march=native");
+            addFlags("-march=native");
         }
         if (Config::debugRuntimeCheck()) {
-            addArgs("-ftrapv");
+            addFlags("-ftrapv");
         }
         if (Config::debugBinary()) {
-            addArgs("-g");
+            addFlags("-g");
         }
         break;
 #ifdef FT_WITH_CUDA
     case TargetType::GPU: {
+        // No precompiled header for NVCC. It preprocesses the whole translation
+        // unit before passing it to the host compiler, so a host precompiled
+        // header never applies
         ASSERT(!Config::backendCompilerNVCC().empty());
-        executable = Config::backendCompilerNVCC().front().c_str();
+        executable = Config::backendCompilerNVCC().front();
         for (auto &&path : Config::runtimeDir()) {
             addArgs("-I" + (std::string)path);
         }
@@ -188,77 +350,106 @@ void Driver::buildAndLoad() {
         ASSERT(false);
     }
 
-    if (Config::debugBinary() || verbose_) {
-        std::stringstream cmdStream;
-        cmdStream << "\"" << executable << "\" ";
-        for (auto &s : args) {
-            cmdStream << "\"" << s << "\" ";
-        }
-        auto cmd = cmdStream.str();
-
-        if (Config::debugBinary()) {
-            WARNING("debug-binary mode on. Compiling with " + cmd);
-        }
-        if (verbose_) {
-            logger() << "Running " << cmd << std::endl;
-        }
-    }
+    // Skip the kernel cache in debug-binary mode, where we want to keep
+    // everything produced by the backend compiler
+    bool useCache = !Config::debugBinary() && !Config::kernelCacheDir().empty();
+    auto key = KernelCache::makeKey(src_, executable, args);
+    compiled_ = CompileService::global().submit(
+        key, [key, executable, args, pchFlags, cpp, so, useCache, src = src_,
+              verbose = verbose_]() {
+            auto dir = makeTempDir();
+            auto fullArgs = args;
+            for (auto &arg : fullArgs) {
+                if (arg == so || arg == cpp) {
+                    arg = dir + "/" + arg;
+                }
+            }
 
-    // fork + execv to execute the compiler
-    {
-        // construct the argv array
-        std::vector<const char *> argv;
-        argv.push_back(executable);
-        for (auto &s : args) {
-            argv.push_back(s.c_str());
-        }
-        argv.push_back(nullptr);
+            if (useCache && KernelCache::lookup(key, dir + "/" + so)) {
+                if (verbose) {
+                    logger() << "Loaded the compiled kernel from cache"
+                             << std::endl;
+                }
+                return Ref<CompiledObject>::make(dir, dir + "/" + so);
+            }
 
-        int pid = vfork();
-        if (pid == 0) {
-            execv(executable, const_cast<char *const *>(argv.data()));
-            std::cerr << "Failed to execute " << executable << ": "
-                      << strerror(errno);
-            exit(-1);
-        } else {
-            int status;
-            waitpid(pid, &status, 0);
-            if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
-                // Interrupted (Ctrl+C). Interrupt FreeTensor as well
-                // Do not directly raise SIGINT. See the doc of InterruptExcept
-                throw InterruptExcept();
+            {
+                std::ofstream f(dir + "/" + cpp);
+                f << src;
             }
-            if (status != 0)
-                throw DriverError("Backend compiler reports error");
-        }
+            if (!pchFlags.empty()) {
+                // Not included in the key, because it makes no difference to
+                // the compiled program
+                auto pchDir =
+                    precompiledRuntimeHeader(executable, pchFlags, verbose);
+                if (!pchDir.empty()) {
+                    fullArgs.insert(fullArgs.begin(), "-I" + pchDir);
+                }
+            }
+            runBackendCompiler(executable.c_str(), fullArgs, verbose);
+            if (useCache) {
+                KernelCache::insert(key, dir + "/" + so);
+            }
+            if (Config::debugBinary()) {
+                WARNING((std::string) "debug-binary mode on. The produced "
+                                      "files are saved in " +
+                        dir);
+            }
+            return Ref<CompiledObject>::make(dir, dir + "/" + so);
+        });
+}
+
+void Driver::load() {
+    if (!compiled_.valid()) {
+        throw DriverError("The program has been unloaded");
+    }
+    auto compiled = compiled_.get(); // Rethrow errors in compiling
+    compiled_ = {};
+    binary_ = compiled;
+
+    // `dlopen` returns the same handle when loading the same file twice, but
+    // each `Driver` should have its own copy of the static data in the kernel
+    // (e.g. the stacks). A compiled object may be shared by multiple `Driver`s
+    // due to deduplication, so we load from a private copy of it
+    static std::atomic<size_t> copyCnt = 0;
+    auto so = compiled->dir() + "/run." + std::to_string(copyCnt++) + ".so";
+    std::error_code ec;
+    std::filesystem::copy_file(compiled->so(), so, ec);
+    if (ec) {
+        throw DriverError("Unable to copy target code: " + ec.message());
     }
 
-    dlHandle_ = dlopen(so.c_str(), RTLD_NOW);
-    if (!dlHandle_) {
+    auto handle = dlopen(so.c_str(), RTLD_NOW);
+    if (!handle) {
         throw DriverError((std::string) "Unable to load target code: " +
                           dlerror());
     }
+    dlHandle_ = std::shared_ptr<void>(handle, [](void *handle) {
+        auto err = dlclose(handle);
+        if (err) {
+            WARNING("Unable to unload target code");
+        }
+    });
 
+    if (!Config::debugBinary()) {
+        remove(so.c_str());
+    }
+
+    loadEntry();
+}
+
+void Driver::loadEntry() {
     func_ = (void (*)(void **, void **, size_t **, size_t *, void *))dlsym(
-        dlHandle_, "run");
+        dlHandle_.get(), entry_.c_str());
     if (!func_) {
         throw DriverError((std::string) "Target function not found: " +
                           dlerror());
     }
 
-    if (!Config::debugBinary()) {
-        remove(cpp.c_str());
-        remove(so.c_str());
-        rmdir(path);
-    } else {
-        WARNING((std::string) "debug-binary mode on. The produced files are "
-                              "saved in " +
-                path);
-    }
-
     switch (dev_->type()) {
     case TargetType::CPU:
-        ctx_ = std::make_unique<CPUContext>();
+        ctx_ = std::make_unique<CPUContext>(cpuThreadPool, numThreads_,
+                                            ArrayAllocator::allocCPU);
         break;
 #ifdef FT_WITH_CUDA
     case TargetType::GPU:
@@ -270,6 +461,40 @@ void Driver::buildAndLoad() {
     }
 }
 
+ThreadPool *cpuThreadPool() {
+    // One thread per hardware thread, including the calling one
+    static ThreadPool pool(
+        std::max(0, Ref<CPUTarget>::make()->hardwareThreads() - 1));
+    return &pool;
+}
+
+void Driver::setNumThreads(int numThreads) {
+    numThreads_ = numThreads;
+    if (auto ctx = dynamic_cast<CPUContext *>(ctx_.get()); ctx != nullptr) {
+        ctx->setNumThreads(numThreads);
+    }
+}
+
+const Ref<CompiledObject> &Driver::binary() {
+    wait();
+    if (!binary_.isValid()) {
+        throw DriverError("The program has been unloaded");
+    }
+    return binary_;
+}
+
+bool Driver::isReady() const {
+    return func_ != nullptr ||
+           (compiled_.valid() && compiled_.wait_for(std::chrono::seconds(0)) ==
+                                     std::future_status::ready);
+}
+
+void Driver::wait() {
+    if (func_ == nullptr) {
+        load();
+    }
+}
+
 void Driver::setArgs(const std::vector<Ref<Array>> &args,
                      const std::unordered_map<std::string, Ref<Array>> &kws) {
     for (size_t i = 0, iEnd = args.size(), j = 0; i < iEnd; i++) {
@@ -348,7 +573,66 @@ void Driver::setArgs(const std::vector<Ref<Array>> &args,
     }
 }
 
+void Driver::checkArg(size_t paramId, const Ref<Array> &arg) const {
+    auto &&name = f_->params_[paramId].name_;
+    auto &&tensor = param2buffer_[paramId]->tensor();
+    if (tensor->dtype() != arg->dtype()) {
+        throw DriverError("Cannnot pass a " + toString(arg->dtype()) +
+                          " Array to the " + std::to_string(paramId) +
+                          "-th parameter " + name + " of type " +
+                          toString(tensor->dtype()));
+    }
+    auto &&shape = tensor->shape();
+    bool mismatch = shape.size() != arg->shape().size();
+    for (size_t i = 0, n = shape.size(); !mismatch && i < n; i++) {
+        if (shape[i]->nodeType() == ASTNodeType::IntConst &&
+            shape[i].as<IntConstNode>()->val_ != (int64_t)arg->shape()[i]) {
+            mismatch = true;
+        }
+    }
+    if (mismatch) {
+        std::ostringstream os;
+        os << "Cannot pass an Array of shape [" << arg->shape() << "] to the "
+           << paramId << "-th parameter " << name << " of shape ["
+           << tensor->shape() << "]";
+        throw DriverError(os.str());
+    }
+}
+
+size_t Driver::paramIndex(const std::string &name) const {
+    if (auto it = name2param_.find(name); it != name2param_.end()) {
+        return it->second;
+    }
+    throw DriverError("There is no parameter named " + name);
+}
+
+void Driver::setArg(size_t paramId, const Ref<Array> &arg) {
+    if (paramId >= f_->params_.size()) {
+        throw DriverError("There is no " + std::to_string(paramId) +
+                          "-th parameter");
+    }
+    auto &&param = f_->params_[paramId];
+    if (param.isInClosure() && !param.updateClosure_) {
+        throw DriverError("Enclosed parameter " + param.name_ +
+                          " cannot be set");
+    }
+    if (auto &&buffer = param2buffer_[paramId]; buffer.isValid()) {
+        if (args_[paramId] != arg) {
+            checkArg(paramId, arg);
+            args_[paramId] = arg;
+        }
+        // Always request again, because the Array may have been moved to
+        // another device since last time
+        rawArgs[paramId] = requestPtr(arg, dev_, hostDev_, buffer->mtype(),
+                                      buffer->atype());
+    }
+    if (param.isInClosure()) {
+        *param.closure_ = arg;
+    }
+}
+
 void Driver::run() {
+    wait();
 #ifdef FT_WITH_CUDA
     if (dev_->type() == TargetType::GPU) {
         checkCudaError(cudaSetDevice(dev_->num()));
@@ -360,7 +644,7 @@ void Driver::run() {
 
 void Driver::sync() { dev_->sync(); }
 
-std::vector<Ref<Array>> Driver::collectReturns() {
+std::vector<Ref<Array>> Driver::collectReturns(bool keepArgs) {
     std::vector<Ref<Array>> ret;
     for (size_t i = 0, n = f_->returns_.size(); i < n; i++) {
         auto &&[name, dtype, closure, returnClosure] = f_->returns_[i];
@@ -390,81 +674,171 @@ std::vector<Ref<Array>> Driver::collectReturns() {
         }
     }
 
-    // Free reference count holders
-    std::fill(args_.begin(), args_.end(), nullptr);
-    std::fill(rawArgs.begin(), rawArgs.end(), nullptr);
+    if (!keepArgs) {
+        // Free reference count holders
+        std::fill(args_.begin(), args_.end(), nullptr);
+        std::fill(rawArgs.begin(), rawArgs.end(), nullptr);
+    }
 
     return ret;
 }
 
-std::pair<double, double> Driver::time(int rounds, int warmups) {
-    namespace ch = std::chrono;
+namespace {
 
-    std::vector<double> times(rounds);
+/**
+ * Pin the calling thread to a CPU core in a RAII style, and restore the
+ * original affinity at last
+ */
+class PinCPU {
+    cpu_set_t old_;
+    bool pinned_ = false;
 
-    auto tgtType = dev_->type();
-    for (int i = 0; i < warmups; i++) {
-        run();
-        switch (tgtType) {
-#ifdef FT_WITH_CUDA
-        case TargetType::GPU:
-            checkCudaError(cudaDeviceSynchronize());
-#endif // FT_WITH_CUDA
-        default:;
+  public:
+    PinCPU(int cpu) {
+        if (cpu < 0) {
+            return;
+        }
+        if (sched_getaffinity(0, sizeof(old_), &old_) != 0) {
+            WARNING("Unable to get the CPU affinity. Not pinning");
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            WARNING("Unable to pin to CPU " + std::to_string(cpu));
+            return;
         }
+        pinned_ = true;
     }
-    for (int i = 0; i < rounds; i++) {
-#ifdef FT_WITH_CUDA
-        auto cudaErr = cudaSuccess;
-#endif // FT_WITH_CUDA
-
-        auto beg = ch::high_resolution_clock::now();
-        run();
-        switch (tgtType) {
-#ifdef FT_WITH_CUDA
-        case TargetType::GPU:
-            cudaErr = cudaDeviceSynchronize();
-#endif // FT_WITH_CUDA
-        default:;
+    ~PinCPU() {
+        if (pinned_) {
+            sched_setaffinity(0, sizeof(old_), &old_);
         }
-        auto end = ch::high_resolution_clock::now();
-        double dur =
-            ch::duration_cast<ch::duration<double>>(end - beg).count() *
-            1000; // ms
+    }
+
+    PinCPU(const PinCPU &) = delete;
+    PinCPU &operator=(const PinCPU &) = delete;
+};
+
+} // Anonymous namespace
+
+/**
+ * Size of a buffer to flush the CPU caches. When the last level cache is not
+ * detected, a buffer larger than typical L3 caches is used, so benchmarks do
+ * not silently read warm caches
+ */
+static size_t cpuFlushBytes(const CPUTarget &host) {
+    if (host.l3CacheSize() == 0) {
+        return std::max<size_t>(32 << 20, 2 * host.l2CacheSize());
+    }
+    return 2 * std::max(host.l3CacheSize(), host.l2CacheSize());
+}
+
+/**
+ * Evict the data of a program from the caches, by touching a buffer larger
+ * than the caches
+ */
+static void flushCache(const Ref<Device> &dev) {
+    static CPUTarget host;
+    static std::vector<uint8_t> cpuBuf(cpuFlushBytes(host));
+    volatile uint8_t *ptr = cpuBuf.data();
+    for (size_t i = 0, n = cpuBuf.size(); i < n; i += host.cacheLineSize()) {
+        ptr[i]++;
+    }
 
 #ifdef FT_WITH_CUDA
-        if (cudaErr) {
-            throw DriverError(cudaGetErrorString(cudaErr));
+    if (dev->type() == TargetType::GPU) {
+        static std::mutex lock;
+        static std::unordered_map<int, std::pair<void *, size_t>> gpuBufs;
+        std::lock_guard<std::mutex> guard(lock);
+        auto &&[buf, size] = gpuBufs[dev->num()];
+        if (buf == nullptr) {
+            size = 2 * dev->target().as<GPUTarget>()->infoArch()->l2CacheSize;
+            checkCudaError(cudaMalloc(&buf, size));
         }
+        checkCudaError(cudaMemset(buf, 0, size));
+        checkCudaError(cudaDeviceSynchronize());
+    }
 #endif // FT_WITH_CUDA
+}
 
-        times[i] = dur;
-    }
+std::pair<double, double> Driver::time(int rounds, int warmups) {
+    BenchmarkOptions options;
+    options.warmups = warmups;
+    options.minRounds = options.maxRounds = rounds;
+    options.targetRelCI = 0;
+    options.rejectOutliers = false;
+    auto result = benchmark(options);
+    return std::make_pair(result.avg, result.stddev);
+}
+
+BenchmarkResult Driver::benchmark(const BenchmarkOptions &options) {
+    namespace ch = std::chrono;
+
+    wait();
+    PinCPU pin(options.pinCPU);
+
+    auto runOnce = [&]() {
+        if (options.flushCache) {
+            flushCache(dev_);
+        }
+        auto beg = ch::steady_clock::now();
+        run();
+        sync();
+        auto end = ch::steady_clock::now();
+        return ch::duration_cast<ch::duration<double>>(end - beg).count() *
+               1000; // ms
+    };
 
-    double avg = 0, varAvgX = 0;
-    for (auto t : times) {
-        avg += t;
+    // The first round may include lazy initialization, so it is not used in
+    // the judgement of aborting
+    double fastest = INFINITY;
+    for (int i = 0; i < options.warmups; i++) {
+        auto t = runOnce();
+        if (i > 0) {
+            fastest = std::min(fastest, t);
+        }
     }
-    avg /= rounds;
-    if (rounds > 1) {
-        double varX = 0;
-        for (auto t : times) {
-            varX += (t - avg) * (t - avg);
+
+    std::vector<double> samples;
+    samples.reserve(options.maxRounds);
+    double total = 0;
+    bool aborted = false;
+    while ((int)samples.size() < options.maxRounds) {
+        auto t = runOnce();
+        samples.emplace_back(t);
+        total += t;
+        fastest = std::min(fastest, t);
+
+        if (fastest > options.abortThreshold &&
+            (samples.size() >= 2 || options.warmups >= 2)) {
+            aborted = true;
+            break;
+        }
+        if ((int)samples.size() < options.minRounds) {
+            continue;
+        }
+        if (options.timeBudget > 0 && total >= options.timeBudget) {
+            break;
+        }
+        if (options.targetRelCI > 0) {
+            auto result = summarizeSamples(samples, options.rejectOutliers);
+            if (1.96 * result.stddev <= options.targetRelCI * result.avg) {
+                break;
+            }
         }
-        varX /= (rounds - 1);    // Var[X] = n/(n-1) sigma^2
-        varAvgX = varX / rounds; // Var[(X1 + X2 + ... + Xn) / n] = 1/n Var[X]
     }
-    return std::make_pair(avg, sqrt(varAvgX));
+
+    auto ret = summarizeSamples(std::move(samples), options.rejectOutliers);
+    ret.aborted = aborted;
+    return ret;
 }
 
 void Driver::unload() {
     func_ = nullptr;
-    if (dlHandle_) {
-        auto err = dlclose(dlHandle_);
-        if (err) {
-            WARNING("Unable to unload target code");
-        }
-    }
+    dlHandle_ = nullptr; // dlclose when not shared by other Drivers
+    binary_ = nullptr;
 }
 
 } // namespace freetensor
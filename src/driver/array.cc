@@ -3,6 +3,7 @@
 
 #include <config.h>
 #include <debug.h>
+#include <driver/array_allocator.h>
 #include <driver/array.h>
 #include <except.h>
 #ifdef FT_WITH_CUDA
@@ -31,7 +32,7 @@ static uint8_t *allocOn(size_t size, const Ref<Device> &device) {
     uint8_t *ptr = nullptr;
     switch (device->type()) {
     case TargetType::CPU:
-        ptr = new uint8_t[size];
+        ptr = ArrayAllocator::allocCPU(size);
         break;
 
 #ifdef FT_WITH_CUDA
@@ -80,7 +81,7 @@ static void freeFrom(uint8_t *&ptr, const Ref<Device> &device) {
     if (ptr != nullptr) {
         switch (device->type()) {
         case TargetType::CPU:
-            delete[] ptr;
+            ArrayAllocator::freeCPU(ptr);
             ptr = nullptr;
             break;
 #ifdef FT_WITH_CUDA
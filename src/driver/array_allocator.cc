@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <config.h>
+#include <driver/array_allocator.h>
+
+namespace freetensor {
+
+namespace {
+
+constexpr size_t MIN_SIZE_CLASS = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2ull << 20; // 2 MiB, for x86-64 and ARM64
+
+// From <linux/mempolicy.h>, which is not always installed
+constexpr int MPOL_PREFERRED_ = 1;
+constexpr unsigned MPOL_MF_MOVE_ = 1 << 1;
+
+size_t pageSize() {
+    static size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+int currentNUMANode() {
+#ifdef SYS_getcpu
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return node;
+    }
+#endif // SYS_getcpu
+    return 0;
+}
+
+struct CPUArrayAllocators {
+    std::mutex lock_;
+    Ref<ArrayAllocator> current_ = Ref<CPUMemoryPool>::make();
+    std::vector<Ref<ArrayAllocator>> retired_;
+};
+
+CPUArrayAllocators &cpuAllocators() {
+    // Never destructed, because `Array`s in Python may be freed after any
+    // static object in the library
+    static auto *allocators = new CPUArrayAllocators();
+    return *allocators;
+}
+
+} // namespace
+
+Ref<ArrayAllocator> ArrayAllocator::cpu() {
+    auto &&allocators = cpuAllocators();
+    std::lock_guard<std::mutex> guard(allocators.lock_);
+    return allocators.current_;
+}
+
+void ArrayAllocator::setCPU(const Ref<ArrayAllocator> &allocator) {
+    auto &&allocators = cpuAllocators();
+    std::lock_guard<std::mutex> guard(allocators.lock_);
+    allocators.current_->releaseCache();
+    allocators.retired_.emplace_back(allocators.current_);
+    allocators.current_ = allocator;
+}
+
+uint8_t *ArrayAllocator::allocCPU(size_t size) {
+    return cpu()->alloc(size);
+}
+
+void ArrayAllocator::freeCPU(uint8_t *ptr) {
+    auto &&allocators = cpuAllocators();
+    std::lock_guard<std::mutex> guard(allocators.lock_);
+    if (allocators.current_->free(ptr)) {
+        return;
+    }
+    for (auto &&allocator : allocators.retired_) {
+        if (allocator->free(ptr)) {
+            return;
+        }
+    }
+    delete[] ptr;
+}
+
+CPUMemoryPool::~CPUMemoryPool() { releaseCache(); }
+
+size_t CPUMemoryPool::sizeClass(size_t size) {
+    if (size <= MIN_SIZE_CLASS) {
+        return MIN_SIZE_CLASS;
+    }
+    // 4 classes in (2^k, 2^(k+1)]: rounded up to a multiple of 2^(k-2)
+    size_t k = 63 - __builtin_clzll(size - 1);
+    size_t step = 1ull << (k - 2);
+    return (size + step - 1) / step * step;
+}
+
+uint8_t *CPUMemoryPool::sysAlloc(size_t size, int node) {
+    size_t align = Config::arrayAlignment();
+    if (size >= pageSize()) {
+        align = std::max(align, pageSize());
+    }
+    bool huge = Config::arrayHugePage() && size >= HUGE_PAGE_SIZE;
+    if (huge) {
+        align = std::max(align, HUGE_PAGE_SIZE);
+    }
+
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, align, size) != 0) {
+        throw std::bad_alloc();
+    }
+
+    // Both advices are best-effort: they fail silently on kernels without THP
+    // or NUMA support
+#ifdef MADV_HUGEPAGE
+    if (huge) {
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif // MADV_HUGEPAGE
+#ifdef SYS_mbind
+    if (node >= 0 && size >= pageSize()) {
+        constexpr size_t BITS = sizeof(unsigned long) * 8;
+        std::vector<unsigned long> mask(node / BITS + 1, 0);
+        mask[node / BITS] = 1ul << (node % BITS);
+        syscall(SYS_mbind, ptr, size, MPOL_PREFERRED_, mask.data(),
+                mask.size() * BITS + 1, MPOL_MF_MOVE_);
+    }
+#endif // SYS_mbind
+    return (uint8_t *)ptr;
+}
+
+void CPUMemoryPool::sysFree(uint8_t *ptr) { ::free(ptr); }
+
+uint8_t *CPUMemoryPool::alloc(size_t size) {
+    size_t cls = sizeClass(size);
+    bool numaLocal = Config::arrayNUMALocal();
+    int node = numaLocal ? currentNUMANode() : 0;
+
+    uint8_t *ptr = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (auto it = cached_.find(node); it != cached_.end()) {
+            if (auto jt = it->second.find(cls);
+                jt != it->second.end() && !jt->second.empty()) {
+                ptr = jt->second.back();
+                jt->second.pop_back();
+                stats_.bytesCached_ -= cls;
+            }
+        }
+    }
+    bool hit = ptr != nullptr;
+    if (!hit) {
+        ptr = sysAlloc(cls, numaLocal ? node : -1);
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    live_.emplace(ptr, Block{cls, node});
+    stats_.nAlloc_++;
+    (hit ? stats_.nHit_ : stats_.nMiss_)++;
+    stats_.bytesInUse_ += cls;
+    stats_.peakBytesInUse_ =
+        std::max(stats_.peakBytesInUse_, stats_.bytesInUse_);
+    return ptr;
+}
+
+bool CPUMemoryPool::free(uint8_t *ptr) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = live_.find(ptr);
+        if (it == live_.end()) {
+            return false;
+        }
+        auto [cls, node] = it->second;
+        live_.erase(it);
+        stats_.nFree_++;
+        stats_.bytesInUse_ -= cls;
+        if (stats_.bytesCached_ + cls <= Config::arrayPoolSize()) {
+            cached_[node][cls].emplace_back(ptr);
+            stats_.bytesCached_ += cls;
+            return true;
+        }
+    }
+    sysFree(ptr);
+    return true;
+}
+
+void CPUMemoryPool::releaseCache() {
+    decltype(cached_) cached;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        std::swap(cached, cached_);
+        stats_.bytesCached_ = 0;
+    }
+    for (auto &&[node, classes] : cached) {
+        for (auto &&[cls, ptrs] : classes) {
+            for (auto ptr : ptrs) {
+                sysFree(ptr);
+            }
+        }
+    }
+}
+
+ArrayAllocatorStats CPUMemoryPool::stats() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
+
+} // namespace freetensor
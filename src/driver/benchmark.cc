@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cmath>
+
+#include <driver/benchmark.h>
+
+namespace freetensor {
+
+double BenchmarkResult::percentile(double p) const {
+    if (samples.empty()) {
+        return INFINITY;
+    }
+    double pos = std::clamp(p, 0., 100.) / 100 * (samples.size() - 1);
+    size_t lo = std::floor(pos), hi = std::ceil(pos);
+    return samples[lo] + (samples[hi] - samples[lo]) * (pos - lo);
+}
+
+BenchmarkResult summarizeSamples(std::vector<double> samples,
+                                 bool rejectOutliers) {
+    BenchmarkResult ret;
+    std::sort(samples.begin(), samples.end());
+    ret.samples = std::move(samples);
+    if (ret.samples.empty()) {
+        return ret;
+    }
+
+    // Tukey's fences. Too few samples to tell outliers with less than 4
+    double lo = -INFINITY, hi = INFINITY;
+    if (rejectOutliers && ret.samples.size() >= 4) {
+        double q1 = ret.percentile(25), q3 = ret.percentile(75);
+        lo = q1 - 1.5 * (q3 - q1);
+        hi = q3 + 1.5 * (q3 - q1);
+    }
+
+    double sum = 0;
+    int n = 0;
+    for (double t : ret.samples) {
+        if (t >= lo && t <= hi) {
+            sum += t;
+            n++;
+        }
+    }
+    ret.nOutliers = ret.samples.size() - n;
+    ret.avg = sum / n;
+    if (n > 1) {
+        double varX = 0;
+        for (double t : ret.samples) {
+            if (t >= lo && t <= hi) {
+                varX += (t - ret.avg) * (t - ret.avg);
+            }
+        }
+        varX /= (n - 1); // Var[X] = n/(n-1) sigma^2
+        // Var[(X1 + X2 + ... + Xn) / n] = 1/n Var[X]
+        ret.stddev = std::sqrt(varX / n);
+    }
+    return ret;
+}
+
+} // namespace freetensor
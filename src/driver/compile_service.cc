@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdlib> // mkdtemp
+#include <cstring> // strncpy
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h> // mkdir
+
+#include <config.h>
+#include <driver/compile_service.h>
+#include <except.h>
+
+namespace freetensor {
+
+CompiledObject::~CompiledObject() {
+    if (!Config::debugBinary()) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+}
+
+std::string CompiledObject::bytes() const {
+    std::ifstream f(so_, std::ios::binary);
+    if (!f.is_open()) {
+        throw DriverError("Unable to read target code from " + so_);
+    }
+    std::ostringstream os;
+    os << f.rdbuf();
+    return os.str();
+}
+
+Ref<CompiledObject> CompiledObject::fromBytes(const std::string &bytes) {
+    auto dir = makeTempDir();
+    auto so = dir + "/run.so";
+    std::ofstream f(so, std::ios::binary);
+    f.write(bytes.data(), bytes.size());
+    if (!f.good()) {
+        throw DriverError("Unable to write target code to " + so);
+    }
+    return Ref<CompiledObject>::make(dir, so);
+}
+
+std::string makeTempDir() {
+    std::string home = getenv("HOME");
+    mkdir((home + "/.freetensor").c_str(), 0755);
+    std::string path_string = home + "/.freetensor/XXXXXX";
+    char path[64];
+    ASSERT(path_string.size() < 64);
+    strncpy(path, path_string.c_str(), 63);
+    auto mkdtempPtr = mkdtemp(path);
+    ASSERT(mkdtempPtr != nullptr);
+    return path;
+}
+
+CompileService::CompileService(size_t nWorkers, size_t maxQueueSize) {
+    if (nWorkers == 0) {
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    maxQueueSize_ = maxQueueSize == 0 ? 4 * nWorkers : maxQueueSize;
+    workers_.reserve(nWorkers);
+    for (size_t i = 0; i < nWorkers; i++) {
+        workers_.emplace_back([this]() { work(); });
+    }
+}
+
+CompileService::~CompileService() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopped_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+    for (auto &&worker : workers_) {
+        worker.join();
+    }
+}
+
+void CompileService::work() {
+    while (true) {
+        std::pair<std::string, Task> item;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            notEmpty_.wait(guard,
+                           [this]() { return stopped_ || !queue_.empty(); });
+            if (queue_.empty()) { // Stopped
+                return;
+            }
+            item = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        notFull_.notify_one();
+
+        auto &&[key, task] = item;
+        task(); // Exceptions are stored in the future
+
+        std::lock_guard<std::mutex> guard(lock_);
+        inFlight_.erase(key);
+    }
+}
+
+CompileService::Future
+CompileService::submit(const std::string &key,
+                       const std::function<Ref<CompiledObject>()> &job) {
+    std::unique_lock<std::mutex> guard(lock_);
+    if (auto it = inFlight_.find(key); it != inFlight_.end()) {
+        return it->second;
+    }
+    notFull_.wait(guard, [this]() {
+        return stopped_ || queue_.size() < maxQueueSize_;
+    });
+    if (stopped_) {
+        ERROR("The compile service has been stopped");
+    }
+    // Check again, because we may have released the lock while waiting
+    if (auto it = inFlight_.find(key); it != inFlight_.end()) {
+        return it->second;
+    }
+    Task task(job);
+    Future future = task.get_future().share();
+    queue_.emplace_back(key, std::move(task));
+    inFlight_.emplace(key, future);
+    guard.unlock();
+    notEmpty_.notify_one();
+    return future;
+}
+
+CompileService &CompileService::global() {
+    static CompileService service(Config::compileWorkers());
+    return service;
+}
+
+} // namespace freetensor
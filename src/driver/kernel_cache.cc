@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>  // rename
+#include <cstdlib> // mkdtemp
+#include <fcntl.h> // open
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <spawn.h>    // posix_spawn
+#include <sstream>
+#include <sys/file.h> // flock
+#include <sys/wait.h> // waitpid
+#include <unistd.h>   // close, pipe
+#include <unordered_map>
+
+#include <config.h>
+#include <driver/kernel_cache.h>
+#include <except.h>
+#include <hash_combine.h>
+
+extern char **environ;
+
+namespace freetensor {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * Hold a `flock` on the cache directory in a RAII style. The lock is released
+ * when the file descriptor is closed
+ */
+class CacheLock {
+    int fd_;
+
+  public:
+    CacheLock(const fs::path &dir, bool exclusive) {
+        fd_ = open((dir / ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ >= 0) {
+            flock(fd_, exclusive ? LOCK_EX : LOCK_SH);
+        }
+    }
+    ~CacheLock() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    CacheLock(const CacheLock &) = delete;
+    CacheLock &operator=(const CacheLock &) = delete;
+};
+
+/**
+ * Running total size of the entries, kept in a file in the cache directory, so
+ * publishing an entry need not scan the whole cache. The file is locked on its
+ * own, not blocking lookups. It may drift when processes race with a scan, and
+ * is rewritten by each full scan in `evict`
+ */
+class CacheSize {
+    int fd_;
+
+  public:
+    CacheSize(const fs::path &dir) {
+        fd_ = open((dir / ".size").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ >= 0) {
+            flock(fd_, LOCK_EX);
+        }
+    }
+    ~CacheSize() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    CacheSize(const CacheSize &) = delete;
+    CacheSize &operator=(const CacheSize &) = delete;
+
+    /**
+     * Get the total size, or nullopt if not recorded yet
+     */
+    std::optional<size_t> get() const {
+        char buf[32];
+        ssize_t n = fd_ >= 0 ? pread(fd_, buf, sizeof(buf) - 1, 0) : -1;
+        if (n <= 0) {
+            return std::nullopt;
+        }
+        buf[n] = '\0';
+        char *end;
+        auto ret = strtoull(buf, &end, 10);
+        if (end == buf) {
+            return std::nullopt;
+        }
+        return ret;
+    }
+
+    void set(size_t size) {
+        if (fd_ >= 0) {
+            auto str = std::to_string(size);
+            if (ftruncate(fd_, 0) != 0 ||
+                pwrite(fd_, str.data(), str.size(), 0) != (ssize_t)str.size()) {
+                ftruncate(fd_, 0); // Rescan next time
+            }
+        }
+    }
+};
+
+} // Anonymous namespace
+
+static std::string toHex(uint64_t h) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+static std::string readFile(const fs::path &path) {
+    std::ifstream f(path, std::ios::binary);
+    std::ostringstream os;
+    os << f.rdbuf();
+    return os.str();
+}
+
+/**
+ * Run a command and return its standard output. Return an empty string on
+ * failure
+ */
+static std::string captureOutput(const std::string &executable,
+                                  const std::vector<std::string> &args) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return "";
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+    std::vector<const char *> argv;
+    argv.push_back(executable.c_str());
+    for (auto &&arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    int err = posix_spawn(&pid, executable.c_str(), &actions, nullptr,
+                          const_cast<char *const *>(argv.data()), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    std::string ret;
+    if (err == 0) {
+        char buf[256];
+        ssize_t n;
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+            ret.append(buf, n);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (status != 0) {
+            ret.clear();
+        }
+    }
+    close(fds[0]);
+    return ret;
+}
+
+/**
+ * Version string of a compiler. Memoized per executable
+ */
+static std::string compilerVersion(const std::string &executable) {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::string> memo;
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto it = memo.find(executable); it != memo.end()) {
+        return it->second;
+    }
+    auto ret = captureOutput(executable, {"--version"});
+    if (ret.empty()) {
+        // Fall back to the identity of the executable file itself
+        std::error_code ec;
+        auto time = fs::last_write_time(executable, ec);
+        ret = std::to_string(fs::file_size(executable, ec)) + "@" +
+              std::to_string(time.time_since_epoch().count());
+    }
+    return memo[executable] = ret;
+}
+
+/**
+ * Hash of what `-march=native` resolves to on this host, so a cache directory
+ * shared by machines of different ISAs does not serve incompatible binaries.
+ * Memoized per executable
+ */
+static std::string nativeArchHash(const std::string &executable) {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::string> memo;
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto it = memo.find(executable); it != memo.end()) {
+        return it->second;
+    }
+    // GCC prints the resolved target options
+    auto resolved =
+        captureOutput(executable, {"-march=native", "-Q", "--help=target"});
+    if (resolved.empty()) {
+        // Other compilers: fall back to the CPU model and features
+        std::ifstream f("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(f, line)) {
+            if (line.starts_with("model name") || line.starts_with("flags") ||
+                line.starts_with("Features") || line.starts_with("CPU part")) {
+                resolved += line + "\n";
+            }
+            if (line.empty() && !resolved.empty()) {
+                break; // The first processor is enough
+            }
+        }
+    }
+    return memo[executable] = toHex(stableHash(resolved));
+}
+
+/**
+ * Hash of the runtime headers. Memoized per set of runtime directories
+ */
+static std::string runtimeHash() {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::string> memo;
+
+    std::string dirs;
+    for (auto &&dir : Config::runtimeDir()) {
+        dirs += dir.string() + ":";
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto it = memo.find(dirs); it != memo.end()) {
+        return it->second;
+    }
+    uint64_t h = stableHash(dirs);
+    for (auto &&dir : Config::runtimeDir()) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto &&entry : fs::recursive_directory_iterator(dir, ec)) {
+            if (entry.is_regular_file(ec)) {
+                files.emplace_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (auto &&file : files) {
+            h = stableHash(fs::relative(file, dir).string(), h);
+            h = stableHash(readFile(file), h);
+        }
+    }
+    return memo[dirs] = toHex(h);
+}
+
+static size_t dirSize(const fs::path &path) {
+    size_t size = 0;
+    std::error_code ec;
+    for (auto &&file : fs::directory_iterator(path, ec)) {
+        size += file.file_size(ec);
+    }
+    return size;
+}
+
+/**
+ * Remove stale temporary directories, and remove the least recently used
+ * entries until the total size fits in the limit. The running total size is
+ * then rewritten from the scan
+ */
+static void evict(const fs::path &dir) {
+    auto limit = Config::kernelCacheSize();
+    CacheLock lock(dir, true);
+
+    // Temporary directories may be filled without holding a lock, so we only
+    // remove those left by crashed processes long ago
+    auto staleTime = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+    std::unordered_map<std::string, size_t> sizes;
+    size_t total = 0;
+    std::error_code ec;
+    for (auto &&entry : fs::directory_iterator(dir, ec)) {
+        if (!entry.is_directory(ec)) {
+            continue;
+        }
+        auto &&path = entry.path();
+        if (path.filename().string().starts_with("tmp.")) {
+            if (fs::last_write_time(path, ec) < staleTime) {
+                fs::remove_all(path, ec);
+            }
+            continue;
+        }
+        size_t size = dirSize(path);
+        entries.emplace_back(fs::last_write_time(path, ec), path);
+        sizes[path.string()] = size;
+        total += size;
+    }
+    if (limit > 0 && total > limit) {
+        std::sort(entries.begin(), entries.end());
+        for (auto &&[time, path] : entries) {
+            if (total <= limit) {
+                break;
+            }
+            fs::remove_all(path, ec);
+            total -= sizes.at(path.string());
+        }
+    }
+    CacheSize(dir).set(total);
+}
+
+std::string KernelCache::makeKey(const std::string &src,
+                                 const std::string &executable,
+                                 const std::vector<std::string> &args) {
+    std::string key;
+    key += "compiler: " + executable + "\n";
+    key += "version: " + compilerVersion(executable) + "\n";
+    key += "runtime: " + runtimeHash() + "\n";
+    for (auto &&arg : args) {
+        key += "arg: " + arg + "\n";
+    }
+    if (std::any_of(args.begin(), args.end(), [](const std::string &arg) {
+            return arg.ends_with("=native");
+        })) {
+        key += "native: " + nativeArchHash(executable) + "\n";
+    }
+    key += "src:\n" + src;
+    return key;
+}
+
+/**
+ * Find an entry and refresh its time for LRU. Return an empty path on a miss.
+ * The caller should hold the lock
+ */
+static fs::path findEntry(const fs::path &dir, const std::string &key) {
+    std::error_code ec;
+    auto entry = dir / toHex(stableHash(key));
+    if (!fs::exists(entry, ec)) {
+        return {};
+    }
+    if (readFile(entry / "key") != key) {
+        return {}; // Hash collision
+    }
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return entry;
+}
+
+bool KernelCache::lookup(const std::string &key, const std::string &dst) {
+    auto &&dir = Config::kernelCacheDir();
+    if (dir.empty()) {
+        return false;
+    }
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    // Copy under the lock, so the entry will not be evicted in the middle
+    CacheLock lock(dir, false);
+    auto entry = findEntry(dir, key);
+    if (entry.empty()) {
+        return false;
+    }
+    fs::copy_file(entry / "run.so", dst,
+                  fs::copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+std::string KernelCache::lookupDir(const std::string &key) {
+    auto &&dir = Config::kernelCacheDir();
+    std::error_code ec;
+    if (dir.empty() || !fs::exists(dir, ec)) {
+        return "";
+    }
+    CacheLock lock(dir, false);
+    return findEntry(dir, key).string();
+}
+
+std::string KernelCache::makeTempDir() {
+    auto &&dir = Config::kernelCacheDir();
+    if (dir.empty()) {
+        return "";
+    }
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    std::string tmp = (dir / "tmp.XXXXXX").string();
+    if (mkdtemp(tmp.data()) == nullptr) {
+        WARNING("Unable to create a temporary directory in kernel cache " +
+                dir.string());
+        return "";
+    }
+    return tmp;
+}
+
+void KernelCache::insertDir(const std::string &key, const std::string &tmp) {
+    auto &&dir = Config::kernelCacheDir();
+    std::error_code ec;
+    if (dir.empty()) {
+        fs::remove_all(tmp, ec);
+        return;
+    }
+    auto entry = dir / toHex(stableHash(key));
+
+    {
+        std::ofstream f(fs::path(tmp) / "key", std::ios::binary);
+        f << key;
+    }
+    size_t size = dirSize(tmp);
+    {
+        CacheLock lock(dir, false);
+        if (fs::exists(entry, ec) || rename(tmp.c_str(), entry.c_str()) != 0) {
+            // Either published by others, or a hash collision
+            fs::remove_all(tmp, ec);
+            return;
+        }
+    }
+
+    // Only scan the whole cache if it grows beyond the limit, or if the total
+    // size is not recorded yet. `evict` takes `CacheLock` then `CacheSize`, so
+    // do not call it with `CacheSize` held
+    bool needEvict;
+    {
+        CacheSize total(dir);
+        if (auto old = total.get(); old.has_value()) {
+            total.set(*old + size);
+            auto limit = Config::kernelCacheSize();
+            needEvict = limit > 0 && *old + size > limit;
+        } else {
+            needEvict = true;
+        }
+    }
+    if (needEvict) {
+        evict(dir);
+    }
+}
+
+void KernelCache::insert(const std::string &key, const std::string &so) {
+    auto tmp = makeTempDir();
+    if (tmp.empty()) {
+        return;
+    }
+    std::error_code ec;
+    fs::copy_file(so, fs::path(tmp) / "run.so", ec);
+    if (ec) {
+        fs::remove_all(tmp, ec);
+        return;
+    }
+    insertDir(key, tmp);
+}
+
+void KernelCache::clear() {
+    auto &&dir = Config::kernelCacheDir();
+    std::error_code ec;
+    if (dir.empty() || !fs::exists(dir, ec)) {
+        return;
+    }
+    CacheLock lock(dir, true);
+    for (auto &&entry : fs::directory_iterator(dir, ec)) {
+        if (entry.is_directory(ec)) {
+            fs::remove_all(entry.path(), ec);
+        }
+    }
+    CacheSize(dir).set(0);
+}
+
+} // namespace freetensor
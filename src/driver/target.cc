@@ -1,8 +1,243 @@
+#include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <unistd.h> // sysconf
+
 #include <driver/target.h>
 
 namespace freetensor {
 
+namespace fs = std::filesystem;
+
+namespace {
+
+struct HostCPUInfo {
+    size_t l1DataCacheSize = 32 << 10, l2CacheSize = 1 << 20, l3CacheSize = 0;
+    int cacheLineSize = 64;
+    int physicalCores = 1, threadsPerCore = 1, numaNodes = 1;
+};
+
+} // Anonymous namespace
+
+static std::string readLine(const fs::path &path) {
+    std::ifstream f(path);
+    std::string ret;
+    std::getline(f, ret);
+    return ret;
+}
+
+/**
+ * Parse sizes like "48K" or "32M" in `/sys`
+ */
+static size_t parseSize(const std::string &str) {
+    try {
+        size_t pos;
+        size_t ret = std::stoull(str, &pos);
+        if (pos < str.size()) {
+            switch (str[pos]) {
+            case 'K':
+                ret <<= 10;
+                break;
+            case 'M':
+                ret <<= 20;
+                break;
+            case 'G':
+                ret <<= 30;
+                break;
+            }
+        }
+        return ret;
+    } catch (const std::logic_error &) { // Thrown by std::sto*
+        return 0;
+    }
+}
+
+static bool isNumberedEntry(const fs::path &path, const std::string &prefix) {
+    auto name = path.filename().string();
+    return name.size() > prefix.size() && name.starts_with(prefix) &&
+           std::all_of(name.begin() + prefix.size(), name.end(), ::isdigit);
+}
+
+static HostCPUInfo detectHostCPU() {
+    HostCPUInfo ret;
+    std::error_code ec;
+
+    // Caches seen by CPU 0. Shared caches (usually L3) are reported in their
+    // total sizes
+    bool foundCache = false;
+    fs::path cacheDir = "/sys/devices/system/cpu/cpu0/cache";
+    for (auto &&entry : fs::directory_iterator(cacheDir, ec)) {
+        if (!isNumberedEntry(entry.path(), "index")) {
+            continue;
+        }
+        auto type = readLine(entry.path() / "type");
+        if (type == "Instruction") {
+            continue;
+        }
+        auto level = readLine(entry.path() / "level");
+        auto size = parseSize(readLine(entry.path() / "size"));
+        if (size == 0) {
+            continue;
+        }
+        foundCache = true;
+        if (level == "1") {
+            ret.l1DataCacheSize = size;
+            if (auto line =
+                    parseSize(readLine(entry.path() / "coherency_line_size"));
+                line > 0) {
+                ret.cacheLineSize = line;
+            }
+        } else if (level == "2") {
+            ret.l2CacheSize = size;
+        } else if (level == "3") {
+            ret.l3CacheSize = size;
+        }
+    }
+    if (!foundCache) {
+#ifdef _SC_LEVEL1_DCACHE_SIZE // glibc only
+        if (long size = sysconf(_SC_LEVEL1_DCACHE_SIZE); size > 0) {
+            ret.l1DataCacheSize = size;
+        }
+        if (long size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE); size > 0) {
+            ret.cacheLineSize = size;
+        }
+        if (long size = sysconf(_SC_LEVEL2_CACHE_SIZE); size > 0) {
+            ret.l2CacheSize = size;
+        }
+        if (long size = sysconf(_SC_LEVEL3_CACHE_SIZE); size > 0) {
+            ret.l3CacheSize = size;
+        }
+#endif
+    }
+
+    // Physical cores are identified by (package ID, core ID)
+    std::set<std::pair<std::string, std::string>> cores;
+    int logical = 0;
+    for (auto &&entry : fs::directory_iterator("/sys/devices/system/cpu", ec)) {
+        if (!isNumberedEntry(entry.path(), "cpu") ||
+            !fs::exists(entry.path() / "topology", ec)) {
+            continue;
+        }
+        logical++;
+        cores.emplace(
+            readLine(entry.path() / "topology" / "physical_package_id"),
+            readLine(entry.path() / "topology" / "core_id"));
+    }
+    if (logical == 0) {
+        logical = std::max(1u, std::thread::hardware_concurrency());
+        cores.clear();
+    }
+    ret.physicalCores = cores.empty() ? logical : cores.size();
+    ret.threadsPerCore = std::max(1, logical / ret.physicalCores);
+
+    int nodes = 0;
+    for (auto &&entry :
+         fs::directory_iterator("/sys/devices/system/node", ec)) {
+        if (isNumberedEntry(entry.path(), "node")) {
+            nodes++;
+        }
+    }
+    ret.numaNodes = std::max(1, nodes);
+
+    return ret;
+}
+
+static const HostCPUInfo &hostCPU() {
+    static HostCPUInfo info = detectHostCPU();
+    return info;
+}
+
+static std::string detectISA(bool useNativeArch) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (useNativeArch) {
+        if (__builtin_cpu_supports("avx512f")) {
+            return "avx512";
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return "avx2";
+        }
+        if (__builtin_cpu_supports("avx")) {
+            return "avx";
+        }
+    }
+    return "sse2";
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    return "neon";
+#else
+    return "generic";
+#endif
+}
+
+CPUTarget::CPUTarget(bool useNativeArch) : useNativeArch_(useNativeArch) {
+    auto &&host = hostCPU();
+    l1DataCacheSize_ = host.l1DataCacheSize;
+    l2CacheSize_ = host.l2CacheSize;
+    l3CacheSize_ = host.l3CacheSize;
+    cacheLineSize_ = host.cacheLineSize;
+    physicalCores_ = host.physicalCores;
+    threadsPerCore_ = host.threadsPerCore;
+    numaNodes_ = host.numaNodes;
+    setISA(detectISA(useNativeArch_));
+}
+
+void CPUTarget::setUseNativeArch(bool useNativeArch) {
+    useNativeArch_ = useNativeArch;
+    setISA(detectISA(useNativeArch_));
+}
+
+void CPUTarget::setISA(const std::string &isa) {
+    if (isa == "avx512") {
+        vectorBytes_ = 64;
+    } else if (isa == "avx2" || isa == "avx") {
+        vectorBytes_ = 32;
+    } else if (isa == "sse2" || isa == "neon" || isa == "generic") {
+        vectorBytes_ = 16;
+    } else {
+        ERROR("Unrecognized CPU ISA " + isa);
+    }
+    isa_ = isa;
+}
+
+void CPUTarget::setCacheLineSize(int size) {
+    if (size <= 0 || (size & (size - 1)) != 0) {
+        ERROR("Cache line size should be a positive power of 2, got " +
+              std::to_string(size));
+    }
+    cacheLineSize_ = size;
+}
+
+void CPUTarget::setPhysicalCores(int n) {
+    if (n <= 0) {
+        ERROR("Number of physical cores should be positive, got " +
+              std::to_string(n));
+    }
+    physicalCores_ = n;
+}
+
+void CPUTarget::setThreadsPerCore(int n) {
+    if (n <= 0) {
+        ERROR("Number of threads per core should be positive, got " +
+              std::to_string(n));
+    }
+    threadsPerCore_ = n;
+}
+
+void CPUTarget::setNUMANodes(int n) {
+    if (n <= 0) {
+        ERROR("Number of NUMA nodes should be positive, got " +
+              std::to_string(n));
+    }
+    numaNodes_ = n;
+}
+
+int CPUTarget::vectorRegisters() const {
+    return isa_ == "avx512" || isa_ == "neon" ? 32 : 16;
+}
+
 bool isSameTarget(const Ref<Target> &lhs, const Ref<Target> &rhs) {
     if (lhs.isValid() != rhs.isValid()) {
         return false;
@@ -16,9 +251,17 @@ bool isSameTarget(const Ref<Target> &lhs, const Ref<Target> &rhs) {
     switch (lhs->type()) {
     case TargetType::CPU: {
         auto &&l = lhs.as<CPUTarget>(), &&r = rhs.as<CPUTarget>();
-        if (l->useNativeArch() != r->useNativeArch())
-            return false;
-        return true;
+        return l->useNativeArch() == r->useNativeArch() &&
+               l->l1DataCacheSize() == r->l1DataCacheSize() &&
+               l->l2CacheSize() == r->l2CacheSize() &&
+               l->l3CacheSize() == r->l3CacheSize() &&
+               l->cacheLineSize() == r->cacheLineSize() &&
+               l->isa() == r->isa() &&
+               l->physicalCores() == r->physicalCores() &&
+               l->threadsPerCore() == r->threadsPerCore() &&
+               l->numaNodes() == r->numaNodes() &&
+               l->useThreadPool() == r->useThreadPool() &&
+               l->useNativeGEMM() == r->useNativeGEMM();
     }
 #ifdef FT_WITH_CUDA
     case TargetType::GPU: {
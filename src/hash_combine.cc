@@ -7,4 +7,12 @@ size_t hashCombine(size_t seed, size_t other) {
     return seed ^ (other + 0x9e3779b9 + (seed << 6) + (seed >> 2));
 }
 
+uint64_t stableHash(const std::string &str, uint64_t h) {
+    for (unsigned char c : str) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
 } // namespace freetensor
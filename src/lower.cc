@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include <lower.h>
+#include <pass/flatten_stmt_seq.h>
+#include <serialize/print_ast.h>
+#include <serialize/print_driver.h>
+
+namespace freetensor {
+
+namespace {
+
+std::atomic<size_t> nHit{0}, nMiss{0}, nFallback{0};
+
+/**
+ * Lowered statements, keyed by the serialized statements with their scopes,
+ * in the least recently used order
+ *
+ * `Hasher` ignores statement IDs and metadata, which are kept by the passes
+ * and used after lowering, so the full serialized form is used as the key
+ */
+class LowerCache {
+    struct Entry {
+        std::string key_;
+        Stmt lowered_;
+        size_t bytes_;
+    };
+
+    std::list<Entry> lru_; // Most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+    std::mutex lock_;
+
+  public:
+    std::optional<Stmt> lookup(const std::string &key) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (auto it = index_.find(key); it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->lowered_;
+        }
+        return std::nullopt;
+    }
+
+    void save(const std::string &key, const Stmt &lowered) {
+        // The lowered statement is roughly as large as its serialized input
+        size_t bytes = key.size() * 2 + 256;
+        std::lock_guard<std::mutex> guard(lock_);
+        if (index_.count(key)) {
+            return;
+        }
+        lru_.emplace_front(Entry{key, lowered, bytes});
+        index_.emplace(lru_.front().key_, lru_.begin());
+        bytes_ += bytes;
+        while (bytes_ > Config::lowerCacheSize() && !lru_.empty()) {
+            bytes_ -= lru_.back().bytes_;
+            index_.erase(lru_.back().key_);
+            lru_.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(lock_);
+        index_.clear();
+        lru_.clear();
+        bytes_ = 0;
+    }
+
+    std::pair<size_t, size_t> size() {
+        std::lock_guard<std::mutex> guard(lock_);
+        return {lru_.size(), bytes_};
+    }
+};
+
+LowerCache &lowerCache() {
+    static LowerCache cache;
+    return cache;
+}
+
+/**
+ * Wrap a statement in the scope of the I/O variables
+ */
+Stmt wrapInScope(const Stmt &stmt, const std::vector<VarDef> &scope) {
+    Stmt ret = stmt;
+    for (auto it = scope.rbegin(); it != scope.rend(); it++) {
+        auto &&def = *it;
+        auto atype = def->buffer_->atype();
+        if (atype == AccessType::Output) {
+            // Other statements may read it
+            atype = AccessType::InOut;
+        }
+        ret = makeVarDef(def->name_,
+                         makeBuffer(def->buffer_->tensor(), atype,
+                                    def->buffer_->mtype()),
+                         def->viewOf_, std::move(ret), def->pinned_,
+                         def->metadata(), def->id());
+    }
+    return ret;
+}
+
+/**
+ * Strip the scope added by `wrapInScope` from a lowered statement. Return
+ * nullopt if the scope is altered by the passes
+ */
+std::optional<Stmt> unwrapFromScope(const Stmt &lowered,
+                                    const std::vector<VarDef> &scope) {
+    Stmt ret = lowered;
+    for (auto &&def : scope) {
+        if (ret->nodeType() != ASTNodeType::VarDef || ret->id() != def->id()) {
+            return std::nullopt;
+        }
+        auto wrapper = ret.as<VarDefNode>();
+        if (wrapper->name_ != def->name_ ||
+            wrapper->buffer_->mtype() != def->buffer_->mtype() ||
+            !HashComparator()(wrapper->buffer_->tensor(),
+                              def->buffer_->tensor())) {
+            return std::nullopt;
+        }
+        ret = wrapper->body_;
+    }
+    return ret;
+}
+
+} // Anonymous namespace
+
+LowerCacheStats lowerCacheStats() {
+    LowerCacheStats ret;
+    ret.nHit_ = nHit;
+    ret.nMiss_ = nMiss;
+    ret.nFallback_ = nFallback;
+    std::tie(ret.entries_, ret.bytes_) = lowerCache().size();
+    return ret;
+}
+
+void clearLowerCache() { lowerCache().clear(); }
+
+Stmt lowerIncremental(const Stmt &ast, const Ref<Target> &target,
+                      const std::unordered_set<std::string> &skipPasses,
+                      int verbose) {
+    // Only print the whole program, not every statement
+    int stmtVerbose = verbose >= 2 ? verbose : 0;
+
+    std::vector<VarDef> scope;
+    Stmt body = ast;
+    while (body->nodeType() == ASTNodeType::VarDef) {
+        auto def = body.as<VarDefNode>();
+        if (def->buffer_->atype() == AccessType::Cache ||
+            def->viewOf_.has_value()) {
+            break;
+        }
+        scope.emplace_back(def);
+        body = def->body_;
+    }
+    std::vector<Stmt> stmts;
+    if (body->nodeType() == ASTNodeType::StmtSeq) {
+        stmts = body.as<StmtSeqNode>()->stmts_;
+    } else {
+        stmts = {body};
+    }
+
+    std::string keyPrefix;
+    {
+        // All parameters of the target, which may be mutated between calls
+        auto &&[targetMeta, targetData] = dumpTarget(target);
+        std::ostringstream os;
+        os << targetMeta << " " << targetData << " skip";
+        std::vector<std::string> skips(skipPasses.begin(), skipPasses.end());
+        std::sort(skips.begin(), skips.end());
+        for (auto &&name : skips) {
+            os << " " << name;
+        }
+        os << "\n";
+        keyPrefix = os.str();
+    }
+
+    std::vector<Stmt> loweredStmts;
+    loweredStmts.reserve(stmts.size());
+    for (auto &&stmt : stmts) {
+        auto wrapped = wrapInScope(stmt, scope);
+        auto key = keyPrefix + dumpAST(wrapped);
+        if (auto cached = lowerCache().lookup(key); cached.has_value()) {
+            nHit++;
+            loweredStmts.emplace_back(*cached);
+            continue;
+        }
+        nMiss++;
+        auto lowered = unwrapFromScope(
+            lowerWhole(wrapped, target, skipPasses, stmtVerbose), scope);
+        if (!lowered.has_value()) {
+            nFallback++;
+            return lowerWhole(ast, target, skipPasses, verbose);
+        }
+        lowerCache().save(key, *lowered);
+        loweredStmts.emplace_back(*lowered);
+    }
+
+    Stmt ret = body->nodeType() == ASTNodeType::StmtSeq
+                   ? makeStmtSeq(std::move(loweredStmts), body->metadata(),
+                                 body->id())
+                   : loweredStmts.front();
+    for (auto it = scope.rbegin(); it != scope.rend(); it++) {
+        auto &&def = *it;
+        ret = makeVarDef(def->name_, def->buffer_, def->viewOf_, std::move(ret),
+                         def->pinned_, def->metadata(), def->id());
+    }
+    ret = flattenStmtSeq(ret);
+
+    if (verbose >= 1) {
+        logger() << "The lowered AST is:" << std::endl << ret << std::endl;
+    }
+    return ret;
+}
+
+} // namespace freetensor
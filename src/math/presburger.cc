@@ -1,8 +1,145 @@
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include <config.h>
 #include <container_utils.h>
 #include <math/presburger.h>
 
 namespace freetensor {
 
+namespace {
+
+std::atomic<size_t> nCtxAlloc = 0, nCtxReuse = 0;
+std::atomic<size_t> nMemoHit = 0, nMemoMiss = 0, nMemoEvict = 0;
+
+/**
+ * Idle `isl_ctx`s of a thread
+ */
+struct CtxPool {
+    static constexpr size_t MAX_IDLE = 16;
+
+    std::vector<isl_ctx *> idle_;
+
+    ~CtxPool() {
+        for (auto ctx : idle_) {
+            isl_ctx_free(ctx);
+        }
+    }
+};
+
+thread_local CtxPool ctxPool;
+
+/**
+ * A shard of `PBMemo`, in LRU order
+ */
+struct MemoShard {
+    std::mutex lock_;
+    std::list<std::pair<std::string, std::string>> lru_; // Most recent first
+    std::unordered_map<std::string_view, decltype(lru_)::iterator> index_;
+    size_t bytes_ = 0;
+
+    static size_t bytesOf(const std::string &key, const std::string &result) {
+        // Rough overhead of the list node and the hash table entry
+        return key.size() + result.size() + 128;
+    }
+};
+
+constexpr size_t N_MEMO_SHARDS = 16;
+MemoShard memoShards[N_MEMO_SHARDS];
+
+MemoShard &memoShardOf(const std::string &key) {
+    return memoShards[std::hash<std::string>()(key) % N_MEMO_SHARDS];
+}
+
+} // Anonymous namespace
+
+isl_ctx *PBCtx::acquire() {
+    if (!ctxPool.idle_.empty()) {
+        auto ctx = ctxPool.idle_.back();
+        ctxPool.idle_.pop_back();
+        nCtxReuse++;
+        return ctx;
+    }
+    auto ctx = isl_ctx_alloc();
+    isl_options_set_on_error(ctx, ISL_ON_ERROR_ABORT);
+    nCtxAlloc++;
+    return ctx;
+}
+
+void PBCtx::release(isl_ctx *ctx) {
+    if (ctxPool.idle_.size() < CtxPool::MAX_IDLE) {
+        isl_ctx_reset_error(ctx);
+        isl_ctx_reset_operations(ctx);
+        ctxPool.idle_.emplace_back(ctx);
+    } else {
+        isl_ctx_free(ctx);
+    }
+}
+
+bool PBMemo::enabled() { return Config::pbMemoSize() > 0; }
+
+std::optional<std::string> PBMemo::lookup(const std::string &key) {
+    auto &shard = memoShardOf(key);
+    std::lock_guard<std::mutex> guard(shard.lock_);
+    if (auto it = shard.index_.find(key); it != shard.index_.end()) {
+        shard.lru_.splice(shard.lru_.begin(), shard.lru_, it->second);
+        nMemoHit++;
+        return it->second->second;
+    }
+    nMemoMiss++;
+    return std::nullopt;
+}
+
+void PBMemo::save(const std::string &key, const std::string &result) {
+    size_t limit = Config::pbMemoSize() / N_MEMO_SHARDS;
+    size_t bytes = MemoShard::bytesOf(key, result);
+    if (bytes > limit) {
+        return;
+    }
+    auto &shard = memoShardOf(key);
+    std::lock_guard<std::mutex> guard(shard.lock_);
+    if (shard.index_.count(key)) {
+        return; // Saved by another thread
+    }
+    while (!shard.lru_.empty() && shard.bytes_ + bytes > limit) {
+        auto &&[k, r] = shard.lru_.back();
+        shard.bytes_ -= MemoShard::bytesOf(k, r);
+        shard.index_.erase(k);
+        shard.lru_.pop_back();
+        nMemoEvict++;
+    }
+    shard.lru_.emplace_front(key, result);
+    shard.index_.emplace(shard.lru_.front().first, shard.lru_.begin());
+    shard.bytes_ += bytes;
+}
+
+void PBMemo::clear() {
+    for (auto &shard : memoShards) {
+        std::lock_guard<std::mutex> guard(shard.lock_);
+        shard.index_.clear();
+        shard.lru_.clear();
+        shard.bytes_ = 0;
+    }
+}
+
+PBStats pbStats() {
+    PBStats ret;
+    ret.nCtxAlloc_ = nCtxAlloc;
+    ret.nCtxReuse_ = nCtxReuse;
+    ret.nMemoHit_ = nMemoHit;
+    ret.nMemoMiss_ = nMemoMiss;
+    ret.nMemoEvict_ = nMemoEvict;
+    for (auto &shard : memoShards) {
+        std::lock_guard<std::mutex> guard(shard.lock_);
+        ret.memoEntries_ += shard.lru_.size();
+        ret.memoBytes_ += shard.bytes_;
+    }
+    return ret;
+}
+
 std::ostream &operator<<(std::ostream &os, const PBBuildExpr &e) {
     os << e.expr_;
     return os;
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <climits>
+
 #include <container_utils.h>
 #include <hash.h>
 #include <pass/cpu/lower_parallel_reduction.h>
@@ -8,6 +11,211 @@ namespace freetensor {
 
 namespace cpu {
 
+namespace {
+
+// Upper bound of the bytes of all private buffers of a variable
+constexpr int64_t MAX_PRIVATE_BYTES = 16ll << 20;
+
+// Minimum number of reductions to a variable in a loop to privatize. Below
+// it, the parallel merge costs more than the atomic operations
+constexpr int64_t MIN_PRIVATE_UPDATES = 1ll << 16;
+
+int64_t mulSat(int64_t lhs, int64_t rhs) {
+    if (lhs > 0 && rhs > LLONG_MAX / lhs) {
+        return LLONG_MAX;
+    }
+    return lhs * rhs;
+}
+
+std::string threadIter(const ID &loop) { return "__thread_" + toString(loop); }
+
+std::string privateBuffer(const ID &loop, size_t i) {
+    return "__private_" + toString(loop) + "_" + std::to_string(i);
+}
+
+/**
+ * Row-major offset of `indices` in a tensor of `shape`
+ */
+Expr flattenIndices(const std::vector<Expr> &indices,
+                    const std::vector<Expr> &shape) {
+    Expr ret = makeIntConst(0);
+    for (auto &&[idx, dim] : views::zip(indices, shape)) {
+        ret = makeAdd(makeMul(ret, dim), idx);
+    }
+    return ret;
+}
+
+} // Anonymous namespace
+
+int FindPrivatizedReductions::numThreads(const For &loop) const {
+    if (auto scope = std::get_if<OpenMPScope>(&loop->property_->parallel_);
+        scope != nullptr && scope->numThreads_ > 0) {
+        return scope->numThreads_;
+    }
+    return target_->hardwareThreads();
+}
+
+int64_t FindPrivatizedReductions::tripCount(const Expr &len) {
+    // Unknown trip counts are regarded as large
+    return std::max<int64_t>(unique_.getIntUpper(len), 0);
+}
+
+int64_t FindPrivatizedReductions::numElements(const std::vector<Expr> &shape) {
+    int64_t ret = 1;
+    for (auto &&dim : shape) {
+        auto upper = unique_.getIntUpper(dim);
+        if (upper == LLONG_MAX) {
+            return -1;
+        }
+        ret = mulSat(ret, std::max<int64_t>(upper, 0));
+    }
+    return ret == LLONG_MAX ? -1 : ret;
+}
+
+void FindPrivatizedReductions::decide() {
+    auto &&items = loop_->property_->reductions_;
+    int nThreads = numThreads(loop_);
+    std::vector<PrivatizedReduction> result;
+    for (auto &&[var, info] : vars_) {
+        if (info.accessed_ || info.ops_.size() != 1) {
+            continue;
+        }
+        auto op = *info.ops_.begin();
+
+        std::vector<Ref<ReductionItem>> varItems;
+        for (auto &&item : items) {
+            if (item->var_ == var) {
+                varItems.emplace_back(item);
+            }
+        }
+
+        // OpenMP's `reduction` clause accepts only one operator, so items with
+        // other operators than the first item must be privatized
+        bool mixed = !varItems.empty() && op != items.front()->op_;
+        bool contended = info.synced_ && nThreads > 1 &&
+                         info.updates_ >= MIN_PRIVATE_UPDATES;
+        if (!mixed && !contended) {
+            continue;
+        }
+
+        auto &&tensor = buffer(var)->tensor();
+        PrivatizedReduction r{var, op, {}, {}, 1};
+        if (!info.synced_ && varItems.size() == 1) {
+            auto &&item = varItems.front();
+            r.begins_ = item->begins_;
+            for (auto &&[begin, end] : views::zip(item->begins_, item->ends_)) {
+                auto dim = makeSub(end, begin);
+                if (auto c = unique_.getInt(dim); c.has_value()) {
+                    dim = makeIntConst(*c);
+                }
+                r.shape_.emplace_back(std::move(dim));
+            }
+        } else {
+            r.begins_ = std::vector<Expr>(tensor->shape().size(),
+                                          makeIntConst(0));
+            r.shape_ = tensor->shape();
+        }
+        auto n = numElements(r.shape_);
+        if (n < 0) {
+            continue;
+        }
+        r.padding_ = std::max<int>(
+            1, target_->cacheLineSize() / sizeOf(tensor->dtype()));
+        auto padded = mulSat(n / r.padding_ + (n % r.padding_ != 0 ? 1 : 0),
+                             r.padding_);
+        if (mulSat(mulSat(padded, nThreads), sizeOf(tensor->dtype())) >
+            MAX_PRIVATE_BYTES) {
+            continue;
+        }
+        // Merging costs a pass over all the private buffers, so atomic
+        // operations are preferred if each element is seldom updated
+        if (!mixed && info.updates_ < mulSat(n, nThreads)) {
+            continue;
+        }
+        result.emplace_back(std::move(r));
+    }
+    if (!result.empty()) {
+        // Make the order deterministic
+        std::sort(result.begin(), result.end(),
+                  [](const auto &lhs, const auto &rhs) {
+                      return lhs.var_ < rhs.var_;
+                  });
+        results_[loop_->id()] = std::move(result);
+    }
+}
+
+void FindPrivatizedReductions::visit(const VarDef &op) {
+    if (loop_.isValid()) {
+        defsInLoop_.insert(op->name_);
+        if (op->viewOf_.has_value()) {
+            // Accessing through a view is not tracked
+            auto d = op;
+            while (d->viewOf_.has_value()) {
+                d = def(*d->viewOf_);
+            }
+            vars_[d->name_].accessed_ = true;
+        }
+    }
+    BaseClass::visit(op);
+}
+
+void FindPrivatizedReductions::visit(const For &op) {
+    bool parallel =
+        std::holds_alternative<OpenMPScope>(op->property_->parallel_);
+    if (loop_.isValid()) {
+        if (parallel ||
+            std::holds_alternative<OpenMPTaskScope>(op->property_->parallel_)) {
+            nestedParallel_ = true;
+        }
+        auto oldWeight = weight_;
+        weight_ = mulSat(weight_, tripCount(op->len_));
+        BaseClass::visit(op);
+        weight_ = oldWeight;
+    } else if (parallel) {
+        loop_ = op;
+        weight_ = tripCount(op->len_);
+        BaseClass::visit(op);
+        if (!nestedParallel_) {
+            decide();
+        }
+        loop_ = nullptr;
+        nestedParallel_ = false;
+        defsInLoop_.clear();
+        vars_.clear();
+    } else {
+        BaseClass::visit(op);
+    }
+}
+
+void FindPrivatizedReductions::visit(const Load &op) {
+    BaseClass::visit(op);
+    if (loop_.isValid() && !defsInLoop_.count(op->var_)) {
+        vars_[op->var_].accessed_ = true;
+    }
+}
+
+void FindPrivatizedReductions::visit(const Store &op) {
+    BaseClass::visit(op);
+    if (loop_.isValid() && !defsInLoop_.count(op->var_)) {
+        vars_[op->var_].accessed_ = true;
+    }
+}
+
+void FindPrivatizedReductions::visit(const ReduceTo &op) {
+    BaseClass::visit(op);
+    if (loop_.isValid() && !defsInLoop_.count(op->var_)) {
+        auto &info = vars_[op->var_];
+        info.ops_.insert(op->op_);
+        info.synced_ |= op->sync_;
+        info.updates_ = info.updates_ > LLONG_MAX - weight_
+                            ? LLONG_MAX
+                            : info.updates_ + weight_;
+        if (def(op->var_)->viewOf_.has_value()) {
+            info.accessed_ = true;
+        }
+    }
+}
+
 std::vector<std::pair<For, int>>
 LowerParallelReduction::reducedBy(const ReduceTo &op) {
     std::vector<std::pair<For, int>> ret;
@@ -23,13 +231,132 @@ LowerParallelReduction::reducedBy(const ReduceTo &op) {
     return ret;
 }
 
+Stmt LowerParallelReduction::privatize(
+    const For &op, const std::vector<PrivatizedReduction> &reductions) {
+    int nThreads = privatization_.numThreads(op);
+    auto nThreadsExpr = makeIntConst(nThreads);
+    auto iter = threadIter(op->id());
+
+    std::vector<std::string> buffers;
+    std::vector<std::vector<Expr>> bufferShapes;
+    std::vector<DataType> dtypes;
+    std::vector<MemType> mtypes;
+    std::vector<Stmt> initStmts, mergeStmts;
+    for (auto &&[i, r] : views::enumerate(reductions)) {
+        auto dtype = buffer(r.var_)->tensor()->dtype();
+        auto name = privateBuffer(op->id(), i);
+
+        // [thread, flattened shape], where only the slice of each thread is
+        // padded, so different threads do not share cache lines
+        std::vector<Expr> shape = r.shape_;
+        std::vector<Expr> indices;
+        for (size_t j = 0, m = shape.size(); j < m; j++) {
+            indices.emplace_back(makeVar(name + "." + std::to_string(j)));
+        }
+        Expr sliceLen = makeIntConst(1);
+        for (auto &&dim : shape) {
+            sliceLen = makeMul(sliceLen, dim);
+        }
+        auto padding = makeIntConst(r.padding_);
+        std::vector<Expr> bufferShape = {
+            nThreadsExpr, makeMul(makeCeilDiv(sliceLen, padding), padding)};
+        std::vector<Expr> privIndices = {makeVar(iter),
+                                         flattenIndices(indices, shape)};
+
+        // Each thread initializes its own buffer
+        initStmts.emplace_back(makeNestedLoops(
+            indices, views::repeat(makeIntConst(0)), shape,
+            views::repeat(makeIntConst(1)), shape,
+            views::repeat(Ref<ForProperty>::make()),
+            makeStore(name, privIndices, neutralVal(dtype, r.op_))));
+
+        // Merge the buffers in parallel over the elements
+        auto merge = makeFor(
+            iter, makeIntConst(0), nThreadsExpr, makeIntConst(1), nThreadsExpr,
+            Ref<ForProperty>::make(),
+            makeReduceTo(r.var_,
+                         ranges::to<std::vector>(views::zip_with(
+                             [](auto &&x, auto &&y) { return makeAdd(x, y); },
+                             r.begins_, indices)),
+                         r.op_, makeLoad(name, privIndices, dtype), false));
+        mergeStmts.emplace_back(makeNestedLoops(
+            indices, views::repeat(makeIntConst(0)), shape,
+            views::repeat(makeIntConst(1)), shape,
+            views::repeat(
+                Ref<ForProperty>::make()->withParallel(OpenMPScope{})),
+            merge));
+
+        // Buffers of non-constant sizes are allocated by `make_heap_alloc`,
+        // and `CodeGenCPU` still places them in the workspace if bounded
+        bool isConst = std::all_of(shape.begin(), shape.end(), [](auto &&dim) {
+            return dim->nodeType() == ASTNodeType::IntConst;
+        });
+        buffers.emplace_back(std::move(name));
+        bufferShapes.emplace_back(std::move(bufferShape));
+        dtypes.emplace_back(dtype);
+        mtypes.emplace_back(isConst ? MemType::CPU : MemType::CPUHeap);
+    }
+
+    // Each thread runs a contiguous chunk of iterations. The chunk keeps the
+    // other properties of the original loop (e.g. `noDeps_` and `vectorize_`),
+    // while the remaining reductions are done by the outer loop
+    auto chunk = makeCeilDiv(op->len_, nThreadsExpr);
+    auto lo = makeMul(makeVar(iter), chunk);
+    auto len = makeMax(makeMin(makeSub(op->len_, lo), chunk), makeIntConst(0));
+    auto innerProperty = deepCopy(op->property_);
+    innerProperty->parallel_ = serialScope;
+    innerProperty->reductions_.clear();
+    auto inner = makeFor(
+        op->iter_, makeAdd(op->begin_, makeMul(lo, op->step_)),
+        makeAdd(op->begin_, makeMul(makeAdd(lo, len), op->step_)), op->step_,
+        len, std::move(innerProperty), op->body_);
+    initStmts.emplace_back(inner);
+
+    auto scope = std::get<OpenMPScope>(op->property_->parallel_);
+    scope.schedule_ = OpenMPScope::Static;
+    scope.chunk_ = 1;
+    Stmt ret = makeFor(iter, makeIntConst(0), nThreadsExpr, makeIntConst(1),
+                       nThreadsExpr, op->property_->withParallel(scope),
+                       makeStmtSeq(std::move(initStmts)), op->metadata(),
+                       op->id());
+    mergeStmts.insert(mergeStmts.begin(), ret);
+    ret = makeStmtSeq(std::move(mergeStmts));
+    for (auto &&[name, shape, dtype, mtype] :
+         views::zip(buffers, bufferShapes, dtypes, mtypes)) {
+        ret = makeVarDef(name,
+                         makeBuffer(makeTensor(shape, dtype), AccessType::Cache,
+                                    mtype),
+                         std::nullopt, ret, false);
+    }
+    return ret;
+}
+
 Stmt LowerParallelReduction::visit(const For &_op) {
-    if (_op->property_->reductions_.empty()) {
+    auto privIt = privatization_.results().find(_op->id());
+    bool privatized = privIt != privatization_.results().end();
+    if (_op->property_->reductions_.empty() && !privatized) {
         return BaseClass::visit(_op);
     }
 
     auto op = deepCopy(_op).as<ForNode>();
 
+    if (privatized) {
+        // Privatized reductions are no longer reduced by OpenMP
+        auto &&items = op->property_->reductions_;
+        for (auto &&[i, r] : views::enumerate(privIt->second)) {
+            for (size_t j = 0; j < items.size();) {
+                if (items[j]->var_ == r.var_) {
+                    items.erase(items.begin() + j);
+                } else {
+                    j++;
+                }
+            }
+            private_.emplace(r.var_,
+                             std::make_pair(privateBuffer(op->id(), i), r));
+        }
+        thread_ = makeVar(threadIter(op->id()));
+    }
+
     // special case for perfectly nested loops to be collapsed.
     // reduction variables should be identical among them.
     if (!loopStack_.empty() && _op->parentStmt() == loopStack_.back()) {
@@ -56,6 +383,11 @@ Stmt LowerParallelReduction::visit(const For &_op) {
     ASSERT(__op->nodeType() == ASTNodeType::For);
     op = __op.as<ForNode>();
     loopStack_.pop_back();
+    if (privatized) {
+        for (auto &&r : privIt->second) {
+            private_.erase(r.var_);
+        }
+    }
 
     std::vector<Stmt> initStmts, flushStmts;
 
@@ -111,7 +443,7 @@ Stmt LowerParallelReduction::visit(const For &_op) {
 
     std::vector<Stmt> stmts;
     stmts.insert(stmts.end(), initStmts.begin(), initStmts.end());
-    stmts.emplace_back(op);
+    stmts.emplace_back(privatized ? privatize(op, privIt->second) : op);
     stmts.insert(stmts.end(), flushStmts.begin(), flushStmts.end());
     Stmt ret = makeStmtSeq(std::move(stmts));
     for (auto &&[workspace, wsShape, dtype] :
@@ -130,6 +462,17 @@ Stmt LowerParallelReduction::visit(const ReduceTo &_op) {
     ASSERT(__op->nodeType() == ASTNodeType::ReduceTo);
     auto op = __op.as<ReduceToNode>();
 
+    if (auto it = private_.find(op->var_); it != private_.end()) {
+        auto &&[name, r] = it->second;
+        std::vector<Expr> indices;
+        for (auto &&[idx, begin] : views::zip(op->indices_, r.begins_)) {
+            indices.emplace_back(makeSub(idx, begin));
+        }
+        return makeReduceTo(name, {thread_, flattenIndices(indices, r.shape_)},
+                            op->op_, op->expr_, false, op->metadata(),
+                            op->id());
+    }
+
     if (op->sync_) {
         return op;
     }
@@ -157,8 +500,11 @@ Stmt LowerParallelReduction::visit(const ReduceTo &_op) {
     return op;
 }
 
-Stmt lowerParallelReduction(const Stmt &_op) {
-    auto op = LowerParallelReduction()(_op);
+Stmt lowerParallelReduction(const Stmt &_op, const Ref<CPUTarget> &_target) {
+    auto target = _target.isValid() ? _target : Ref<CPUTarget>::make();
+    FindPrivatizedReductions finder(target);
+    finder(_op);
+    auto op = LowerParallelReduction(finder)(_op);
     op = simplify(op); // flatten singleton loops
     return op;
 }
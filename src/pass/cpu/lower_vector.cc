@@ -0,0 +1,312 @@
+#include <analyze/all_uses.h>
+#include <analyze/analyze_linear.h>
+#include <container_utils.h>
+#include <pass/cpu/lower_vector.h>
+#include <pass/replace_iter.h>
+#include <pass/simplify.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+namespace {
+
+class InvalidCPUVector : public InvalidProgram {
+  public:
+    InvalidCPUVector(const std::string &msg) : InvalidProgram(msg) {}
+};
+
+} // namespace
+
+std::string LowerVector::vecType() const {
+    std::string ret;
+    switch (dtype_.base()) {
+    case DataType::Float64:
+        ret = "double";
+        break;
+    case DataType::Float32:
+        ret = "float";
+        break;
+    case DataType::Int64:
+        ret = "int64_t";
+        break;
+    case DataType::Int32:
+        ret = "int32_t";
+        break;
+    default:
+        throw InvalidCPUVector("Unsupported data type " + toString(dtype_));
+    }
+    return ret + ", " + std::to_string(vecLen_);
+}
+
+bool LowerVector::isInvariant(const Expr &expr) const {
+    return !allIters(expr).count(iter_);
+}
+
+void LowerVector::checkContiguous(const std::vector<Expr> &indices) const {
+    if (indices.empty()) {
+        throw InvalidCPUVector("Vectorized scalar access is not supported");
+    }
+    for (size_t i = 0, n = indices.size(); i + 1 < n; i++) {
+        if (!isInvariant(indices[i])) {
+            throw InvalidCPUVector(
+                "Vectorized non-contiguous memory access is not supported");
+        }
+    }
+    auto lin = linear(indices.back());
+    bool found = false;
+    for (auto &&[k, a] : lin.coeff_) {
+        if (a->nodeType() == ASTNodeType::Var &&
+            a.as<VarNode>()->name_ == iter_) {
+            // TODO: k can be -1, with a reversed vector
+            if (k != 1) {
+                throw InvalidCPUVector(
+                    "Vectorized non-contiguous memory access is not "
+                    "supported");
+            }
+            found = true;
+        } else if (!isInvariant(a)) {
+            throw InvalidCPUVector("Vectorized non-linear memory access is not "
+                                   "supported");
+        }
+    }
+    if (!found) {
+        // E.g. reducing into a scalar across the lanes
+        throw InvalidCPUVector("Vectorized access not varying with the "
+                               "iterator is not supported");
+    }
+}
+
+std::vector<Expr>
+LowerVector::laneZeroIndices(const std::vector<Expr> &indices) const {
+    std::vector<Expr> ret;
+    ret.reserve(indices.size());
+    for (auto &&idx : indices) {
+        ret.emplace_back(ReplaceIter(iter_, base_)(idx));
+    }
+    return ret;
+}
+
+bool LowerVector::isAligned(const std::string &var,
+                            const std::vector<Expr> &indices) {
+    // Only stack-allocated variables are aligned to cache lines, and no less
+    // than the vector width (see `CodeGenCPU`). The alignment of user data or
+    // heap-allocated variables is unknown
+    auto &&d = def(var);
+    if (d->buffer_->atype() != AccessType::Cache || d->viewOf_.has_value() ||
+        d->buffer_->mtype() != MemType::CPU) {
+        return false;
+    }
+    Expr offset;
+    auto &&shape = d->buffer_->tensor()->shape();
+    for (auto &&[idx, dim] : views::zip(indices, shape)) {
+        if (dim->nodeType() != ASTNodeType::IntConst) {
+            return false;
+        }
+        offset = offset.isValid() ? makeAdd(makeMul(offset, dim), idx) : idx;
+    }
+    auto toProve = makeEQ(makeMod(offset, makeIntConst(vecLen_)),
+                          makeIntConst(0));
+    return prove((*this)(toProve));
+}
+
+Expr LowerVector::genLoad(const std::string &var,
+                          const std::vector<Expr> &indices) {
+    auto &&lane0 = laneZeroIndices(indices);
+    auto addr = makeLoad(var, lane0, dtype_);
+    if (rem_.isValid()) {
+        return makeIntrinsic("simdLoadMasked<" + vecType() + ">(&(%), %)",
+                             {addr, rem_}, DataType::Custom, false);
+    } else if (isAligned(var, lane0)) {
+        return makeIntrinsic("simdLoadAligned<" + vecType() + ">(&(%))",
+                             {addr}, DataType::Custom, false);
+    } else {
+        return makeIntrinsic("simdLoad<" + vecType() + ">(&(%))", {addr},
+                             DataType::Custom, false);
+    }
+}
+
+Stmt LowerVector::genStore(const std::string &var,
+                           const std::vector<Expr> &indices, const Expr &vec) {
+    auto &&lane0 = laneZeroIndices(indices);
+    auto addr = makeLoad(var, lane0, dtype_);
+    if (rem_.isValid()) {
+        return makeEval(
+            makeIntrinsic("simdStoreMasked<" + vecType() + ">(&(%), %, %)",
+                          {addr, vec, rem_}, DataType::Void, true));
+    } else if (isAligned(var, lane0)) {
+        return makeEval(
+            makeIntrinsic("simdStoreAligned<" + vecType() + ">(&(%), %)",
+                          {addr, vec}, DataType::Void, true));
+    } else {
+        return makeEval(makeIntrinsic("simdStore<" + vecType() + ">(&(%), %)",
+                                      {addr, vec}, DataType::Void, true));
+    }
+}
+
+Expr LowerVector::vectorize(const Expr &op) {
+    if (isInvariant(op)) {
+        return makeIntrinsic("simdBroadcast<" + vecType() + ">(%)", {op},
+                             DataType::Custom, false);
+    }
+
+    auto binary = [&](const std::string &format) {
+        if (isFloat(op->dtype()) != isFloat(dtype_)) {
+            throw InvalidCPUVector("Mixed integer and floating-point "
+                                   "computation is not supported: " +
+                                   toString(op));
+        }
+        auto &&bin = op.as<BinaryExprNode>();
+        return makeIntrinsic(format,
+                             {vectorize(bin->lhs_), vectorize(bin->rhs_)},
+                             DataType::Custom, false);
+    };
+
+    switch (op->nodeType()) {
+    case ASTNodeType::Var:
+        return makeIntrinsic("simdIota<" + vecType() + ">(%)", {base_},
+                             DataType::Custom, false);
+    case ASTNodeType::Load: {
+        auto &&load = op.as<LoadNode>();
+        if (buffer(load->var_)->tensor()->dtype() != dtype_) {
+            throw InvalidCPUVector("Mixed data types are not supported");
+        }
+        checkContiguous(load->indices_);
+        return genLoad(load->var_, load->indices_);
+    }
+    case ASTNodeType::Add:
+        return binary("% + %");
+    case ASTNodeType::Sub:
+        return binary("% - %");
+    case ASTNodeType::Mul:
+        return binary("% * %");
+    case ASTNodeType::RealDiv:
+        return binary("% / %");
+    case ASTNodeType::Min:
+        return binary("simdMin(%, %)");
+    case ASTNodeType::Max:
+        return binary("simdMax(%, %)");
+    default:
+        throw InvalidCPUVector("Unsupported expression " + toString(op));
+    }
+}
+
+Stmt LowerVector::vectorize(const Stmt &op) {
+    switch (op->nodeType()) {
+    case ASTNodeType::StmtSeq: {
+        std::vector<Stmt> stmts;
+        for (auto &&stmt : op.as<StmtSeqNode>()->stmts_) {
+            stmts.emplace_back(vectorize(stmt));
+        }
+        return makeStmtSeq(std::move(stmts));
+    }
+    case ASTNodeType::Store: {
+        auto &&store = op.as<StoreNode>();
+        checkContiguous(store->indices_);
+        return genStore(store->var_, store->indices_, vectorize(store->expr_));
+    }
+    case ASTNodeType::ReduceTo: {
+        auto &&reduce = op.as<ReduceToNode>();
+        if (reduce->sync_) {
+            throw InvalidCPUVector("Atomic reduction is not supported");
+        }
+        checkContiguous(reduce->indices_);
+        auto old = genLoad(reduce->var_, reduce->indices_);
+        auto val = vectorize(reduce->expr_);
+        std::string format;
+        switch (reduce->op_) {
+        case ReduceOp::Add:
+            format = "% + %";
+            break;
+        case ReduceOp::Mul:
+            format = "% * %";
+            break;
+        case ReduceOp::Min:
+            format = "simdMin(%, %)";
+            break;
+        case ReduceOp::Max:
+            format = "simdMax(%, %)";
+            break;
+        default:
+            throw InvalidCPUVector("Unsupported reduction " + toString(op));
+        }
+        return genStore(
+            reduce->var_, reduce->indices_,
+            makeIntrinsic(format, {old, val}, DataType::Custom, false));
+    }
+    default:
+        throw InvalidCPUVector("Unsupported statement " + toString(op));
+    }
+}
+
+Stmt LowerVector::lowerLoop(const For &op) {
+    if (op->step_->nodeType() != ASTNodeType::IntConst ||
+        op->step_.as<IntConstNode>()->val_ != 1) {
+        throw InvalidCPUVector("Only loops with step 1 are supported");
+    }
+
+    // All vectors in the loop should be of the same data type as the written
+    // variables, so the number of lanes is consistent
+    dtype_ = DataType::Invalid;
+    for (auto &&name : allWrites(op->body_)) {
+        if (!hasDef(name)) {
+            throw InvalidCPUVector(
+                "Variables defined in a vectorized loop are not supported");
+        }
+        auto &&dtype = buffer(name)->tensor()->dtype();
+        if (dtype_ == DataType::Invalid) {
+            dtype_ = dtype;
+        } else if (dtype != dtype_) {
+            throw InvalidCPUVector("Mixed data types are not supported");
+        }
+    }
+    if (dtype_ == DataType::Invalid) {
+        throw InvalidCPUVector("Nothing to vectorize");
+    }
+    vecType(); // Check the data type
+    vecLen_ = vecBytes_ / sizeOf(dtype_);
+    iter_ = op->iter_;
+
+    auto len = makeIntConst(vecLen_);
+    auto nVec = makeFloorDiv(op->len_, len);
+
+    base_ = makeAdd(op->begin_, makeMul(makeVar(iter_), len));
+    rem_ = nullptr;
+    auto mainBody = vectorize(op->body_);
+
+    base_ = makeAdd(op->begin_, makeMul(nVec, len));
+    rem_ = makeMod(op->len_, len);
+    auto tailBody = vectorize(op->body_);
+
+    auto main = makeFor(iter_, makeIntConst(0), nVec, makeIntConst(1), nVec,
+                        op->property_->withVectorize(false), mainBody,
+                        op->metadata(), op->id());
+    auto tail = makeIf(makeGT(rem_, makeIntConst(0)), tailBody);
+    return makeStmtSeq({main, tail});
+}
+
+Stmt LowerVector::visit(const For &op) {
+    if (op->property_->vectorize_) {
+        try {
+            auto ret = lowerLoop(op);
+            iter_.clear(), base_ = rem_ = nullptr;
+            return ret;
+        } catch (const InvalidCPUVector &e) {
+            iter_.clear(), base_ = rem_ = nullptr;
+            WARNING("Lowering vectorized loop " + toString(op->id()) + "(" +
+                    toString(op->metadata()) +
+                    ") to explicit SIMD failed because: " + e.what() +
+                    ". Leaving it to the backend compiler");
+        }
+    }
+    return BaseClass::visit(op);
+}
+
+Stmt lowerVector(const Stmt &_op, const Ref<CPUTarget> &target) {
+    auto op = LowerVector(target->vectorBytes())(_op);
+    return simplify(op);
+}
+
+} // namespace cpu
+
+} // namespace freetensor
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <climits>
+
+#include <math/utils.h>
+#include <pass/cpu/plan_memory.h>
+
+namespace freetensor {
+
+namespace cpu {
+
+std::vector<FindLiveRanges::Buffer> FindLiveRanges::buffers() const {
+    auto ret = buffers_;
+    for (auto &&b : ret) {
+        if (b.begin_ > b.end_) {
+            // Never accessed, but still needs an address. Put it at a time
+            // before any access
+            b.begin_ = b.end_ = -1;
+        }
+        if (auto it = extendTo_.find(b.id_); it != extendTo_.end()) {
+            for (auto &&loop : it->second) {
+                auto &&[begin, end] = loopRange_.at(loop);
+                b.begin_ = std::min(b.begin_, begin);
+                b.end_ = std::max(b.end_, end);
+            }
+        }
+    }
+    return ret;
+}
+
+void FindLiveRanges::use(const std::string &var) {
+    auto d = def(var);
+    while (d->viewOf_.has_value()) {
+        d = def(*d->viewOf_);
+    }
+    if (auto it = bufferIdx_.find(d->id()); it != bufferIdx_.end()) {
+        auto &b = buffers_[it->second];
+        b.begin_ = std::min(b.begin_, time_);
+        b.end_ = std::max(b.end_, time_);
+        if (loops_.size() > b.loopDepth_) {
+            // Used in a loop inside the VarDef. Keep it alive through the
+            // outermost such loop
+            extendTo_[b.id_].insert(loops_[b.loopDepth_]->id());
+        }
+    }
+}
+
+void FindLiveRanges::visitStmt(const Stmt &op) {
+    time_++;
+    BaseClass::visitStmt(op);
+    time_++;
+}
+
+void FindLiveRanges::visit(const VarDef &op) {
+    auto &&tensor = op->buffer_->tensor();
+    auto mtype = op->buffer_->mtype();
+    if (op->buffer_->atype() == AccessType::Cache && !op->viewOf_.has_value() &&
+        !tensor->shape().empty() &&
+        (mtype == MemType::CPU || mtype == MemType::CPUHeap)) {
+        int64_t size = sizeOf(tensor->dtype());
+        for (auto &&dim : tensor->shape()) {
+            int64_t upper = dim->nodeType() == ASTNodeType::IntConst
+                                ? dim.as<IntConstNode>()->val_
+                                : unique_.getIntUpper(dim);
+            upper = std::max<int64_t>(upper, 0);
+            if (upper == LLONG_MAX || (upper > 0 && size > LLONG_MAX / upper)) {
+                size = -1;
+                break;
+            }
+            size *= upper;
+        }
+        if (size >= 0 && (mtype == MemType::CPU || size <= maxHeapBytes_)) {
+            bufferIdx_[op->id()] = buffers_.size();
+            size = ceilDiv<int64_t>(size, alignment_) * alignment_;
+            buffers_.emplace_back(Buffer{op->id(), size, inParallel_ > 0,
+                                         LLONG_MAX, LLONG_MIN, loops_.size()});
+        }
+    }
+    BaseClass::visit(op);
+}
+
+void FindLiveRanges::visit(const For &op) {
+    bool parallel =
+        std::holds_alternative<OpenMPScope>(op->property_->parallel_) ||
+        std::holds_alternative<OpenMPTaskScope>(op->property_->parallel_);
+    auto begin = time_;
+    loops_.emplace_back(op);
+    inParallel_ += parallel;
+    for (auto &&r : op->property_->reductions_) {
+        use(r->var_);
+    }
+    BaseClass::visit(op);
+    inParallel_ -= parallel;
+    loops_.pop_back();
+    loopRange_[op->id()] = {begin, time_};
+}
+
+void FindLiveRanges::visit(const Load &op) {
+    BaseClass::visit(op);
+    use(op->var_);
+}
+
+void FindLiveRanges::visit(const Store &op) {
+    BaseClass::visit(op);
+    use(op->var_);
+}
+
+void FindLiveRanges::visit(const ReduceTo &op) {
+    BaseClass::visit(op);
+    use(op->var_);
+}
+
+void FindLiveRanges::visit(const Alloc &op) {
+    BaseClass::visit(op);
+    use(op->var_);
+    if (inParallel_ > 0) {
+        // `CodeGenCPU` places a heap-allocated variable where it is allocated,
+        // which may be in a parallel loop inside the VarDef
+        if (auto it = bufferIdx_.find(def(op->var_)->id());
+            it != bufferIdx_.end()) {
+            buffers_[it->second].perThread_ = true;
+        }
+    }
+}
+
+void FindLiveRanges::visit(const Free &op) {
+    BaseClass::visit(op);
+    use(op->var_);
+}
+
+MemoryPlan planMemory(const Stmt &op, int alignment, int64_t maxHeapBytes) {
+    FindLiveRanges finder(alignment, maxHeapBytes);
+    finder(op);
+    auto buffers = finder.buffers();
+
+    // First-fit decreasing: Larger buffers are placed first, each at the lowest
+    // offset not overlapping any placed buffer with an intersecting live range
+    std::stable_sort(buffers.begin(), buffers.end(),
+                     [](const auto &lhs, const auto &rhs) {
+                         return lhs.size_ > rhs.size_;
+                     });
+    MemoryPlan plan;
+    std::vector<const FindLiveRanges::Buffer *> placed[2]; // Shared, per-thread
+    for (auto &&b : buffers) {
+        auto &&others = placed[b.perThread_];
+        std::vector<std::pair<int64_t, int64_t>> busy;
+        for (auto &&other : others) {
+            if (other->begin_ <= b.end_ && b.begin_ <= other->end_) {
+                auto offset = plan.offset_.at(other->id_);
+                busy.emplace_back(offset, offset + other->size_);
+            }
+        }
+        std::sort(busy.begin(), busy.end());
+        int64_t offset = 0;
+        for (auto &&[l, r] : busy) {
+            if (l >= offset + b.size_) {
+                break;
+            }
+            offset = std::max(offset, r);
+        }
+        plan.offset_[b.id_] = offset;
+        auto &size = b.perThread_ ? plan.threadSize_ : plan.sharedSize_;
+        size = std::max(size, offset + b.size_);
+        others.emplace_back(&b);
+    }
+    return plan;
+}
+
+} // namespace cpu
+
+} // namespace freetensor
@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <mutex>
+
 #include <analyze/all_uses.h>
+#include <config.h>
 #include <container_utils.h>
 #include <pass/annotate_conds.h>
 #include <pass/flatten_stmt_seq.h>
@@ -18,6 +26,88 @@ static bool noIntersect(const std::unordered_set<std::string> &set1,
     return true;
 }
 
+namespace {
+
+std::atomic<size_t> nQuery{0}, nCacheHit{0}, nTimeout{0}, nSkipped{0};
+std::atomic<int64_t> solverTimeNs{0};
+
+/**
+ * Results of queries, keyed by the string form of the query. Results are cheap
+ * to recompute compared to the solving time saved, so simply start over when
+ * full
+ */
+class Z3Cache {
+    std::unordered_map<std::string, bool> results_;
+    size_t bytes_ = 0;
+    std::mutex lock_;
+
+  public:
+    std::optional<bool> lookup(const std::string &key) {
+        if (Config::z3CacheSize() == 0) {
+            return std::nullopt;
+        }
+        std::lock_guard<std::mutex> guard(lock_);
+        if (auto it = results_.find(key); it != results_.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void save(const std::string &key, bool proved) {
+        size_t bytes = key.size() + 64; // Plus rough overhead of a node
+        std::lock_guard<std::mutex> guard(lock_);
+        if (bytes_ + bytes > Config::z3CacheSize()) {
+            results_.clear();
+            bytes_ = 0;
+            if (bytes > Config::z3CacheSize()) {
+                return;
+            }
+        }
+        if (results_.emplace(key, proved).second) {
+            bytes_ += bytes;
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(lock_);
+        results_.clear();
+        bytes_ = 0;
+    }
+
+    std::pair<size_t, size_t> size() {
+        std::lock_guard<std::mutex> guard(lock_);
+        return {results_.size(), bytes_};
+    }
+};
+
+Z3Cache &z3Cache() {
+    static Z3Cache cache;
+    return cache;
+}
+
+} // Anonymous namespace
+
+Z3Stats z3Stats() {
+    Z3Stats ret;
+    ret.nQuery_ = nQuery;
+    ret.nCacheHit_ = nCacheHit;
+    ret.nTimeout_ = nTimeout;
+    ret.nSkipped_ = nSkipped;
+    ret.solverTime_ = solverTimeNs * 1e-9;
+    std::tie(ret.cacheEntries_, ret.cacheBytes_) = z3Cache().size();
+    return ret;
+}
+
+void clearZ3Cache() { z3Cache().clear(); }
+
+Z3Simplify::Z3Simplify()
+    : solver_(ctx_),
+      queryTimeout_(std::min<size_t>(Config::z3QueryTimeout(), UINT_MAX)) {
+    if (auto budget = Config::z3PassBudget(); budget > 0) {
+        budgetLeft_ = budget * 1e-3;
+    }
+}
+
 int Z3Simplify::getVarId(const Expr &op) {
     if (!varId_.count(op)) {
         varId_[op] = varCnt_++;
@@ -42,27 +132,94 @@ const std::vector<std::optional<z3::expr>> &Z3Simplify::conds(const Expr &key) {
 
 bool Z3Simplify::prove(const Expr &op) {
     // expr can be proved <==> !expr can not be satisfied
-    if (exists(op)) {
-        solver_.push();
-        for (auto &&cond : conds(op)) {
-            solver_.add(*cond);
+    if (!exists(op)) {
+        return false;
+    }
+    nQuery++;
+
+    // The query is a conjunction of conditions, which is keyed as a sorted
+    // set, and the expression to prove
+    std::vector<std::string> condKeys;
+    condKeys.reserve(stackKeys_.size() + conds(op).size());
+    for (auto &&key : stackKeys_) {
+        if (!key.empty()) {
+            condKeys.emplace_back(key);
         }
-        auto toCheck = !get(op);
-        auto ret = solver_.check(1, &toCheck) == z3::unsat;
-        solver_.pop();
-        return ret;
     }
-    return false;
+    for (auto &&cond : conds(op)) {
+        condKeys.emplace_back(cond->to_string());
+    }
+    std::sort(condKeys.begin(), condKeys.end());
+    condKeys.erase(std::unique(condKeys.begin(), condKeys.end()),
+                   condKeys.end());
+    std::string key;
+    for (auto &&cond : condKeys) {
+        key += cond;
+        key += '\n';
+    }
+    key += "=> ";
+    key += get(op).to_string();
+    if (auto cached = z3Cache().lookup(key); cached.has_value()) {
+        nCacheHit++;
+        return *cached;
+    }
+
+    unsigned timeout = queryTimeout_;
+    if (budgetLeft_.has_value()) {
+        if (*budgetLeft_ <= 0) {
+            nSkipped++;
+            return false;
+        }
+        auto left = (unsigned)std::ceil(*budgetLeft_ * 1e3);
+        timeout = timeout == 0 ? left : std::min(timeout, left);
+    }
+    if (timeout != curTimeout_) { // Only if limited
+        z3::params params(ctx_);
+        params.set("timeout", timeout);
+        solver_.set(params);
+        curTimeout_ = timeout;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    solver_.push();
+    for (auto &&cond : conds(op)) {
+        solver_.add(*cond);
+    }
+    auto toCheck = !get(op);
+    auto result = solver_.check(1, &toCheck);
+    solver_.pop();
+    std::chrono::nanoseconds elapsed =
+        std::chrono::steady_clock::now() - begin;
+    solverTimeNs += elapsed.count();
+    if (budgetLeft_.has_value()) {
+        *budgetLeft_ -= std::chrono::duration<double>(elapsed).count();
+    }
+
+    if (result == z3::unknown) {
+        // Timed out or gave up. Prove nothing, and do not cache it, since it
+        // may be solved with a larger budget
+        nTimeout++;
+        return false;
+    }
+    bool ret = result == z3::unsat;
+    z3Cache().save(key, ret);
+    return ret;
 }
 
 void Z3Simplify::push(const Expr &op) {
     solver_.push();
     if (exists(op)) {
         solver_.add(get(op));
+        stackKeys_.emplace_back(get(op).to_string());
+    } else {
+        stackKeys_.emplace_back();
     }
 }
 
-void Z3Simplify::pop() { solver_.pop(); }
+void Z3Simplify::pop() {
+    solver_.pop();
+    stackKeys_.pop_back();
+}
 
 Expr Z3Simplify::visit(const Var &_op) {
     auto __op = BaseClass::visit(_op);
@@ -81,7 +238,9 @@ Expr Z3Simplify::visit(const Load &_op) {
     if (isInt(dtype)) {
         expr = ctx_.int_const(("x" + std::to_string(getVarId(op))).c_str());
     } else if (isBool(dtype)) {
-        expr = ctx_.bool_const(("x" + std::to_string(getVarId(op))).c_str());
+        // Named differently from integers, so the string form of a query
+        // determines the sorts, which is required by the cache
+        expr = ctx_.bool_const(("p" + std::to_string(getVarId(op))).c_str());
     } else {
         return op;
         // We don't simplify float in Z3Simplify
@@ -33,6 +33,7 @@
 #include <schedule/var_merge.h>
 #include <schedule/var_reorder.h>
 #include <schedule/vectorize.h>
+#include <serialize/load_ast.h>
 
 namespace freetensor {
 
@@ -46,6 +47,7 @@ Stmt Schedule::quickOptimizations(const Stmt &_ast) {
 
 Schedule::Schedule(const Stmt &ast, int verbose)
     : verbose_(verbose), memoized_(Ref<MemoizedSchedules>::make()),
+      depsCache_(Ref<DepsCache>::make()),
       rng_(Ref<OpenMPRandomEngine>::make(0)) /* TODO: set seed */,
       randCtx_(Ref<RandCtx<OpenMPRandomEngine>>::make(*rng_)) {
     openTrans_.emplace_back(quickOptimizations(clearMarkVersion(ast)),
@@ -93,7 +95,20 @@ void Schedule::setLogs(const ScheduleLog &logs) {
 }
 
 void Schedule::autoSchedule(const Ref<Target> &target,
-                            const Ref<RandTrace> &trace) {
+                            const Ref<RandTrace> &trace,
+                            const Ref<TuningRecordDB> &records) {
+    if (records.isValid()) {
+        if (auto best =
+                records->best(TuningRecordDB::workloadKey(ast(), target));
+            best.has_value()) {
+            if (verbose_ >= 1) {
+                logger() << "Applying a tuning record of time " << best->time
+                         << std::endl;
+            }
+            applyTuningRecord(*best);
+            return;
+        }
+    }
     autoUseLib(target);
     autoFissionFuse(target, trace);
     autoReorder(target);
@@ -102,6 +117,10 @@ void Schedule::autoSchedule(const Ref<Target> &target,
     autoUnroll(target);
 }
 
+void Schedule::applyTuningRecord(const TuningRecord &record) {
+    setAst(loadAST(record.ast).as<StmtNode>());
+}
+
 std::vector<AutoScheduleTuneTrial> Schedule::tuneAutoSchedule(
     int nBatch, int batchSize, const Ref<Device> &device,
     const std::vector<Ref<Array>> &args,
@@ -126,7 +145,8 @@ std::vector<AutoScheduleTuneTrial> Schedule::tuneAutoSchedule(
                     s.autoSchedule(device->target(), trace);
                     lowered = lower(s.func(), device->target());
                     code = codeGen(lowered, device->target());
-                    drivers[j] = Ref<Driver>::make(lowered, code, device);
+                    drivers[j] = Ref<Driver>::make(lowered, code, device,
+                                                   false, true);
                 },
                 omp_sched_static); // use schedule(static) to guarantee
                                    // deterministic RNG
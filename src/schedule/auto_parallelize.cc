@@ -218,6 +218,13 @@ void Schedule::autoParallelize(const Ref<Target> &target) {
             }
         }
     };
+    // An outer loop is too short if it cannot keep all the hardware threads
+    // busy
+    int64_t minOuterLen = 32;
+    if (target->type() == TargetType::CPU) {
+        minOuterLen = std::max<int64_t>(
+            minOuterLen, target.as<CPUTarget>()->hardwareThreads());
+    }
     for (auto &&_root : findAll("<For><-(!<For><-)*<-|")) {
         // Suppose the root node is not <For>. It should be <VarDef>
         auto root = _root.as<ForNode>();
@@ -227,7 +234,7 @@ void Schedule::autoParallelize(const Ref<Target> &target) {
                 findAll("<For><-(!<For><-)*" + toString(root->id()));
             inners.size() > 1 &&
             root->len_->nodeType() == ASTNodeType::IntConst &&
-            root->len_.as<IntConstNode>()->val_ < 32) {
+            root->len_.as<IntConstNode>()->val_ < minOuterLen) {
             for (auto &&inner : inners) {
                 autoParallelizeOuter(inner.as<ForNode>());
             }
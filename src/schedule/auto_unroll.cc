@@ -28,13 +28,20 @@ void Schedule::autoUnroll(const Ref<Target> &target) {
         }
     }
 
-    // Unroll very short loops
+    // Unroll very short loops. On CPUs, a loop is short if the values of all
+    // its iterations can be held in a quarter of the SIMD registers, leaving
+    // the rest for the loop body
+    int64_t maxLen = 4;
+    if (target->type() == TargetType::CPU) {
+        maxLen = std::max<int64_t>(
+            maxLen, target.as<CPUTarget>()->vectorRegisters() / 4);
+    }
     for (auto &&_loop : findAll("<For>")) {
         auto loop = _loop.as<ForNode>();
         if (loop->property_->parallel_ == serialScope &&
             !loop->property_->vectorize_ && !loop->property_->unroll_ &&
             loop->len_->nodeType() == ASTNodeType::IntConst &&
-            loop->len_.as<IntConstNode>()->val_ <= 4) {
+            loop->len_.as<IntConstNode>()->val_ <= maxLen) {
             unroll(loop->id());
         }
     }
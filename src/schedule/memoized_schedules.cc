@@ -0,0 +1,111 @@
+#include <config.h>
+#include <schedule/memoized_schedules.h>
+#include <visitor.h>
+
+namespace freetensor {
+
+namespace {
+
+/**
+ * Roughly estimate the memory of an AST from its number of nodes
+ */
+class EstimateBytes : public Visitor {
+    size_t bytes_ = 0;
+
+  public:
+    size_t bytes() const { return bytes_; }
+
+  protected:
+    void visitStmt(const Stmt &op) override {
+        bytes_ += 256; // Node, ID, metadata and debug info
+        Visitor::visitStmt(op);
+    }
+
+    void visitExpr(const Expr &op) override {
+        bytes_ += 96;
+        Visitor::visitExpr(op);
+    }
+};
+
+size_t estimateBytes(const ScheduleLog &log) {
+    size_t bytes = 128; // The log item and the list node
+    if (auto &&ast = log.top()->resultAST(); ast.isValid()) {
+        EstimateBytes visitor;
+        visitor(ast);
+        bytes += visitor.bytes();
+    }
+    return bytes;
+}
+
+} // Anonymous namespace
+
+void MemoizedSchedules::evict(Shard &shard, size_t maxBytes) {
+    for (auto it = shard.lru_.end();
+         shard.bytes_ > maxBytes && it != shard.lru_.begin();) {
+        --it;
+        // Other logs may still refer to this log as their prefix, so release
+        // its result explicitly. A result still in use can not be released
+        // yet, so keep it indexed and accounted, and try again in a later
+        // eviction, instead of losing track of its memory
+        if (it->log_.top()->releaseResult(it->log_.top())) {
+            shard.bytes_ -= it->bytes_;
+            shard.index_.erase(it->log_);
+            it = shard.lru_.erase(it);
+        }
+    }
+}
+
+ScheduleLog MemoizedSchedules::lookupOrCreate(const ScheduleLog &log) {
+    auto &&s = shard(log);
+    std::lock_guard<std::mutex> guard(s.lock_);
+    if (auto it = s.index_.find(log); it != s.index_.end()) {
+        s.lru_.splice(s.lru_.begin(), s.lru_, it->second);
+        return it->second->log_;
+    } else {
+        s.lru_.emplace_front(Entry{log, 0});
+        s.index_.emplace(log, s.lru_.begin());
+        return log;
+    }
+}
+
+void MemoizedSchedules::replace(const ScheduleLog &log) {
+    auto &&s = shard(log);
+    std::lock_guard<std::mutex> guard(s.lock_);
+    if (auto it = s.index_.find(log); it != s.index_.end()) {
+        s.bytes_ -= it->second->bytes_;
+        s.lru_.erase(it->second);
+        s.index_.erase(it);
+    }
+    s.lru_.emplace_front(Entry{log, 0});
+    s.index_.emplace(log, s.lru_.begin());
+}
+
+void MemoizedSchedules::account(const ScheduleLog &log) {
+    auto &&s = shard(log);
+    {
+        std::lock_guard<std::mutex> guard(s.lock_);
+        auto it = s.index_.find(log);
+        if (it == s.index_.end() || it->second->bytes_ > 0) {
+            return; // Evicted, or already accounted
+        }
+    }
+    auto bytes = estimateBytes(log); // Out of the lock
+    std::lock_guard<std::mutex> guard(s.lock_);
+    if (auto it = s.index_.find(log);
+        it != s.index_.end() && it->second->bytes_ == 0) {
+        it->second->bytes_ = bytes;
+        s.bytes_ += bytes;
+        evict(s, Config::memoizedSchedulesSize() / N_SHARDS);
+    }
+}
+
+size_t MemoizedSchedules::bytes() {
+    size_t ret = 0;
+    for (auto &&s : shards_) {
+        std::lock_guard<std::mutex> guard(s.lock_);
+        ret += s.bytes_;
+    }
+    return ret;
+}
+
+} // namespace freetensor
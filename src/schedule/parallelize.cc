@@ -94,7 +94,8 @@ Stmt parallelize(const Stmt &_ast, const ID &loop,
         FindDeps()
             .direction(
                 {{{NodeIDOrParallelScope(parallel), DepDirection::Different}}})
-            .filter(filter)(ast, found);
+            .filter(filter)
+            .cacheTag("parallelize " + toString(loop))(ast, found);
     }
     return ast;
 }
@@ -0,0 +1,104 @@
+#include <algorithm>
+
+#include <container_utils.h>
+#include <pass/flatten_stmt_seq.h>
+#include <pass/sink_var.h>
+#include <schedule.h>
+#include <schedule/hoist_selected_var.h>
+#include <schedule/parallelize.h>
+#include <schedule/parallelize_as_tasks.h>
+
+namespace freetensor {
+
+Stmt ParallelizeAsTasks::visit(const StmtSeq &_op) {
+    auto __op = Mutator::visit(_op);
+    ASSERT(__op->nodeType() == ASTNodeType::StmtSeq);
+    auto op = __op.as<StmtSeqNode>();
+
+    std::vector<size_t> pos;
+    for (auto &&id : stmts_) {
+        auto it = std::find_if(op->stmts_.begin(), op->stmts_.end(),
+                               [&](const Stmt &s) { return s->id() == id; });
+        if (it == op->stmts_.end()) {
+            return op;
+        }
+        pos.emplace_back(it - op->stmts_.begin());
+    }
+    std::sort(pos.begin(), pos.end());
+    for (size_t i = 1, n = pos.size(); i < n; i++) {
+        if (pos[i] != pos[0] + i) {
+            return op;
+        }
+    }
+
+    // Each task is an iteration of a new loop. The tasks are dispatched by an
+    // if-else chain, so no pass peels the first or the last task off the loop
+    // (see `pass/move_out_first_or_last_iter`)
+    loop_ = ID::make();
+    auto iter = "__task_" + toString(loop_);
+    std::vector<Metadata> sources;
+    for (auto p : pos) {
+        auto &&task = op->stmts_[p];
+        sources.emplace_back(task->metadata().isValid()
+                                 ? task->metadata()
+                                 : Metadata(makeMetadata(task->id())));
+    }
+    Stmt body = op->stmts_[pos.back()];
+    for (int i = (int)pos.size() - 2; i >= 0; i--) {
+        body = makeIf(makeEQ(makeVar(iter), makeIntConst(i)),
+                      op->stmts_[pos[i]], body);
+    }
+    auto len = makeIntConst(pos.size());
+    auto loop = makeFor(iter, makeIntConst(0), len, makeIntConst(1), len,
+                        Ref<ForProperty>::make(), body,
+                        makeMetadata("parallelize_as_tasks", sources), loop_);
+
+    std::vector<Stmt> stmts(op->stmts_.begin(), op->stmts_.begin() + pos[0]);
+    stmts.emplace_back(loop);
+    stmts.insert(stmts.end(), op->stmts_.begin() + pos.back() + 1,
+                 op->stmts_.end());
+    return makeStmtSeq(std::move(stmts), op->metadata(), op->id());
+}
+
+std::pair<Stmt, ID> parallelizeAsTasks(const Stmt &_ast,
+                                       const std::vector<ID> &stmts) {
+    if (stmts.size() < 2) {
+        throw InvalidSchedule("At least 2 statements are required");
+    }
+
+    // Hoist all VarDef nodes covering any of the statement but not covering
+    // some other statements, to cover all statements
+    auto insides = stmts | views::transform([](const ID &id) {
+                       return "->>" + toString(id);
+                   });
+    auto allIn = insides | join("&");
+    auto anyIn = insides | join("|");
+    auto ast = hoistSelectedVar(_ast, "(" + anyIn + ")&!(" + allIn + ")");
+    ast = flattenStmtSeq(ast);
+
+    ParallelizeAsTasks mutator(stmts);
+    ast = mutator(ast);
+    if (!mutator.loop().isValid()) {
+        throw InvalidSchedule("Statements not found or not consecutive");
+    }
+
+    // Independence of the tasks is checked as for any parallel loop
+    ast = parallelize(ast, mutator.loop(), OpenMPTaskScope{});
+    return {sinkVar(ast), mutator.loop()};
+}
+
+ID Schedule::parallelizeAsTasks(const std::vector<ID> &stmts) {
+    beginTransaction();
+    auto log = appendLog(MAKE_SCHEDULE_LOG(
+        ParallelizeAsTasks, freetensor::parallelizeAsTasks, stmts));
+    try {
+        auto ret = applyLog(log);
+        commitTransaction();
+        return ret;
+    } catch (const InvalidSchedule &e) {
+        abortTransaction();
+        throw InvalidSchedule(log, ast(), e.what());
+    }
+}
+
+} // namespace freetensor
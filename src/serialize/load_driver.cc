@@ -1,11 +1,26 @@
 #include <config.h>
+#include <serialize/load_ast.h>
 #include <serialize/load_driver.h>
 
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
 namespace freetensor {
+
+// Serialized data may come from anywhere, so malformed input is reported as a
+// `DriverError` naming the bad field, instead of an internal assertion failure
+[[noreturn]] static void malformed(const std::string &field) {
+    throw DriverError("Malformed serialized data: invalid or missing " + field);
+}
+
+static void check(bool cond, const std::string &field) {
+    if (!cond) {
+        malformed(field);
+    }
+}
+
 Ref<Target> loadTarget(const std::string &txt, const std::string &data) {
 
     std::istringstream iss(txt);
@@ -13,22 +28,54 @@ Ref<Target> loadTarget(const std::string &txt, const std::string &data) {
     std::string type;
     bool useNativeArch;
 
-    ASSERT(iss >> type >> useNativeArch);
-    ASSERT(type.length() > 0);
+    check(bool(iss >> type), "target type");
+    check(bool(iss >> useNativeArch), "target useNativeArch");
 
     switch (type[0]) {
 #ifdef FT_WITH_CUDA
     case 'G': {
+        check(data.size() >= sizeof(cudaDeviceProp), "GPU target properties");
         auto deviceProp = Ref<cudaDeviceProp>::make();
         memcpy(&(*deviceProp), data.c_str(), sizeof(cudaDeviceProp));
         return Ref<GPUTarget>::make(deviceProp);
     }
 #endif // FT_WITH_CUDA
     case 'C': {
-        return Ref<CPUTarget>::make(useNativeArch);
+        auto ret = Ref<CPUTarget>::make(useNativeArch);
+        // Parameters are absent in data dumped by older versions, where the
+        // detected ones are kept
+        size_t l1, l2, l3;
+        int lineSize, cores, threadsPerCore, numaNodes;
+        std::string isa;
+        if (iss >> l1 >> l2 >> l3 >> lineSize >> isa >> cores >>
+            threadsPerCore >> numaNodes) {
+            ret->setL1DataCacheSize(l1);
+            ret->setL2CacheSize(l2);
+            ret->setL3CacheSize(l3);
+            try {
+                ret->setISA(isa);
+            } catch (const Error &) {
+                malformed("CPU target ISA " + isa);
+            }
+            try {
+                ret->setCacheLineSize(lineSize);
+                ret->setPhysicalCores(cores);
+                ret->setThreadsPerCore(threadsPerCore);
+                ret->setNUMANodes(numaNodes);
+            } catch (const Error &) {
+                malformed("CPU target cache line size or topology");
+            }
+        }
+        if (bool useThreadPool; iss >> useThreadPool) {
+            ret->setUseThreadPool(useThreadPool);
+        }
+        if (bool useNativeGEMM; iss >> useNativeGEMM) {
+            ret->setUseNativeGEMM(useNativeGEMM);
+        }
+        return ret;
     }
     default:
-        ASSERT(false);
+        malformed("target type " + type);
     }
 }
 
@@ -44,17 +91,20 @@ Ref<Device> loadDevice(const std::string &txt, const std::string &data) {
     std::string type;
     size_t num;
 
-    ASSERT(iss >> type >> num);
-    ASSERT(type.length() > 0);
+    check(bool(iss >> type), "device type");
+    check(bool(iss >> num), "device number");
 
     switch (type[0]) {
-    case 'D':
+    case 'D': {
         // `DEV <Num> <Target>` : find a space after `<Num>`
-        ret = Ref<Device>::make(
-            loadTarget(txt.substr(txt.find(' ', 4)), data)->type(), num);
+        auto pos = txt.find(' ', 4);
+        check(pos != std::string::npos, "device target");
+        ret = Ref<Device>::make(loadTarget(txt.substr(pos), data)->type(),
+                                num);
         break;
+    }
     default:
-        ASSERT(false);
+        malformed("device type " + type);
     }
     return ret;
 }
@@ -62,15 +112,21 @@ Ref<Device> loadDevice(const std::string &txt, const std::string &data) {
 Ref<Array> newArray(const std::vector<size_t> &shape_,
                     const std::string &dtypestr_, const std::string &data_) {
 
-    DataType dtype = parseDType(dtypestr_);
+    DataType dtype;
+    try {
+        dtype = parseDType(dtypestr_);
+    } catch (const Error &) {
+        malformed("array dtype " + dtypestr_);
+    }
     size_t siz = sizeOf(dtype);
 
     for (auto len : shape_) {
+        check(len == 0 || siz <= data_.length() / len, "array shape");
         siz *= len;
     }
 
     // Data form: uint8_t
-    ASSERT(data_.length() == siz);
+    check(data_.length() == siz, "array data");
 
     uint8_t *addr = new uint8_t[siz];
     memcpy(addr, (uint8_t *)data_.c_str(), siz);
@@ -92,15 +148,17 @@ Ref<Array> loadArray(const std::string &txt, const std::string &data) {
     std::vector<size_t> shape;
 
     // `ARR <dtype> <shape.size>`
-    ASSERT(iss >> type >> dtype >> len);
-    ASSERT(type.length() > 0);
+    check(bool(iss >> type), "array type");
+    check(bool(iss >> dtype), "array dtype");
+    check(bool(iss >> len), "array ndim");
 
     switch (type[0]) {
     case 'A': {
 
-        shape.resize(len);
         for (size_t i = 0; i < len; i++) {
-            ASSERT(iss >> shape[i]);
+            size_t dim;
+            check(bool(iss >> dim), "array shape[" + std::to_string(i) + "]");
+            shape.emplace_back(dim);
         }
 
         ret = newArray(shape, dtype, data);
@@ -109,9 +167,70 @@ Ref<Array> loadArray(const std::string &txt, const std::string &data) {
     }
 
     default:
-        ASSERT(false);
+        malformed("array type " + type);
     }
     return ret;
 }
 
+Ref<Driver> loadDriver(const std::string &txt, const std::string &data) {
+
+    /**
+     * `DRV <Version> <Entry> <ASTLen> <SrcLen> <BinaryLen> <Device>`
+     */
+    std::istringstream iss(txt);
+
+    std::string type, entry;
+    int version;
+    size_t astLen, srcLen, binaryLen;
+
+    check(bool(iss >> type), "program type");
+    if (type != "DRV") {
+        throw DriverError("Not an exported program");
+    }
+    check(bool(iss >> version), "program version");
+    if (version != DRIVER_FORMAT_VERSION) {
+        throw DriverError("Unsupported version " + std::to_string(version) +
+                          " of an exported program. Expected version " +
+                          std::to_string(DRIVER_FORMAT_VERSION));
+    }
+    check(bool(iss >> entry), "program entry");
+    check(bool(iss >> astLen), "program AST length");
+    check(bool(iss >> srcLen), "program source length");
+    check(bool(iss >> binaryLen), "program binary length");
+    if (astLen > data.size() || srcLen > data.size() - astLen ||
+        binaryLen > data.size() - astLen - srcLen) {
+        throw DriverError("Truncated exported program");
+    }
+    std::string deviceMeta;
+    std::getline(iss >> std::ws, deviceMeta);
+
+    auto func = loadAST(data.substr(0, astLen));
+    if (!func.isValid() || func->nodeType() != ASTNodeType::Func) {
+        throw DriverError("Invalid function in an exported program");
+    }
+    auto src = data.substr(astLen, srcLen);
+    auto binary = CompiledObject::fromBytes(
+        data.substr(astLen + srcLen, binaryLen));
+    auto device =
+        loadDevice(deviceMeta, data.substr(astLen + srcLen + binaryLen));
+    auto hostDevice = device->type() == TargetType::CPU
+                          ? device
+                          : Ref<Device>::make(TargetType::CPU);
+
+    return Ref<Driver>::make(func.as<FuncNode>(), src, binary, device,
+                             hostDevice, entry);
+}
+
+Ref<Driver> importDriver(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        throw DriverError("Unable to open " + path);
+    }
+    std::string meta;
+    std::getline(f, meta);
+    std::ostringstream data;
+    data << f.rdbuf();
+    return loadDriver(meta, data.str());
+}
+
 } // namespace freetensor
@@ -1,5 +1,7 @@
 #include <config.h>
 #include <cstring>
+#include <fstream>
+#include <serialize/print_ast.h>
 #include <serialize/print_driver.h>
 
 namespace freetensor {
@@ -23,8 +25,20 @@ std::pair<std::string, std::string> dumpTarget(const Ref<Target> &target_) {
         break;
     }
 #endif // FT_WITH_CUDA
-    case TargetType::CPU:
+    case TargetType::CPU: {
+        // Append the detected or configured parameters to the meta data
+        auto &&tmp = target.as<CPUTarget>();
+        ret_meta += " " + std::to_string(tmp->l1DataCacheSize()) + " " +
+                    std::to_string(tmp->l2CacheSize()) + " " +
+                    std::to_string(tmp->l3CacheSize()) + " " +
+                    std::to_string(tmp->cacheLineSize()) + " " + tmp->isa() +
+                    " " + std::to_string(tmp->physicalCores()) + " " +
+                    std::to_string(tmp->threadsPerCore()) + " " +
+                    std::to_string(tmp->numaNodes()) + " " +
+                    std::to_string(tmp->useThreadPool()) + " " +
+                    std::to_string(tmp->useNativeGEMM());
         break;
+    }
 
     default:
         ASSERT(false);
@@ -80,4 +94,60 @@ std::pair<std::string, std::string> dumpArray(const Ref<Array> &array_) {
     return std::make_pair(ret_meta, ret_data);
 }
 
+std::pair<std::string, std::string> dumpDriver(const Ref<Driver> &driver) {
+
+    /**
+     * The string is constructed as follow (Separated by space):
+     *
+     * MetaData:
+     * {"DRV"} + {format version} + {entry} +
+     * {AST length} + {source length} + {binary length} +
+     * {device metadata}
+     *
+     * Data:
+     * {AST} + {source} + {binary} + {device data}
+     */
+    ASSERT(driver.isValid());
+
+    auto &&func = driver->func();
+    for (auto &&param : func->params_) {
+        if (param.isInClosure()) {
+            throw DriverError("Unable to export a function with closure "
+                              "parameter " +
+                              param.name_);
+        }
+    }
+    for (auto &&ret : func->returns_) {
+        if (ret.isInClosure()) {
+            throw DriverError("Unable to export a function with closure "
+                              "return value " +
+                              ret.name_);
+        }
+    }
+
+    auto ast = dumpAST(func, true);
+    auto &&src = driver->src();
+    auto binary = driver->binary()->bytes();
+    auto &&[device_meta, device_data] = dumpDevice(driver->device());
+
+    std::string ret_meta = "DRV " + std::to_string(DRIVER_FORMAT_VERSION) +
+                           " " + driver->entry() + " " +
+                           std::to_string(ast.size()) + " " +
+                           std::to_string(src.size()) + " " +
+                           std::to_string(binary.size()) + " " + device_meta;
+    std::string ret_data = ast + src + binary + device_data;
+
+    return std::make_pair(ret_meta, ret_data);
+}
+
+void exportDriver(const Ref<Driver> &driver, const std::string &path) {
+    auto &&[meta, data] = dumpDriver(driver);
+    std::ofstream f(path, std::ios::binary);
+    f << meta << '\n';
+    f.write(data.data(), data.size());
+    if (!f.good()) {
+        throw DriverError("Unable to write " + path);
+    }
+}
+
 } // namespace freetensor
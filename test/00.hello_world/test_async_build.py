@@ -0,0 +1,36 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def test_async_build():
+    with ft.VarDef("x", (4,), "int32", "inout") as x:
+        with ft.For("i", 0, 4) as i:
+            x[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()), verbose=1)
+    code = ft.codegen(func, verbose=True)
+
+    driver = ft.build_binary(code, async_build=True)
+    driver.wait()
+    assert driver.is_ready()
+
+    x_arr = ft.Array(np.zeros((4,), dtype="int32"))
+    driver(x=x_arr)
+    assert np.array_equal(x_arr.numpy(), np.array([1, 1, 1, 1]))
+
+
+def test_async_build_identical_sources():
+    with ft.VarDef("x", (4,), "int32", "inout") as x:
+        with ft.For("i", 0, 4) as i:
+            x[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()), verbose=1)
+    code = ft.codegen(func, verbose=True)
+
+    # Identical sources in flight share one compiling job, but each Driver
+    # still loads its own copy of the program
+    drivers = [ft.build_binary(code, async_build=True) for _ in range(4)]
+    x_arrs = [ft.Array(np.zeros((4,), dtype="int32")) for _ in range(4)]
+    for driver, x_arr in zip(drivers, x_arrs):
+        driver(x=x_arr)  # Implicitly wait
+    for x_arr in x_arrs:
+        assert np.array_equal(x_arr.numpy(), np.array([1, 1, 1, 1]))
@@ -0,0 +1,37 @@
+import freetensor as ft
+import numpy as np
+import pytest
+
+
+def _build():
+    with ft.VarDef("x", (1024,), "float32", "inout") as x:
+        with ft.For("i", 0, 1024) as i:
+            x[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()), verbose=1)
+    return ft.build_binary(ft.codegen(func, verbose=True))
+
+
+def test_benchmark():
+    driver = _build()
+    driver.set_args(x=ft.Array(np.zeros((1024,), dtype="float32")))
+    result = driver.benchmark(min_rounds=10, max_rounds=50)
+    assert 10 <= len(result.samples) <= 50
+    assert result.samples == sorted(result.samples)
+    assert result.min() <= result.median() <= result.percentile(90)
+    assert result.avg > 0
+    assert not result.aborted
+
+
+def test_benchmark_abort():
+    driver = _build()
+    driver.set_args(x=ft.Array(np.zeros((1024,), dtype="float32")))
+    result = driver.benchmark(abort_threshold=0, max_rounds=1000)
+    assert result.aborted
+    assert len(result.samples) < 1000
+
+
+def test_benchmark_flush_cache_and_pin_cpu():
+    driver = _build()
+    driver.set_args(x=ft.Array(np.zeros((1024,), dtype="float32")))
+    result = driver.benchmark(flush_cache=True, pin_cpu=0, max_rounds=10)
+    assert len(result.samples) >= 5
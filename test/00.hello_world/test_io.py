@@ -161,3 +161,58 @@ def test_torch_cuda_explicitly_copy_from_other_device():
         assert y.is_cuda
         assert torch.all(
             y == torch.tensor([[1, 2], [3, 4]], dtype=torch.int32).cuda())
+
+
+def test_set_arg_by_index():
+
+    @ft.optimize
+    def test(x: ft.Var[(4,), "int32"], y: ft.Var[(4,), "int32", "output"]):
+        for i in range(4):
+            y[i] = x[i] * 2
+
+    ix = test.param_index("x")
+    y = ft.Array(np.zeros((4,), dtype="int32"))
+    test.set_args(x=np.zeros((4,), dtype="int32"), y=y)
+    for k in range(3):
+        test.set_arg(ix, np.full((4,), k, dtype="int32"))
+        test.run()
+        test.collect_returns(keep_args=True)
+        assert np.array_equal(y.numpy(), np.full((4,), 2 * k,
+                                                 dtype="int32"))
+
+
+def test_set_arg_wrong_shape():
+
+    @ft.optimize
+    def test(x: ft.Var[(4,), "int32"], y: ft.Var[(4,), "int32", "output"]):
+        for i in range(4):
+            y[i] = x[i] * 2
+
+    with pytest.raises(ft.DriverError):
+        test.set_arg("x", np.zeros((5,), dtype="int32"))
+    with pytest.raises(ft.DriverError):
+        test.set_arg("x", np.zeros((4,), dtype="float32"))
+
+
+def test_return_from_array_pool():
+
+    @ft.optimize
+    def test(x: ft.Var[(1000,), "float32"]):
+        y = ft.empty((1000,), "float32")
+        for i in range(1000):
+            y[i] = x[i] + 1
+        return y
+
+    x = np.random.rand(1000).astype("float32")
+    test(x)  # The returned buffer is freed to the pool
+
+    old_stats = ft.array_pool_stats()
+    for _ in range(10):
+        y = test(x)
+        y_np = y.numpy()
+        assert y_np.ctypes.data % ft.array_alignment() == 0
+        assert np.allclose(y_np, x + 1)
+        del y, y_np
+    new_stats = ft.array_pool_stats()
+    assert new_stats["n_hit"] - old_stats["n_hit"] >= 10
+    assert new_stats["n_miss"] == old_stats["n_miss"]
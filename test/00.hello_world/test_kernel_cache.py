@@ -0,0 +1,97 @@
+import freetensor as ft
+import numpy as np
+import os
+import pytest
+
+
+def test_reuse_cached_kernel(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    try:
+        with ft.VarDef("x", (4,), "int32", "inout") as x:
+            with ft.For("i", 0, 4) as i:
+                x[i] = x[i] + 1
+        func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()), verbose=1)
+        code = ft.codegen(func, verbose=True)
+
+        x_arr = ft.Array(np.zeros((4,), dtype="int32"))
+        ft.build_binary(code)(x=x_arr)
+        entries = [e for e in os.listdir(tmp_path) if not e.startswith('.')]
+        assert len(entries) == 1
+
+        # The second build hits the cache, and creates no new entry
+        ft.build_binary(code)(x=x_arr)
+        entries = [e for e in os.listdir(tmp_path) if not e.startswith('.')]
+        assert len(entries) == 1
+
+        assert np.array_equal(x_arr.numpy(), np.array([2, 2, 2, 2]))
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+
+
+def test_evict_kernel_cache(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    old_size = ft.kernel_cache_size()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    ft.set_kernel_cache_size(1)  # Smaller than any kernel
+    try:
+        for n in range(3):
+            with ft.VarDef("x", (4,), "int32", "inout") as x:
+                with ft.For("i", 0, 4) as i:
+                    x[i] = x[i] + n
+            func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()),
+                            verbose=1)
+            ft.build_binary(ft.codegen(func, verbose=True))
+        entries = [e for e in os.listdir(tmp_path) if not e.startswith('.')]
+        assert len(entries) == 0
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+        ft.set_kernel_cache_size(old_size)
+
+
+def test_kernel_cache_running_size(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    try:
+        for n in range(3):
+            with ft.VarDef("x", (4,), "int32", "inout") as x:
+                with ft.For("i", 0, 4) as i:
+                    x[i] = x[i] + n
+            func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()),
+                            verbose=1)
+            ft.build_binary(ft.codegen(func, verbose=True))
+
+        # The total size is kept on each publish without scanning the cache
+        total = 0
+        for e in os.listdir(tmp_path):
+            if not e.startswith('.'):
+                for f in os.listdir(os.path.join(tmp_path, e)):
+                    total += os.path.getsize(os.path.join(tmp_path, e, f))
+        with open(os.path.join(tmp_path, ".size")) as f:
+            assert int(f.read()) == total
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
+
+
+@pytest.mark.skipif('clang' in ft.backend_compiler_cxx()[0],
+                    reason="Only GCC uses precompiled headers implicitly")
+def test_precompiled_header(tmp_path):
+    old_dir = ft.kernel_cache_dir()
+    ft.set_kernel_cache_dir(str(tmp_path))
+    ft.set_precompiled_header(True)
+    try:
+        with ft.VarDef("x", (4,), "int32", "inout") as x:
+            with ft.For("i", 0, 4) as i:
+                x[i] = x[i] + 1
+        func = ft.lower(ft.Func("main", ["x"], [], ft.pop_ast()), verbose=1)
+        code = ft.codegen(func, verbose=True)
+
+        x_arr = ft.Array(np.zeros((4,), dtype="int32"))
+        ft.build_binary(code)(x=x_arr)
+        assert np.array_equal(x_arr.numpy(), np.array([1, 1, 1, 1]))
+
+        assert any(
+            os.path.exists(os.path.join(tmp_path, e, "cpu_runtime.h.gch"))
+            for e in os.listdir(tmp_path))
+    finally:
+        ft.set_kernel_cache_dir(old_dir)
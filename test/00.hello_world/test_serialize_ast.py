@@ -162,6 +162,25 @@ def test_for_with_parallel():
     assert s.find("foo").property.parallel == ft.ffi.ParallelScope("openmp")
 
 
+def test_for_with_openmp_schedule():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4, label="foo") as i:
+            y[i] = x[i] + 1
+    s = ft.Schedule(ft.pop_ast())
+    s.parallelize("foo", "openmp", schedule="dynamic", chunk=2, num_threads=3)
+    ast = s.ast()
+    txt = ft.dump_ast(ast)
+    print(txt)
+    ast2 = ft.load_ast(txt)
+    print(ast2)
+    assert ast2.match(ast)
+    s = ft.Schedule(ast2)
+    parallel = s.find("foo").property.parallel
+    assert parallel == ft.ffi.OpenMPScope("dynamic", 2, 3)
+    assert parallel != ft.ffi.ParallelScope("openmp")
+
+
 def test_for_with_parallel_reduction():
     with ft.VarDef([("x", (4, 64), "int32", "input", "cpu"),
                     ("y", (4,), "int32", "inout", "cpu")]) as (x, y):
@@ -14,6 +14,44 @@ def test_target_cpu():
     assert target == target2
 
 
+def test_target_cpu_params():
+    target = ft.load_target(ft.dump_target(ft.CPU().target()))
+    target.l1_data_cache_size = 48 << 10
+    target.l2_cache_size = 2 << 20
+    target.l3_cache_size = 0
+    target.cache_line_size = 128
+    target.isa = "avx512"
+    target.physical_cores = 3
+    target.threads_per_core = 2
+    target.numa_nodes = 2
+    assert target.vector_bytes == 64
+    assert target.hardware_threads == 6
+    assert target != ft.CPU().target()
+
+    txt = ft.dump_target(target)
+    print(txt)
+    target2 = ft.load_target(txt)
+    assert target == target2
+    assert target2.l2_cache_size == 2 << 20
+    assert target2.isa == "avx512"
+    assert target2.numa_nodes == 2
+
+
+def test_target_cpu_invalid_params():
+    target = ft.load_target(ft.dump_target(ft.CPU().target()))
+    with pytest.raises(ft.ffi.Error):
+        target.cache_line_size = 96
+    with pytest.raises(ft.ffi.Error):
+        target.cache_line_size = 0
+    with pytest.raises(ft.ffi.Error):
+        target.physical_cores = 0
+    with pytest.raises(ft.ffi.Error):
+        target.threads_per_core = -1
+    with pytest.raises(ft.ffi.Error):
+        target.numa_nodes = 0
+    assert target == ft.CPU().target()  # Unchanged
+
+
 @pytest.mark.skipif(not ft.with_cuda(), reason="requires CUDA")
 def test_target_gpu():
     target = ft.GPU().target()
@@ -62,3 +100,66 @@ def test_array_sizeof8():
     arr2 = ft.load_array(txt)
 
     assert arr == arr2
+
+
+def _build_add_one():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            y[i] = x[i] + 1
+    func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()), ft.CPU())
+    return ft.build_binary(ft.codegen(func, ft.CPU()), ft.CPU())
+
+
+def test_driver():
+    driver = _build_add_one()
+    txt = ft.dump_driver(driver)
+    driver2 = ft.load_driver(txt)
+    assert driver2.native_code() == driver.native_code()
+
+    x = ft.Array(np.array([1, 2, 3, 4], dtype="int32"))
+    y = ft.Array(np.zeros((4,), dtype="int32"))
+    driver2(x, y)
+    assert np.array_equal(y.numpy(), np.array([2, 3, 4, 5]))
+
+
+def test_driver_without_compiler(tmp_path):
+    path = str(tmp_path / "add_one.ftdrv")
+    ft.export_driver(_build_add_one(), path)
+
+    old_cxx = ft.backend_compiler_cxx()
+    ft.set_backend_compiler_cxx(["/nonexistent/c++"])
+    try:
+        driver = ft.import_driver(path)
+        x = ft.Array(np.array([1, 2, 3, 4], dtype="int32"))
+        y = ft.Array(np.zeros((4,), dtype="int32"))
+        driver(x, y)
+        assert np.array_equal(y.numpy(), np.array([2, 3, 4, 5]))
+    finally:
+        ft.set_backend_compiler_cxx(old_cxx)
+
+
+def test_driver_version_mismatch():
+    meta, data = ft.dump_driver(_build_add_one())
+    meta = meta.split(' ')
+    meta[1] = str(int(meta[1]) + 1)
+    with pytest.raises(ft.DriverError):
+        ft.load_driver((' '.join(meta), data))
+
+
+def test_malformed_array():
+    meta, data = ft.dump_array(ft.Array(np.zeros((2, 3), dtype="float32")))
+    # Missing the last dimension
+    with pytest.raises(ft.DriverError, match="shape"):
+        ft.load_array((meta.rsplit(' ', 1)[0], data))
+    # Truncated data
+    with pytest.raises(ft.DriverError, match="data"):
+        ft.load_array((meta, data[:-1]))
+
+
+def test_malformed_driver():
+    meta, data = ft.dump_driver(_build_add_one())
+    meta = meta.split(' ')
+    meta[3] = "not-a-number"
+    with pytest.raises(ft.DriverError, match="AST length"):
+        ft.load_driver((' '.join(meta), data))
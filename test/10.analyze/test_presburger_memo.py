@@ -0,0 +1,57 @@
+import freetensor as ft
+import pytest
+
+
+def make_ast():
+    with ft.VarDef([("x", (8, 8), "int32", "input", "cpu"),
+                    ("y", (8, 8), "int32", "inout", "cpu")]) as (x, y):
+        with ft.For("i", 1, 8, label="L1") as i:
+            with ft.For("j", 0, 8, label="L2") as j:
+                y[i, j] = y[i - 1, j] + x[i, j]
+    return ft.pop_ast()
+
+
+def try_schedules(ast):
+    s = ft.Schedule(ast)
+    with pytest.raises(ft.InvalidSchedule):
+        s.parallelize("L1", "openmp")
+    s.parallelize("L2", "openmp")
+    return s.ast()
+
+
+def test_reuse_across_schedules():
+    ast = make_ast()
+    try_schedules(ast)  # Warm up
+
+    # A new `Schedule` does not share `DepsCache`, so the same problems are
+    # solved again, and found from the memoized results
+    old_stats = ft.presburger_stats()
+    ast1 = try_schedules(ast)
+    new_stats = ft.presburger_stats()
+    assert new_stats["n_memo_hit"] > old_stats["n_memo_hit"]
+    assert new_stats["n_ctx_reuse"] > old_stats["n_ctx_reuse"]
+
+    old_size = ft.pb_memo_size()
+    ft.set_pb_memo_size(0)
+    try:
+        ast2 = try_schedules(ast)
+    finally:
+        ft.set_pb_memo_size(old_size)
+    assert ast1.match(ast2)
+
+
+def test_memory_limit():
+    old_size = ft.pb_memo_size()
+    ft.clear_pb_memo()
+    ft.set_pb_memo_size(16 * 1024)
+    try:
+        for n in range(2, 40):
+            with ft.VarDef("y", (n,), "int32", "inout", "cpu") as y:
+                with ft.For("i", 1, n, label="L1") as i:
+                    y[i] = y[i - 1] + 1
+            s = ft.Schedule(ft.pop_ast())
+            with pytest.raises(ft.InvalidSchedule):
+                s.parallelize("L1", "openmp")
+        assert ft.presburger_stats()["memo_bytes"] <= 16 * 1024
+    finally:
+        ft.set_pb_memo_size(old_size)
@@ -0,0 +1,70 @@
+import freetensor as ft
+import pytest
+
+
+def make_ast():
+    with ft.VarDef([("x", (8, 8), "int32", "input", "cpu"),
+                    ("y", (8, 8), "int32", "output", "cpu"),
+                    ("z", (8,), "int32", "output", "cpu")]) as (x, y, z):
+        with ft.For("i", 0, 8, label="L1") as i:
+            with ft.For("j", 0, 8, label="L2") as j:
+                y[i, j] = x[i, j] * 2
+        with ft.For("i", 0, 8, label="L3") as i:
+            z[i] = 0
+            with ft.For("j", 0, 8, label="L4") as j:
+                z[i] += x[i, j]
+    return ft.pop_ast(verbose=True)
+
+
+@pytest.fixture
+def incremental():
+    old_size = ft.lower_cache_size()
+    ft.clear_lower_cache()
+    ft.set_lower_cache_size(64 << 20)
+    yield
+    ft.set_lower_cache_size(old_size)
+
+
+def test_same_as_whole(incremental):
+    ast = make_ast()
+    ast1 = ft.lower(ast, verbose=1)
+    ft.set_lower_cache_size(0)
+    ast2 = ft.lower(ast, verbose=1)
+    assert ast1.match(ast2)
+
+
+def test_reuse_unchanged_stmts(incremental):
+    ast = make_ast()
+    s1 = ft.Schedule(ast)
+    s2 = s1.fork()
+    s1.split("L4", 2)
+    s2.split("L4", 4)
+
+    ft.lower(s1.ast())
+    old_stats = ft.lower_cache_stats()
+    ast2 = ft.lower(s2.ast(), verbose=1)
+    new_stats = ft.lower_cache_stats()
+    # Only the L3 nest is lowered again
+    assert new_stats["n_hit"] - old_stats["n_hit"] == 1
+    assert new_stats["n_miss"] - old_stats["n_miss"] == 1
+
+    ft.set_lower_cache_size(0)
+    assert ast2.match(ft.lower(s2.ast()))
+
+
+def test_relower_after_mutating_target(incremental):
+    ast = make_ast()
+    target = ft.CPU().target()
+    old_isa = target.isa
+    try:
+        target.isa = "avx512"
+        ft.lower(ast, target)
+        old_stats = ft.lower_cache_stats()
+
+        target.isa = "sse2"
+        ft.lower(ast, target)
+        new_stats = ft.lower_cache_stats()
+    finally:
+        target.isa = old_isa
+    # The target is the same object, but its vector width has changed
+    assert new_stats["n_hit"] == old_stats["n_hit"]
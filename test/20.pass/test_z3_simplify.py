@@ -0,0 +1,67 @@
+import freetensor as ft
+import pytest
+
+
+def make_ast():
+    with ft.VarDef([("n", (), "int32", "input", "cpu"),
+                    ("y", (100,), "int32", "output", "cpu")]) as (n, y):
+        with ft.Assert(n[()] < 100):
+            with ft.For("i", 0, n[()]) as i:
+                with ft.If(i % 4 < 4):
+                    y[i] = 0
+                with ft.If(i + 1 < 100):
+                    y[i] = 1
+    return ft.pop_ast()
+
+
+def make_std():
+    with ft.VarDef([("n", (), "int32", "input", "cpu"),
+                    ("y", (100,), "int32", "output", "cpu")]) as (n, y):
+        with ft.Assert(n[()] < 100):
+            with ft.For("i", 0, n[()]) as i:
+                y[i] = 0
+                y[i] = 1
+    return ft.pop_ast()
+
+
+def test_cache_across_runs():
+    ft.clear_z3_cache()
+    ast = ft.z3_simplify(make_ast())
+    assert make_std().match(ast)
+
+    old_stats = ft.z3_stats()
+    ast = ft.z3_simplify(make_ast())
+    new_stats = ft.z3_stats()
+    assert make_std().match(ast)
+    assert new_stats["n_query"] > old_stats["n_query"]
+    assert new_stats["n_cache_hit"] - old_stats["n_cache_hit"] == new_stats[
+        "n_query"] - old_stats["n_query"]
+    assert new_stats["solver_time"] == old_stats["solver_time"]
+
+
+def test_no_cache():
+    old_size = ft.z3_cache_size()
+    ft.set_z3_cache_size(0)
+    try:
+        old_stats = ft.z3_stats()
+        ast = ft.z3_simplify(make_ast())
+        new_stats = ft.z3_stats()
+    finally:
+        ft.set_z3_cache_size(old_size)
+    assert make_std().match(ast)
+    assert new_stats["n_cache_hit"] == old_stats["n_cache_hit"]
+
+
+def test_exhausted_budget():
+    ft.clear_z3_cache()
+    old_budget = ft.z3_pass_budget()
+    ft.set_z3_pass_budget(1)  # Exhausted at the first query
+    try:
+        old_stats = ft.z3_stats()
+        ast = ft.z3_simplify(make_ast())
+        new_stats = ft.z3_stats()
+    finally:
+        ft.set_z3_pass_budget(old_budget)
+    # Skipped queries prove nothing, and the program is kept as is
+    if new_stats["n_skipped"] == old_stats["n_skipped"]:
+        assert make_std().match(ast)
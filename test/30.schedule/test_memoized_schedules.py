@@ -32,3 +32,56 @@ def test_memoize_failure():
         s2.reorder(["L2", "L1"])
     assert s1.ast().match(ast)  # Should not changed
     assert s2.ast().match(ast)  # Should not changed
+
+
+def test_deps_memoized_across_forks():
+    with ft.VarDef([("x", (4, 8), "int32", "input", "cpu"),
+                    ("y", (4, 8), "int32", "output", "cpu"),
+                    ("z", (8,), "int32", "inout", "cpu")]) as (x, y, z):
+        with ft.For("i", 0, 4, label="L1") as i:
+            with ft.For("j", 0, 8, label="L2") as j:
+                y[i, j] = x[i, j] * 2
+        with ft.For("i", 0, 4, label="L3") as i:
+            with ft.For("j", 0, 8, label="L4") as j:
+                z[j] = z[j] * 2 + x[i, j]
+    ast = ft.pop_ast(verbose=True)
+    s1 = ft.Schedule(ast)
+    s2 = s1.fork()
+
+    # The loop nest of z is unchanged, so its dependences can be reused from
+    # `DepsCache`, but the results must be the same
+    s1.split("L2", 4)
+    with pytest.raises(ft.InvalidSchedule):
+        s1.parallelize("L3", "openmp")
+    s2.parallelize("L1", "openmp")
+    with pytest.raises(ft.InvalidSchedule):
+        s2.parallelize("L3", "openmp")
+    s2.parallelize("L4", "openmp")
+    s1.parallelize("L4", "openmp")
+    openmp = ft.ffi.ParallelScope("openmp")
+    assert s1.find("L3").property.parallel != openmp
+    assert s1.find("L4").property.parallel == openmp
+    assert s2.find("L1").property.parallel == openmp
+    assert s2.find("L3").property.parallel != openmp
+    assert s2.find("L4").property.parallel == openmp
+
+
+def test_evicted_but_still_in_use():
+    with ft.VarDef("y", (8,), "int32", "output", "cpu") as y:
+        with ft.For("i", 0, 8, label="L1") as i:
+            y[i] = i
+    ast = ft.pop_ast(verbose=True)
+    old_size = ft.memoized_schedules_size()
+    ft.set_memoized_schedules_size(0)
+    try:
+        s1 = ft.Schedule(ast)
+        s2 = s1.fork()
+        s1.split("L1", 4)
+        ast1 = s1.ast()
+        s2.split("L1", 4)
+        ast2 = s2.ast()
+    finally:
+        ft.set_memoized_schedules_size(old_size)
+
+    # The result is still in use when evicted, so it is kept for reuse
+    assert ast1 is ast2
@@ -0,0 +1,136 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+
+
+def test_basic():
+
+    @ft.transform
+    def test(x, y1, y2):
+        x: ft.Var[(64,), "int32", "input", "cpu"]
+        y1: ft.Var[(64,), "int32", "output", "cpu"]
+        y2: ft.Var[(), "int32", "inout", "cpu"]
+        #! label: S1
+        for i in range(64):
+            y1[i] = x[i] * 2
+        #! label: S2
+        for i in range(64):
+            y2[()] += x[i]
+
+    s = ft.Schedule(test)
+    s.parallelize_as_tasks(["S1", "S2"])
+    print(s.ast())
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "#pragma omp task" in str(code)
+
+    x_np = np.random.randint(0, 100, (64,)).astype("int32")
+    x_arr = ft.Array(x_np)
+    y1_arr = ft.Array(np.zeros((64,), dtype="int32"))
+    y2_arr = ft.Array(np.zeros((), dtype="int32"))
+    ft.build_binary(code, device)(x=x_arr, y1=y1_arr, y2=y2_arr)
+
+    assert np.array_equal(y1_arr.numpy(), x_np * 2)
+    assert y2_arr.numpy()[()] == np.sum(x_np)
+
+
+def test_parallel_loops_in_tasks():
+
+    @ft.transform
+    def test(x, y1, y2):
+        x: ft.Var[(64, 16), "int32", "input", "cpu"]
+        y1: ft.Var[(64, 16), "int32", "output", "cpu"]
+        y2: ft.Var[(64, 16), "int32", "output", "cpu"]
+        #! label: S1
+        for i in range(64):
+            t = ft.empty((16,), "int32", "cpu")
+            for j in range(16):
+                t[j] = x[i, j] * 2
+            for j in range(16):
+                y1[i, j] = t[15 - j]
+        #! label: S2
+        for i in range(64):
+            t = ft.empty((16,), "int32", "cpu")
+            for j in range(16):
+                t[j] = x[i, j] + 1
+            for j in range(16):
+                y2[i, j] = t[15 - j]
+
+    s = ft.Schedule(test)
+    s.parallelize("S1", "openmp")
+    s.parallelize("S2", "openmp")
+    s.parallelize_as_tasks(["S1", "S2"])
+    print(s.ast())
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # The inner loops run serially in each task, each of which owns its slot of
+    # the thread stacks
+    assert "#pragma omp parallel for" not in str(code)
+
+    x_np = np.random.randint(0, 100, (64, 16)).astype("int32")
+    x_arr = ft.Array(x_np)
+    y1_arr = ft.Array(np.zeros((64, 16), dtype="int32"))
+    y2_arr = ft.Array(np.zeros((64, 16), dtype="int32"))
+    ft.build_binary(code, device)(x=x_arr, y1=y1_arr, y2=y2_arr)
+
+    assert np.array_equal(y1_arr.numpy(), (x_np * 2)[:, ::-1])
+    assert np.array_equal(y2_arr.numpy(), (x_np + 1)[:, ::-1])
+
+
+def test_loop_property():
+    with ft.VarDef([
+        ("y1", (4,), "int32", "output", "cpu"),
+        ("y2", (4,), "int32", "output", "cpu"),
+        ("y3", (4,), "int32", "output", "cpu"),
+    ]) as (y1, y2, y3):
+        with ft.For("i", 0, 4, label="L1") as i:
+            y1[i] = i + 1
+        with ft.For("i", 0, 4, label="L2") as i:
+            y2[i] = i + 2
+        with ft.For("i", 0, 4, label="L3") as i:
+            y3[i] = i + 3
+    ast = ft.pop_ast(verbose=True)
+    s = ft.Schedule(ast)
+    loop = s.parallelize_as_tasks(["L2", "L1"])
+    print(s.ast())
+    assert s.find(loop).property.parallel == ft.ffi.ParallelScope(
+        "openmp_task")
+    assert str(s.find(loop).len) == "2"
+
+
+def test_not_consecutive():
+    with ft.VarDef([
+        ("y1", (4,), "int32", "output", "cpu"),
+        ("y2", (4,), "int32", "output", "cpu"),
+        ("y3", (4,), "int32", "output", "cpu"),
+    ]) as (y1, y2, y3):
+        with ft.For("i", 0, 4, label="L1") as i:
+            y1[i] = i + 1
+        with ft.For("i", 0, 4, label="L2") as i:
+            y2[i] = i + 2
+        with ft.For("i", 0, 4, label="L3") as i:
+            y3[i] = i + 3
+    ast = ft.pop_ast(verbose=True)
+    s = ft.Schedule(ast)
+    with pytest.raises(ft.InvalidSchedule):
+        s.parallelize_as_tasks(["L1", "L3"])
+    ast_ = s.ast()  # Should not changed
+    assert ast_.match(ast)
+
+
+def test_dependence():
+    with ft.VarDef([("y1", (4,), "int32", "inout", "cpu"),
+                    ("y2", (4,), "int32", "output", "cpu")]) as (y1, y2):
+        with ft.For("i", 0, 4, label="L1") as i:
+            y1[i] = i + 1
+        with ft.For("i", 0, 4, label="L2") as i:
+            y2[i] = y1[i] * 2
+    ast = ft.pop_ast(verbose=True)
+    s = ft.Schedule(ast)
+    with pytest.raises(ft.InvalidSchedule):
+        s.parallelize_as_tasks(["L1", "L2"])
+    ast_ = s.ast()  # Should not changed
+    assert ast_.match(ast)
@@ -1,3 +1,4 @@
+import os
 import freetensor as ft
 import pytest
 import numpy as np
@@ -67,6 +68,77 @@ def test_omp_for_2():
     assert np.array_equal(y_np, y_std)
 
 
+def test_omp_for_schedule():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64,), "int32", "input", "cpu"]
+        y: ft.Var[(64,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(0, 64):
+            y[i] = 0
+            for j in range(i):
+                y[i] += x[j]
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp", schedule="guided", chunk=4, num_threads=2)
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "schedule(guided, 4)" in str(code)
+    assert "num_threads(2)" in str(code)
+    x_np = np.random.randint(0, 100, (64,)).astype("int32")
+    y_np = np.zeros((64,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    y_std = np.concatenate([[0], np.cumsum(x_np)[:-1]]).astype("int32")
+    assert np.array_equal(y_np, y_std)
+
+
+def test_omp_for_more_threads_than_default():
+    # More than the default number of OpenMP threads
+    n_threads = 2 * (os.cpu_count() or 1)
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(64, 4), "int32", "input", "cpu"]
+        y: ft.Var[(64,), "int32", "output", "cpu"]
+        #! label: L1
+        for i in range(0, 64):
+            t = ft.empty((4,), "int32", "cpu")
+            for j in range(4):
+                t[j] = x[i, j] * 2
+            y[i] = t[0] + t[1] + t[2] + t[3]
+
+    s = ft.Schedule(test)
+    s.parallelize("L1", "openmp", num_threads=n_threads)
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert f"num_threads({n_threads})" in str(code)
+    if "__threadStack" in str(code):
+        # Thread stacks are allocated for all the threads
+        assert f"std::max(omp_get_max_threads(), {n_threads})" in str(code)
+    x_np = np.random.randint(0, 100, (64, 4)).astype("int32")
+    y_np = np.zeros((64,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    assert np.array_equal(y_np, np.sum(x_np * 2, axis=1))
+
+
+def test_omp_for_negative_params():
+    with pytest.raises(ft.ffi.Error):
+        ft.ffi.OpenMPScope("default", 0, -1)
+    with pytest.raises(ft.ffi.Error):
+        ft.ffi.OpenMPScope("static", -4, 0)
+    with pytest.raises(ft.ffi.Error):
+        ft.ffi.ParallelScope("openmp(static,-4,0)")
+
+
 def test_omp_for_collapse_nested():
 
     @ft.transform
@@ -191,7 +263,7 @@ def test_vectorize_for():
     s.vectorize("L1")
     func = ft.lower(s.func(), target, verbose=1)
     code = ft.codegen(func, target, verbose=True)
-    assert "#pragma omp simd" in str(code)
+    assert "simdStore" in str(code)
     x_np = np.array([1, 2, 3, 4], dtype="int32")
     y_np = np.zeros((4,), dtype="int32")
     x_arr = ft.Array(x_np)
@@ -201,3 +273,209 @@ def test_vectorize_for():
 
     y_std = np.array([2, 3, 4, 5], dtype="int32")
     assert np.array_equal(y_np, y_std)
+
+
+@pytest.mark.parametrize('n', [16, 19, 3])
+def test_vectorize_for_with_masked_tail(n):
+    with ft.VarDef([("x", (4, n), "float32", "input", "cpu"),
+                    ("y", (4,), "float32", "input", "cpu"),
+                    ("z", (4, n), "float32", "output", "cpu")]) as (x, y, z):
+        with ft.For("i", 0, 4) as i:
+            with ft.For("j", 0, n, label="L1") as j:
+                z[i, j] = ft.max(x[i, j] * y[i] + j, 0)
+    func = ft.Func("main", ["x", "y", "z"], [], ft.pop_ast())
+
+    s = ft.Schedule(func)
+    s.vectorize("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "simdBroadcast" in str(code)
+    if n % 4 != 0:
+        assert "simdStoreMasked" in str(code)
+    x_np = np.random.uniform(-1, 1, (4, n)).astype("float32")
+    y_np = np.random.uniform(-1, 1, (4,)).astype("float32")
+    z_np = np.zeros((4, n), dtype="float32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    z_arr = ft.Array(z_np)
+    ft.Driver(func, code, ft.CPU())(x=x_arr, y=y_arr, z=z_arr)
+    z_np = z_arr.numpy()
+
+    z_std = np.maximum(x_np * y_np[:, None] + np.arange(n)[None, :], 0)
+    assert np.all(np.isclose(z_np, z_std))
+
+
+def test_vectorize_for_fallback():
+    with ft.VarDef([("x", (4, 16), "int32", "input", "cpu"),
+                    ("y", (16, 4), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            with ft.For("j", 0, 16, label="L1") as j:
+                y[j, i] = x[i, j] + 1
+    func = ft.Func("main", ["x", "y"], [], ft.pop_ast())
+
+    s = ft.Schedule(func)
+    s.vectorize("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # Non-contiguous store, left to the backend compiler
+    assert "#pragma omp simd" in str(code)
+    x_np = np.random.randint(0, 100, (4, 16)).astype("int32")
+    y_np = np.zeros((16, 4), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.Driver(func, code, ft.CPU())(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    assert np.array_equal(y_np, x_np.T + 1)
+
+
+def test_vectorize_invariant_store_fallback():
+    with ft.VarDef([("x", (4,), "int32", "input", "cpu"),
+                    ("y", (4,), "int32", "output", "cpu"),
+                    ("z", (4, 16), "int32", "output", "cpu")]) as (x, y, z):
+        with ft.For("i", 0, 4) as i:
+            with ft.For("j", 0, 16, label="L1", no_deps=["y"]) as j:
+                y[i] = x[i] * 2
+                z[i, j] = x[i] + j
+    func = ft.Func("main", ["x", "y", "z"], [], ft.pop_ast())
+
+    s = ft.Schedule(func)
+    s.vectorize("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # The store to y does not vary with the iterator
+    assert "#pragma omp simd" in str(code)
+    x_np = np.random.randint(0, 100, (4,)).astype("int32")
+    y_np = np.zeros((4,), dtype="int32")
+    z_np = np.zeros((4, 16), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    z_arr = ft.Array(z_np)
+    ft.Driver(func, code, ft.CPU())(x=x_arr, y=y_arr, z=z_arr)
+    y_np = y_arr.numpy()
+    z_np = z_arr.numpy()
+
+    assert np.array_equal(y_np, x_np * 2)
+    assert np.array_equal(z_np, x_np[:, None] + np.arange(16)[None, :])
+
+
+def test_vectorize_var_def_in_body_fallback():
+    with ft.VarDef([("x", (4, 16), "int32", "input", "cpu"),
+                    ("y", (4, 16), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            with ft.For("j", 0, 16, label="L1") as j:
+                with ft.VarDef("t", (2,), "int32", "cache", "cpu") as t:
+                    t[0] = x[i, j] + 1
+                    t[1] = x[i, j] * 2
+                    y[i, j] = t[0] * t[1] + t[0]
+    func = ft.Func("main", ["x", "y"], [], ft.pop_ast())
+
+    s = ft.Schedule(func)
+    s.vectorize("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # t is defined inside the vectorized loop
+    assert "#pragma omp simd" in str(code)
+    x_np = np.random.randint(0, 100, (4, 16)).astype("int32")
+    y_np = np.zeros((4, 16), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.Driver(func, code, ft.CPU())(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    assert np.array_equal(y_np, (x_np + 1) * (x_np * 2) + x_np + 1)
+
+
+def test_reuse_stack_memory_by_live_ranges():
+    with ft.VarDef([("x", (4, 256), "int32", "input", "cpu"),
+                    ("y", (4, 256), "int32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 4) as i:
+            with ft.VarDef("t1", (256,), "int32", "cache", "cpu") as t1:
+                with ft.VarDef("t2", (256,), "int32", "cache", "cpu") as t2:
+                    with ft.For("j", 0, 256) as j:
+                        t1[j] = x[i, j] * 2
+                    with ft.For("j", 0, 256) as j:
+                        y[i, j] = t1[255 - j] + 1
+                    with ft.For("j", 0, 256) as j:
+                        t2[j] = y[i, j] * 3
+                    with ft.For("j", 0, 256) as j:
+                        y[i, j] = t2[255 - j]
+    func = ft.Func("main", ["x", "y"], [], ft.pop_ast())
+
+    func = ft.lower(func,
+                    target,
+                    skip_passes=['prop_one_time_use', 'sink_var'],
+                    verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # t1 and t2 are never alive at the same time, so they share memory
+    assert str(code).count("&__sharedStack[0]") == 2
+    x_np = np.random.randint(0, 100, (4, 256)).astype("int32")
+    y_arr = ft.Array(np.zeros((4, 256), dtype="int32"))
+    ft.build_binary(code, device)(x=ft.Array(x_np), y=y_arr)
+
+    y_std = ((x_np[:, ::-1] * 2 + 1) * 3)[:, ::-1]
+    assert np.array_equal(y_arr.numpy(), y_std)
+
+
+def test_bounded_heap_var_in_workspace():
+    with ft.VarDef("n", (), "int32", "input", "cpu") as n:
+        with ft.VarDef([("x", (4, 256), "int32", "input", "cpu"),
+                        ("y", (4, 256), "int32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 4) as i:
+                with ft.Assert(n <= 256):
+                    with ft.VarDef("t", (n,), "int32", "cache", "cpu") as t:
+                        with ft.For("j", 0, n) as j:
+                            t[j] = x[i, j] * 2
+                        with ft.For("j", 0, n) as j:
+                            y[i, j] = t[n - 1 - j] + 1
+                    with ft.For("j", n, 256) as j:
+                        y[i, j] = 0
+    func = ft.Func("main", ["n", "x", "y"], [], ft.pop_ast())
+
+    func = ft.lower(func, target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    # t is placed in the static workspace with its maximum size, instead of
+    # being allocated on every run
+    assert "new int32_t" not in str(code)
+    assert "__sharedStack" in str(code)
+    x_np = np.random.randint(0, 100, (4, 256)).astype("int32")
+    y_arr = ft.Array(np.zeros((4, 256), dtype="int32"))
+    ft.build_binary(code, device)(n=ft.Array(np.array(200, dtype="int32")),
+                                  x=ft.Array(x_np),
+                                  y=y_arr)
+
+    y_std = np.zeros((4, 256), dtype="int32")
+    y_std[:, :200] = x_np[:, 199::-1] * 2 + 1
+    assert np.array_equal(y_arr.numpy(), y_std)
+
+
+def test_multiple_funcs_in_one_binary():
+
+    @ft.transform
+    def add(x, y):
+        x: ft.Var[(4,), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "output", "cpu"]
+        for i in range(0, 4):
+            y[i] = x[i] + 1
+
+    @ft.transform
+    def mul(x, y):
+        x: ft.Var[(4,), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "output", "cpu"]
+        for i in range(0, 4):
+            y[i] = x[i] * 2
+
+    funcs = [ft.lower(add, target, verbose=1), ft.lower(mul, target, verbose=1)]
+    code = ft.codegen(funcs, target, verbose=True)
+    add_exe, mul_exe = ft.build_binary(code, device)
+
+    x_np = np.array([1, 2, 3, 4], dtype="int32")
+    y_add = ft.Array(np.zeros((4,), dtype="int32"))
+    y_mul = ft.Array(np.zeros((4,), dtype="int32"))
+    add_exe(x=ft.Array(x_np), y=y_add)
+    mul_exe(x=ft.Array(x_np), y=y_mul)
+
+    assert np.array_equal(y_add.numpy(), np.array([2, 3, 4, 5],
+                                                  dtype="int32"))
+    assert np.array_equal(y_mul.numpy(), np.array([2, 4, 6, 8],
+                                                  dtype="int32"))
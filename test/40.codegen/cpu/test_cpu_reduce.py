@@ -617,3 +617,165 @@ def test_serial_reduction_2():
 
     y_std = np.sum(x_np, axis=1) * 2
     assert np.array_equal(y_np, y_std)
+
+
+def test_thread_pool_reduction():
+
+    @ft.transform
+    def test(x, y, z):
+        x: ft.Var[(4, 64), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "inout", "cpu"]
+        z: ft.Var[(), "int32", "inout", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            #! label: L2
+            for j in range(0, 64):
+                y[i] += x[i, j]
+                z[()] = ft.max(z[()], x[i, j])
+
+    pool_device = ft.CPU()
+    pool_target = pool_device.target()
+    pool_target.use_thread_pool = True
+    with pool_device:
+        s = ft.Schedule(test)
+        s.parallelize("L2", "openmp")
+        func = ft.lower(s.func(), pool_target, verbose=1)
+
+        code = ft.codegen(func, pool_target, verbose=True)
+        assert "threadPool().parallelFor" in str(code)
+        assert "#pragma omp parallel" not in str(code)
+        x_np = np.random.randint(0, 100, (4, 64)).astype("int32")
+        y_np = np.zeros((4,), dtype="int32")
+        z_np = np.array(0, dtype="int32")
+        x_arr = ft.Array(x_np)
+        y_arr = ft.Array(y_np)
+        z_arr = ft.Array(z_np)
+        driver = ft.build_binary(code, pool_device)
+        driver.num_threads = 2
+        driver(x=x_arr, y=y_arr, z=z_arr)
+        y_np = y_arr.numpy()
+        z_np = z_arr.numpy()
+
+    assert np.array_equal(y_np, np.sum(x_np, axis=1))
+    assert z_np[()] == np.max(x_np)
+
+
+def test_privatized_histogram():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(1 << 17,), "int32", "input", "cpu"]
+        y: ft.Var[(16,), "int32", "inout", "cpu"]
+        #! label: L
+        for i in range(1 << 17):
+            y[x[i]] += 1
+
+    s = ft.Schedule(test)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    code = ft.codegen(func, target, verbose=True)
+    assert "#pragma omp atomic" not in str(code)
+    assert "__private_" in str(code)
+    x_np = np.random.randint(0, 16, (1 << 17,)).astype("int32")
+    y_np = np.zeros((16,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    y_std = np.bincount(x_np, minlength=16)
+    assert np.array_equal(y_np, y_std)
+
+
+def test_privatized_histogram_narrow_innermost_dim():
+
+    @ft.transform
+    def test(x, y):
+        x: ft.Var[(1 << 20,), "int32", "input", "cpu"]
+        y: ft.Var[(1024, 1), "int32", "inout", "cpu"]
+        #! label: L
+        for i in range(1 << 20):
+            y[x[i], 0] += 1
+
+    s = ft.Schedule(test)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    code = ft.codegen(func, target, verbose=True)
+    # Only the slice of each thread is padded, not every row, so the private
+    # buffers still fit
+    assert "__private_" in str(code)
+    x_np = np.random.randint(0, 1024, (1 << 20,)).astype("int32")
+    y_np = np.zeros((1024, 1), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr)
+    y_np = y_arr.numpy()
+
+    y_std = np.bincount(x_np, minlength=1024).reshape(1024, 1)
+    assert np.array_equal(y_np, y_std)
+
+
+def test_privatized_loop_keeps_property():
+    with ft.VarDef([("x", (1 << 17,), "int32", "input", "cpu"),
+                    ("y", (16,), "int32", "inout", "cpu"),
+                    ("z", (1 << 17,), "int32", "output", "cpu")]) as (x, y, z):
+        with ft.For("i", 0, 1 << 17, label="L", no_deps=["z"]) as i:
+            y[x[i]] += 1
+            z[i] = x[i] * 2
+    func = ft.Func("main", ["x", "y", "z"], [], ft.pop_ast())
+
+    s = ft.Schedule(func)
+    s.parallelize("L", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    # Both the loop over threads and the chunk of each thread keep `no_deps`
+    assert "__private_" in str(func)
+    assert str(func).count("@!no_deps") == 2
+
+    code = ft.codegen(func, target, verbose=True)
+    x_np = np.random.randint(0, 16, (1 << 17,)).astype("int32")
+    y_np = np.zeros((16,), dtype="int32")
+    z_np = np.zeros((1 << 17,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    z_arr = ft.Array(z_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr, z=z_arr)
+
+    assert np.array_equal(y_arr.numpy(), np.bincount(x_np, minlength=16))
+    assert np.array_equal(z_arr.numpy(), x_np * 2)
+
+
+def test_parallel_reduction_mixed_operators():
+
+    @ft.transform
+    def test(x, y, z):
+        x: ft.Var[(4, 64), "int32", "input", "cpu"]
+        y: ft.Var[(4,), "int32", "inout", "cpu"]
+        z: ft.Var[(4,), "int32", "inout", "cpu"]
+        #! label: L1
+        for i in range(0, 4):
+            #! label: L2
+            for j in range(0, 64):
+                y[i] += x[i, j]
+                z[i] = ft.max(z[i], x[i, j])
+
+    s = ft.Schedule(test)
+    s.parallelize("L2", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+
+    code = ft.codegen(func, target, verbose=True)
+    assert "__private_" in str(code)
+    assert "atomicUpdate" not in str(code)
+    x_np = np.random.randint(0, 100, (4, 64)).astype("int32")
+    y_np = np.zeros((4,), dtype="int32")
+    z_np = np.zeros((4,), dtype="int32")
+    x_arr = ft.Array(x_np)
+    y_arr = ft.Array(y_np)
+    z_arr = ft.Array(z_np)
+    ft.build_binary(code, device)(x=x_arr, y=y_arr, z=z_arr)
+    y_np = y_arr.numpy()
+    z_np = z_arr.numpy()
+
+    assert np.array_equal(y_np, np.sum(x_np, axis=1))
+    assert np.array_equal(z_np, np.max(x_np, axis=1))
@@ -341,7 +341,7 @@ def test_in_parallel():
     func = ft.lower(s.func(), target, verbose=1)
     code = ft.codegen(func, target, verbose=True)
     assert "cblas" in str(code)
-    assert "mkl_set_num_threads_local(1)" in str(code)
+    assert "mkl_set_num_threads_local(nestedThreadBudget(" in str(code)
     a_np = np.random.uniform(size=(64, 48, 64)).astype("float32")
     b_np = np.random.uniform(size=(64, 64, 72)).astype("float32")
     c_np = np.random.uniform(size=(64, 48, 72)).astype("float32")
@@ -354,6 +354,88 @@ def test_in_parallel():
     assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
 
 
+def test_in_nested_parallel():
+
+    @ft.transform
+    def test(a, b, c, d):
+        a: ft.Var[(4, 16, 48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(4, 16, 64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(4, 16, 48, 72), "float32", "inout", "cpu"]
+        d: ft.Var[(4,), "float32", "output", "cpu"]
+        #! label: L0
+        for m in range(4):
+            # Not perfectly nested, so L0 and L1 are not collapsed
+            d[m] = 1.
+            #! label: L1
+            for n in range(16):
+                #! label: L2
+                for i in range(48):
+                    for j in range(72):
+                        for k in range(64):
+                            c[m, n, i, j] += a[m, n, i, k] * b[m, n, k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L2")
+    s.parallelize("L0", "openmp")
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "cblas" in str(code)
+    # The inner region runs with one thread, so the team of the outer one
+    # should be counted
+    assert "mkl_set_num_threads_local(nestedThreadBudget(" in str(code)
+    assert "ompTeamThreads()" in str(code)
+    a_np = np.random.uniform(size=(4, 16, 48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(4, 16, 64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(4, 16, 48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    d_arr = ft.Array(np.zeros((4,), dtype="float32"))
+    ft.Driver(func, code, ft.CPU())(a=a_arr, b=b_arr, c=c_arr, d=d_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+def test_in_parallel_thread_pool():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(2, 256, 256), "float32", "input", "cpu"]
+        b: ft.Var[(2, 256, 256), "float32", "input", "cpu"]
+        c: ft.Var[(2, 256, 256), "float32", "inout", "cpu"]
+        #! label: L1
+        for n in range(2):
+            #! label: L2
+            for i in range(256):
+                for j in range(256):
+                    for k in range(256):
+                        c[n, i, j] += a[n, i, k] * b[n, k, j]
+
+    pool_device = ft.CPU()
+    pool_target = pool_device.target()
+    pool_target.use_thread_pool = True
+    with pool_device:
+        s = ft.Schedule(test)
+        s.as_matmul("L2")
+        s.parallelize("L1", "openmp")
+        func = ft.lower(s.func(), pool_target, verbose=1)
+        code = ft.codegen(func, pool_target, verbose=True)
+        assert "threadPool().teamSize(" in str(code)
+        assert "mkl_set_num_threads_local(nestedThreadBudget(" in str(code)
+        a_np = np.random.uniform(size=(2, 256, 256)).astype("float32")
+        b_np = np.random.uniform(size=(2, 256, 256)).astype("float32")
+        c_np = np.random.uniform(size=(2, 256, 256)).astype("float32")
+        a_arr = ft.Array(a_np)
+        b_arr = ft.Array(b_np)
+        c_arr = ft.Array(c_np.copy())
+        ft.build_binary(code, pool_device)(a=a_arr, b=b_arr, c=c_arr)
+        c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
 def test_matrix_vector():
 
     @ft.transform
@@ -0,0 +1,167 @@
+import freetensor as ft
+import pytest
+import numpy as np
+
+device = ft.CPU()
+target = device.target()
+target.use_native_gemm = True
+
+
+def test_basic():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(48):
+            for j in range(72):
+                for k in range(64):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert (f"gemmBatchStrided<float, {target.vector_bytes}, false, false>"
+            in str(code))
+    assert "GEMMOpenMP" in str(code)
+    a_np = np.random.uniform(size=(48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.build_binary(code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+@pytest.mark.parametrize('dtype', ['float32', 'float64', 'int32'])
+def test_large_trans_a_trans_c(dtype):
+    # Larger than a block in each dimension, with edges
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(300, 200), dtype, "input", "cpu"]
+        b: ft.Var[(300, 500), dtype, "input", "cpu"]
+        c: ft.Var[(500, 200), dtype, "inout", "cpu"]
+        #! label: L1
+        for i in range(200):
+            for j in range(500):
+                for k in range(300):
+                    c[j, i] += a[k, i] * b[k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "gemmBatchStrided" in str(code)
+    a_np = np.random.randint(0, 10, size=(300, 200)).astype(dtype)
+    b_np = np.random.randint(0, 10, size=(300, 500)).astype(dtype)
+    c_np = np.random.randint(0, 10, size=(500, 200)).astype(dtype)
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.build_binary(code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + (a_np.T @ b_np).T))
+
+
+def test_batch_with_init():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(4, 48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(4, 72, 64), "float32", "input", "cpu"]
+        c: ft.Var[(4, 48, 72), "float32", "output", "cpu"]
+        #! label: L1
+        for n in range(4):
+            for i in range(48):
+                for j in range(72):
+                    c[n, i, j] = 0
+                    for k in range(64):
+                        c[n, i, j] += a[n, i, k] * b[n, j, k]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert (f"gemmBatchStrided<float, {target.vector_bytes}, false, true>"
+            in str(code))
+    a_np = np.random.uniform(size=(4, 48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(4, 72, 64)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(np.full((4, 48, 72), np.nan, dtype="float32"))
+    ft.build_binary(code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, a_np @ b_np.transpose(0, 2, 1)))
+
+
+def test_in_parallel():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(64, 48, 64), "float32", "input", "cpu"]
+        b: ft.Var[(64, 64, 72), "float32", "input", "cpu"]
+        c: ft.Var[(64, 48, 72), "float32", "inout", "cpu"]
+        #! label: L1
+        for n in range(64):
+            #! label: L2
+            for i in range(48):
+                for j in range(72):
+                    for k in range(64):
+                        c[n, i, j] += a[n, i, k] * b[n, k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L2")
+    s.parallelize("L1", "openmp")
+    func = ft.lower(s.func(), target, verbose=1)
+    code = ft.codegen(func, target, verbose=True)
+    assert "GEMMSerial" in str(code)
+    a_np = np.random.uniform(size=(64, 48, 64)).astype("float32")
+    b_np = np.random.uniform(size=(64, 64, 72)).astype("float32")
+    c_np = np.random.uniform(size=(64, 48, 72)).astype("float32")
+    a_arr = ft.Array(a_np)
+    b_arr = ft.Array(b_np)
+    c_arr = ft.Array(c_np.copy())
+    ft.build_binary(code, device)(a=a_arr, b=b_arr, c=c_arr)
+    c_result = c_arr.numpy()
+
+    assert np.all(np.isclose(c_result, c_np + a_np @ b_np))
+
+
+@pytest.mark.skipif(not ft.with_mkl(), reason="requires MKL")
+def test_perf_vs_mkl():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(1024, 1024), "float32", "input", "cpu"]
+        b: ft.Var[(1024, 1024), "float32", "input", "cpu"]
+        c: ft.Var[(1024, 1024), "float32", "inout", "cpu"]
+        #! label: L1
+        for i in range(1024):
+            for j in range(1024):
+                for k in range(1024):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    s = ft.Schedule(test)
+    s.as_matmul("L1")
+    a_arr = ft.Array(np.random.uniform(size=(1024, 1024)).astype("float32"))
+    b_arr = ft.Array(np.random.uniform(size=(1024, 1024)).astype("float32"))
+    c_arr = ft.Array(np.zeros((1024, 1024), dtype="float32"))
+
+    times = {}
+    for use_native in [False, True]:
+        t = device.target()
+        t.use_native_gemm = use_native
+        func = ft.lower(s.func(), t)
+        exe = ft.build_binary(ft.codegen(func, t), device)
+        exe.set_args(a=a_arr, b=b_arr, c=c_arr)
+        times["native" if use_native else "mkl"] = exe.benchmark().median()
+    print(f"MKL: {times['mkl']} ms, native: {times['native']} ms")
@@ -0,0 +1,119 @@
+import freetensor as ft
+import numpy as np
+import pytest
+import time
+
+
+def _make_samples(n, n_feat=260, seed=0):
+    rng = np.random.default_rng(seed)
+    x = rng.uniform(0, 10, (n, n_feat))
+    # Missing features are -1, as from `fixedLengthFeature`
+    x[:, n_feat // 2:][rng.uniform(size=(n, n_feat - n_feat // 2)) < 0.3] = -1
+    flops = np.exp(0.3 * x[:, 0] - 0.2 * x[:, 5] +
+                   (x[:, 7] > 5) + 0.1 * np.maximum(x[:, 200], 0)) * 1e9
+    return x.tolist(), flops.tolist()
+
+
+def _pairwise_accuracy(pred, truth):
+    pred, truth = np.array(pred), np.array(truth)
+    dp = pred[:, None] < pred[None, :]
+    dt = truth[:, None] < truth[None, :]
+    mask = np.triu(np.ones_like(dp), 1).astype(bool)
+    return (dp == dt)[mask].mean()
+
+
+def test_untrained():
+    model = ft.CostModel()
+    assert not model.trained
+    assert model.predict([[1., 2.], [3., 4.]]) == [1., 1.]
+
+
+def test_ranking():
+    train_x, train_y = _make_samples(1024)
+    test_x, test_y = _make_samples(512, seed=1)
+    model = ft.CostModel()
+    model.update(train_x, train_y)
+    assert model.trained
+    assert model.n_samples == 1024
+    assert _pairwise_accuracy(model.predict(test_x), test_y) > 0.9
+
+
+def test_ignore_invalid_samples():
+    model = ft.CostModel()
+    model.update([[1.], [2.], [3.]], [1e9, float('inf'), 0])
+    assert model.n_samples == 1
+
+
+def test_max_samples():
+    model = ft.CostModel(max_samples=100)
+    x, y = _make_samples(150, n_feat=8)
+    model.update(x[:80], y[:80])
+    model.update(x[80:], y[80:])
+    assert model.n_samples == 100
+
+
+def test_compare_with_xgboost():
+    ''' Benchmark ranking quality and latency against XGBoost '''
+
+    xgb = pytest.importorskip("xgboost")
+
+    test_x, test_y = _make_samples(512, seed=1)
+    native = ft.CostModel()
+    booster = None
+    native_time = xgb_time = 0
+    # Online updates in batches, as in auto-scheduling
+    for i in range(4):
+        x, y = _make_samples(256, seed=i + 2)
+
+        t0 = time.perf_counter()
+        native.update(x, y)
+        native_pred = native.predict(test_x)
+        t1 = time.perf_counter()
+        dtrain = xgb.DMatrix(np.array(x), np.array(y), missing=-1)
+        booster = xgb.train({}, dtrain, xgb_model=booster)
+        xgb_pred = booster.predict(xgb.DMatrix(np.array(test_x), missing=-1))
+        t2 = time.perf_counter()
+
+        native_time += t1 - t0
+        xgb_time += t2 - t1
+
+    native_acc = _pairwise_accuracy(native_pred, test_y)
+    xgb_acc = _pairwise_accuracy(xgb_pred, test_y)
+    print(f"Native: accuracy {native_acc:.3f}, time {native_time:.3f}s")
+    print(f"XGBoost: accuracy {xgb_acc:.3f}, time {xgb_time:.3f}s")
+    assert native_acc > xgb_acc - 0.05
+
+
+def test_auto_schedule_with_failed_candidates():
+
+    @ft.transform
+    def test(a, b, c):
+        a: ft.Var[(64, 64), "float32", "input", "cpu"]
+        b: ft.Var[(64, 64), "float32", "input", "cpu"]
+        c: ft.Var[(64, 64), "float32", "output", "cpu"]
+        for i in range(64):
+            for j in range(64):
+                c[i, j] = 0
+                for k in range(64):
+                    c[i, j] += a[i, k] * b[k, j]
+
+    target = ft.CPU().target()
+    s = ft.AutoSchedule(ft.Schedule(test),
+                        target,
+                        ft.CPU(),
+                        population=8,
+                        random_seed=0,
+                        rule_set={"multi_level_tiling", "parallelize"},
+                        cost_model="native")
+
+    def measure(funcs, codes, options):
+        # The first candidate fails, e.g. timed out or crashed
+        times = [float("inf")] + [1. + i for i in range(len(funcs) - 1)]
+        return times, [0.] * len(funcs)
+
+    s.set_measure_func(measure)
+    s.set_params(a=ft.Array(np.zeros((64, 64), dtype="float32")),
+                 b=ft.Array(np.zeros((64, 64), dtype="float32")),
+                 c=ft.Array(np.zeros((64, 64), dtype="float32")))
+    # Should not abort on the failed candidate
+    s.run(2)
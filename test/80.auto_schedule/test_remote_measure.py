@@ -0,0 +1,97 @@
+import freetensor as ft
+from freetensor.core.remote_measure import RemoteMeasurer
+import numpy as np
+import os
+import pytest
+import subprocess
+import sys
+import xmlrpc.client
+
+TOKEN = "test-token"
+
+
+@pytest.fixture
+def workers(monkeypatch):
+    monkeypatch.setenv("FT_REMOTE_MEASURE_TOKEN", TOKEN)
+    procs = []
+    addrs = []
+    for _ in range(2):
+        proc = subprocess.Popen([
+            sys.executable, '-m', 'freetensor.core.remote_measure', '--port',
+            '0'
+        ],
+                                stdout=subprocess.PIPE,
+                                text=True,
+                                env=dict(os.environ))
+        procs.append(proc)
+        # "Listening on <host>:<port>"
+        addrs.append(proc.stdout.readline().split()[-1])
+    yield addrs
+    for proc in procs:
+        proc.kill()
+        proc.wait()
+
+
+def _make_programs(n):
+    funcs, codes = [], []
+    for k in range(n):
+        with ft.VarDef([("x", (64,), "float32", "input", "cpu"),
+                        ("y", (64,), "float32", "output", "cpu")]) as (x, y):
+            with ft.For("i", 0, 64) as i:
+                y[i] = x[i] * k
+        func = ft.lower(ft.Func("main", ["x", "y"], [], ft.pop_ast()),
+                        ft.CPU())
+        funcs.append(func)
+        codes.append(ft.codegen(func, ft.CPU()).code)
+    return funcs, codes
+
+
+def test_measure_on_workers(workers):
+    measurer = RemoteMeasurer(workers, ft.TargetType.CPU)
+    measurer.set_params([], {
+        'x': ft.Array(np.ones((64,), dtype="float32")),
+        'y': ft.Array(np.zeros((64,), dtype="float32"))
+    })
+    funcs, codes = _make_programs(4)
+    times, stddevs = measurer(funcs, codes, ft.BenchmarkOptions())
+    assert len(times) == 4
+    assert all(0 < t < float('inf') for t in times)
+
+
+def test_drop_unreachable_worker(workers):
+    measurer = RemoteMeasurer(workers + ["127.0.0.1:1"], ft.TargetType.CPU)
+    measurer.set_params([], {
+        'x': ft.Array(np.ones((64,), dtype="float32")),
+        'y': ft.Array(np.zeros((64,), dtype="float32"))
+    })
+    assert measurer.workers == workers
+    funcs, codes = _make_programs(2)
+    times, _ = measurer(funcs, codes, ft.BenchmarkOptions())
+    assert all(0 < t < float('inf') for t in times)
+
+
+def test_reject_wrong_token(workers):
+    proxy = xmlrpc.client.ServerProxy(f"http://{workers[0]}")
+    with pytest.raises(xmlrpc.client.Fault):
+        proxy.set_params("wrong-token", "session", [], {})
+    with pytest.raises(xmlrpc.client.Fault):
+        proxy.measure("wrong-token", "session", "CPU", "", "", {})
+
+    with pytest.raises(ft.DriverError):
+        RemoteMeasurer(workers, ft.TargetType.CPU, token="")
+
+
+def test_drop_params_on_close(workers):
+    x = ft.Array(np.ones((64,), dtype="float32"))
+    y = ft.Array(np.zeros((64,), dtype="float32"))
+    funcs, codes = _make_programs(1)
+    with RemoteMeasurer(workers, ft.TargetType.CPU) as measurer:
+        measurer.set_params([], {'x': x, 'y': y})
+        session = measurer.session
+        times, _ = measurer(funcs, codes, ft.BenchmarkOptions())
+        assert 0 < times[0] < float('inf')
+
+    # The session is gone from the workers
+    proxy = xmlrpc.client.ServerProxy(f"http://{workers[0]}")
+    ret = proxy.measure(TOKEN, session, "CPU", "", "", {})
+    assert "not set" in ret['error']
@@ -0,0 +1,74 @@
+import freetensor as ft
+
+
+def _make_record(workload, time, ast):
+    record = ft.TuningRecord()
+    record.workload = workload
+    record.ast_hash = int(time * 1000)
+    record.target = "CPU"
+    record.logs = ["split(...)", "reorder(...)"]
+    record.features = [1., 2.5, -1.]
+    record.time = time
+    record.ast = ast
+    return record
+
+
+def test_append_and_reload(tmp_path):
+    path = str(tmp_path / "records.txt")
+    db = ft.TuningRecordDB(path)
+    db.append(_make_record("a", 2., "body\twith\ttabs\nand lines"))
+    db.append(_make_record("a", 1., "faster"))
+    db.append(_make_record("b", 3., "other"))
+    assert len(db) == 3
+
+    db2 = ft.TuningRecordDB(path)
+    assert len(db2) == 3
+    records = db2.query("a")
+    assert [r.time for r in records] == [1., 2.]
+    assert records[1].ast == "body\twith\ttabs\nand lines"
+    assert records[1].logs == ["split(...)", "reorder(...)"]
+    assert records[1].features == [1., 2.5, -1.]
+    assert db2.best("b").ast == "other"
+    assert db2.best("c") is None
+    assert len(db2.query("a", limit=1)) == 1
+
+
+def test_ignore_truncated_line(tmp_path):
+    path = str(tmp_path / "records.txt")
+    db = ft.TuningRecordDB(path)
+    db.append(_make_record("a", 1., "x"))
+    with open(path, "a") as f:
+        f.write("REC2\ta\t12")  # Crashed while writing
+    assert len(ft.TuningRecordDB(path)) == 1
+
+
+def _make_program():
+    with ft.VarDef([("x", (64, 64), "float32", "input", "cpu"),
+                    ("y", (64, 64), "float32", "output", "cpu")]) as (x, y):
+        with ft.For("i", 0, 64, label="Li") as i:
+            with ft.For("j", 0, 64, label="Lj") as j:
+                y[i, j] = x[i, j] + 1
+    return ft.Func("main", ["x", "y"], [], ft.pop_ast())
+
+
+def test_workload_key_stable():
+    target = ft.CPU().target()
+    key1 = ft.TuningRecordDB.workload_key(_make_program().body, target)
+    key2 = ft.TuningRecordDB.workload_key(_make_program().body, target)
+    assert key1 == key2
+
+
+def test_apply_in_auto_schedule(tmp_path):
+    target = ft.CPU().target()
+
+    # Record a schedule by hand
+    s = ft.Schedule(_make_program())
+    workload = ft.TuningRecordDB.workload_key(s.ast(), target)
+    s.split("Li", 16)
+    expected = str(s.ast())
+    db = ft.TuningRecordDB(str(tmp_path / "records.txt"))
+    db.append(_make_record(workload, 1., ft.dump_ast(s.ast())))
+
+    s = ft.Schedule(_make_program())
+    s.auto_schedule(target, db)
+    assert str(s.ast()) == expected